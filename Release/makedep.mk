@@ -111,6 +111,14 @@ src\sequencer_input.c
 src\sysex.c
 
 src\side_switch.c
+src\macros.c
+src\usb_midi.c
+src\watchdog.c
+src\profiler.c
+src\scheduler.c
+src\combos.c
+src\diagnostics.c
+src\gestures.c
 
 src\encoders.c
 
@@ -0,0 +1,434 @@
+/*
+ * config_protocol.c
+ *
+ * Created: 10/18/2026 7:48:03 PM
+ *
+ *  Builds and reads the Twister's configuration SysEx, see
+ *  config_protocol.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "config_protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYSEX_START		0xF0
+#define SYSEX_EOX		0xF7
+
+// Bulk transfer commands
+#define BULK_PUSH		0x0
+#define BULK_PULL		0x1
+
+// Pull config, request or response
+#define PULL_REQUEST	0x0
+#define PULL_RESPONSE	0x1
+
+// The header of every DJTT message, the command follows
+#define HEADER_SIZE		4
+
+// Switch MIDI type has no storage, it always reads back as 0
+#define SWITCH_MIDI_TYPE_TAG	15
+
+// Tags as send_config_data() sends them
+const config_setting_t config_global_settings[CONFIG_GLOBAL_SETTINGS] = {
+	{ 0, "midi_channel"},
+	{ 1, "side_is_banked"},
+	{ 2, "side_func_1"},
+	{ 3, "side_func_2"},
+	{ 4, "side_func_3"},
+	{ 5, "side_func_4"},
+	{ 6, "side_func_5"},
+	{ 7, "side_func_6"},
+	{ 8, "super_start"},
+	{ 9, "super_end"},
+	{31, "rgb_brightness"},
+	{32, "ind_brightness"},
+	{33, "gesture_double_tap"},
+	{34, "gesture_long_press"},
+	{35, "gesture_turn_steps"},
+	{36, "gesture_midi"},
+	{37, "fine_shift"},
+	{38, "side_repeat_delay"},
+	{39, "side_repeat_rate"},
+	{40, "gesture_channel"},
+	{41, "tap_action"},
+	{42, "tap_number"},
+	{43, "double_tap_action"},
+	{44, "double_tap_number"},
+	{45, "long_press_action"},
+	{46, "long_press_number"},
+	{47, "hold_turn_action"},
+	{48, "hold_turn_number"},
+};
+
+// Tags as sysExCmdBulkXfer() sends them, in encoder_config_t order
+const config_setting_t config_encoder_settings[CONFIG_ENCODER_SETTINGS] = {
+	{10, "has_detent"},
+	{11, "movement"},
+	{12, "switch_action_type"},
+	{13, "switch_midi_channel"},
+	{14, "switch_midi_number"},
+	{15, "switch_midi_type"},
+	{16, "encoder_midi_channel"},
+	{17, "encoder_midi_number"},
+	{18, "encoder_midi_type"},
+	{19, "active_color"},
+	{20, "inactive_color"},
+	{21, "detent_color"},
+	{22, "indicator_display_type"},
+	{23, "is_super_knob"},
+	{24, "encoder_shift_midi_channel"},
+};
+
+static size_t build_header(uint8_t command, uint8_t* message)
+{
+	message[0] = SYSEX_START;
+	message[1] = CONFIG_MFR_ID_0;
+	message[2] = CONFIG_MFR_ID_1;
+	message[3] = CONFIG_MFR_ID_2;
+	message[4] = command;
+
+	return HEADER_SIZE + 1;
+}
+
+size_t config_build_global_pull(uint8_t* message)
+{
+	size_t length = build_header(CONFIG_CMD_PULL_CONF, message);
+
+	message[length++] = PULL_REQUEST;
+	message[length++] = SYSEX_EOX;
+
+	return length;
+}
+
+/**
+ * Builds a global push. Every setting is sent, the firmware writes any it
+ * is not sent as 0.
+ */
+
+size_t config_build_global_push(const twister_config_t* config, uint8_t* message)
+{
+	size_t length = build_header(CONFIG_CMD_PUSH_CONF, message);
+
+	for (uint8_t i=0;i<CONFIG_GLOBAL_SETTINGS;++i) {
+		message[length++] = config_global_settings[i].tag;
+		message[length++] = config->global[i] & 0x7F;
+	}
+
+	message[length++] = SYSEX_EOX;
+
+	return length;
+}
+
+size_t config_build_encoder_pull(uint8_t encoder, uint8_t* message)
+{
+	size_t length = build_header(CONFIG_CMD_BULK_XFER, message);
+
+	message[length++] = BULK_PULL;
+	message[length++] = encoder + 1;
+	message[length++] = SYSEX_EOX;
+
+	return length;
+}
+
+size_t config_build_encoder_push(uint8_t encoder, const uint8_t* values, uint8_t part, uint8_t* message)
+{
+	uint8_t pairs[CONFIG_ENCODER_SETTINGS * 2];
+	uint8_t size = 0;
+
+	for (uint8_t i=0;i<CONFIG_ENCODER_SETTINGS;++i) {
+		if (values[i] < CONFIG_UNSET) {
+			pairs[size++] = config_encoder_settings[i].tag;
+			pairs[size++] = values[i];
+		}
+	}
+
+	uint8_t total = (size + CONFIG_PART_SIZE - 1) / CONFIG_PART_SIZE;
+	if (part < 1 || part > total) {
+		return 0;
+	}
+
+	uint8_t start = (part - 1) * CONFIG_PART_SIZE;
+	uint8_t part_size = size - start < CONFIG_PART_SIZE ? size - start : CONFIG_PART_SIZE;
+
+	size_t length = build_header(CONFIG_CMD_BULK_XFER, message);
+
+	message[length++] = BULK_PUSH;
+	message[length++] = encoder + 1;
+	message[length++] = part;
+	message[length++] = total;
+	message[length++] = part_size;
+	memcpy(&message[length], &pairs[start], part_size);
+	length += part_size;
+	message[length++] = SYSEX_EOX;
+
+	return length;
+}
+
+size_t config_build_system(uint8_t subcommand, uint8_t* message)
+{
+	size_t length = build_header(CONFIG_CMD_SYSTEM, message);
+
+	message[length++] = subcommand;
+	message[length++] = SYSEX_EOX;
+
+	return length;
+}
+
+static void parse_global(twister_config_t* config, const uint8_t* pairs, size_t length)
+{
+	for (size_t i=0;i + 1 < length;i += 2) {
+		for (uint8_t j=0;j<CONFIG_GLOBAL_SETTINGS;++j) {
+			if (config_global_settings[j].tag == pairs[i]) {
+				config->global[j] = pairs[i + 1];
+			}
+		}
+	}
+
+	config->has_global = true;
+}
+
+/**
+ * Takes one part of an encoder's settings. The parts of a transfer come in
+ * order, part 1 starts it again.
+ */
+
+static config_msg_t parse_encoder(twister_config_t* config, const uint8_t* data, size_t length, uint8_t* encoder)
+{
+	// TAG PART TOTAL SIZE PAYLOAD
+	if (length < 4) {
+		return config_msg_none;
+	}
+
+	uint8_t tag   = data[0];
+	uint8_t part  = data[1];
+	uint8_t total = data[2];
+	uint8_t size  = data[3];
+
+	if (tag < 1 || tag > CONFIG_ENCODERS || part < 1 || part > total || total > 8 ||
+	    size > length - 4) {
+		return config_msg_none;
+	}
+
+	uint8_t index = tag - 1;
+	uint8_t* values = config->encoder[index];
+
+	if (part == 1) {
+		config->parts[index] = 0;
+		memset(values, CONFIG_UNSET, CONFIG_ENCODER_SETTINGS);
+	}
+
+	for (uint8_t i=0;i + 1 < size;i += 2) {
+		uint8_t setting = data[4 + i] - CONFIG_ENCODER_TAG_BASE;
+		if (setting < CONFIG_ENCODER_SETTINGS) {
+			values[setting] = data[5 + i];
+		}
+	}
+
+	config->parts[index] |= 0x01 << (part - 1);
+
+	if (config->parts[index] != (uint8_t)((0x01 << total) - 1)) {
+		return config_msg_none;
+	}
+
+	config->has_encoder[index] = true;
+	*encoder = index;
+
+	return config_msg_encoder;
+}
+
+config_msg_t config_parse_message(twister_config_t* config, const uint8_t* message, size_t length, uint8_t* encoder)
+{
+	if (length < HEADER_SIZE + 2 || message[0] != SYSEX_START ||
+	    message[1] != CONFIG_MFR_ID_0 || message[2] != CONFIG_MFR_ID_1 ||
+	    message[3] != CONFIG_MFR_ID_2 || message[length - 1] != SYSEX_EOX) {
+		return config_msg_none;
+	}
+
+	const uint8_t* data = &message[HEADER_SIZE + 1];
+	size_t size = length - HEADER_SIZE - 2;
+
+	switch (message[HEADER_SIZE]) {
+		case CONFIG_CMD_PUSH_CONF:
+			parse_global(config, data, size);
+			return config_msg_global;
+
+		case CONFIG_CMD_PULL_CONF:
+			if (size && data[0] == PULL_RESPONSE) {
+				parse_global(config, data + 1, size - 1);
+				return config_msg_global;
+			}
+			break;
+
+		case CONFIG_CMD_BULK_XFER:
+			// A pull reply is sent as a push
+			if (size && data[0] == BULK_PUSH) {
+				return parse_encoder(config, data + 1, size - 1, encoder);
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return config_msg_none;
+}
+
+/**
+ * Reads a backup, or any file of configuration messages.
+ *
+ * \return false if it could not be read or held no settings
+ */
+
+bool config_read_syx(twister_config_t* config, const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		perror(path);
+		return false;
+	}
+
+	uint8_t message[256];
+	size_t length = 0;
+	bool found = false;
+	int data;
+
+	memset(config, 0, sizeof(*config));
+
+	while ((data = fgetc(file)) != EOF) {
+		if (data == SYSEX_START) {
+			length = 0;
+		} else if (!length || length == sizeof(message)) {
+			length = 0;
+			continue;
+		}
+
+		message[length++] = data;
+
+		if (data == SYSEX_EOX) {
+			uint8_t encoder;
+			found |= config_parse_message(config, message, length, &encoder) != config_msg_none;
+			length = 0;
+		}
+	}
+
+	fclose(file);
+
+	if (!found) {
+		fprintf(stderr, "%s: no Twister settings\n", path);
+	}
+
+	return found;
+}
+
+bool config_write_syx(const twister_config_t* config, const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		perror(path);
+		return false;
+	}
+
+	uint8_t message[CONFIG_MAX_MESSAGE];
+	size_t length;
+
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		if (!config->has_encoder[i]) {
+			continue;
+		}
+
+		for (uint8_t part=1;(length = config_build_encoder_push(i, config->encoder[i], part, message));++part) {
+			fwrite(message, 1, length, file);
+		}
+	}
+
+	if (config->has_global) {
+		length = config_build_global_push(config, message);
+		fwrite(message, 1, length, file);
+	}
+
+	if (fclose(file)) {
+		perror(path);
+		return false;
+	}
+
+	return true;
+}
+
+bool config_parse_target(const char* text, int* encoder)
+{
+	if (!strcmp(text, "global")) {
+		*encoder = -1;
+		return true;
+	}
+
+	bool shift = text[0] == 's';
+	char* end;
+
+	long layer = strtol(shift ? text + 1 : text, &end, 10);
+	if (*end != ':') {
+		return false;
+	}
+
+	long number = strtol(end + 1, &end, 10);
+	if (*end || number < 1 || number > 16 || layer < 1 ||
+	    layer > (shift ? CONFIG_SHIFT_PAGES : CONFIG_BANKS)) {
+		return false;
+	}
+
+	*encoder = ((shift ? CONFIG_BANKS : 0) + layer - 1) * 16 + number - 1;
+	return true;
+}
+
+void config_target_name(uint8_t encoder, char* name)
+{
+	uint8_t layer  = encoder / 16;
+	uint8_t number = encoder % 16 + 1;
+
+	if (layer < CONFIG_BANKS) {
+		snprintf(name, CONFIG_TARGET_NAME_SIZE, "%u:%u", layer + 1, number);
+	} else {
+		snprintf(name, CONFIG_TARGET_NAME_SIZE, "s%u:%u", layer - CONFIG_BANKS + 1, number);
+	}
+}
+
+int config_find_setting(const config_setting_t* settings, uint8_t count, const char* name)
+{
+	for (uint8_t i=0;i<count;++i) {
+		if (!strcmp(settings[i].name, name)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+bool config_encoder_matches(const uint8_t* pushed, const uint8_t* pulled)
+{
+	for (uint8_t i=0;i<CONFIG_ENCODER_SETTINGS;++i) {
+		if (config_encoder_settings[i].tag == SWITCH_MIDI_TYPE_TAG || pushed[i] >= CONFIG_UNSET) {
+			continue;
+		}
+		if (pushed[i] != pulled[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
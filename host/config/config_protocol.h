@@ -0,0 +1,138 @@
+/*
+ * config_protocol.h
+ *
+ * Created: 10/18/2026 7:31:26 PM
+ *
+ *  The Twister's configuration SysEx, as the firmware handles it in
+ *  config.c, for twister_config. The global settings are pushed and pulled
+ *  as one tag/value table. Each encoder is a bulk transfer tag, 1 to 64 for
+ *  the 4 banks then 65 to 96 for the 2 shift pages, and its settings a
+ *  tag/value table of up to 24 bytes a part.
+ *
+ *  A backup is kept as a .syx file of the messages which push it back, the
+ *  encoders first and the global settings last as the firmware only reloads
+ *  its settings on a global push. Captured pull replies read the same way.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef CONFIG_PROTOCOL_H_
+#define CONFIG_PROTOCOL_H_
+
+	/*	Includes: */
+
+		#include <stdbool.h>
+		#include <stddef.h>
+		#include <stdint.h>
+
+	/*	Macros: */
+
+		// DJTT manufacturer ID
+		#define CONFIG_MFR_ID_0				0x00
+		#define CONFIG_MFR_ID_1				0x01
+		#define CONFIG_MFR_ID_2				0x79
+
+		// SysEx commands, as in config.h
+		#define CONFIG_CMD_PUSH_CONF		0x1
+		#define CONFIG_CMD_PULL_CONF		0x2
+		#define CONFIG_CMD_SYSTEM			0x3
+		#define CONFIG_CMD_BULK_XFER		0x4
+
+		// sysExCmdSystem() subcommands
+		#define CONFIG_SYSTEM_BOOTLOADER	0x1
+		#define CONFIG_SYSTEM_FACTORY_RESET	0x2
+
+		// 4 banks then 2 shift pages of 16 encoders
+		#define CONFIG_BANKS				4
+		#define CONFIG_SHIFT_PAGES			2
+		#define CONFIG_ENCODERS				((CONFIG_BANKS + CONFIG_SHIFT_PAGES) * 16)
+
+		#define CONFIG_GLOBAL_SETTINGS		28
+		#define CONFIG_ENCODER_SETTINGS		15
+
+		// The first encoder setting tag
+		#define CONFIG_ENCODER_TAG_BASE		10
+
+		// Most bytes of tag/value pairs in one bulk transfer part
+		#define CONFIG_PART_SIZE			24
+
+		// An encoder setting left out of a push
+		#define CONFIG_UNSET				0x80
+
+		// Longest message built here
+		#define CONFIG_MAX_MESSAGE			64
+
+		// The text form of an encoder, "2:5" or "s1:16"
+		#define CONFIG_TARGET_NAME_SIZE		8
+
+	/*	Types: */
+
+		typedef struct {
+			uint8_t     tag;
+			const char* name;
+		} config_setting_t;
+
+		typedef enum {
+			config_msg_none = 0,
+			config_msg_global,			// The global settings
+			config_msg_encoder,			// The last part of an encoder's settings
+		} config_msg_t;
+
+		typedef struct {
+			bool    has_global;
+			uint8_t global[CONFIG_GLOBAL_SETTINGS];
+
+			bool    has_encoder[CONFIG_ENCODERS];
+			uint8_t encoder[CONFIG_ENCODERS][CONFIG_ENCODER_SETTINGS];
+
+			// Parts received of each encoder transfer in progress
+			uint8_t parts[CONFIG_ENCODERS];
+		} twister_config_t;
+
+		extern const config_setting_t config_global_settings[CONFIG_GLOBAL_SETTINGS];
+		extern const config_setting_t config_encoder_settings[CONFIG_ENCODER_SETTINGS];
+
+	/*	Function Prototypes: */
+
+		// Messages to the Twister, each returns its length
+		size_t config_build_global_pull(uint8_t* message);
+		size_t config_build_global_push(const twister_config_t* config, uint8_t* message);
+		size_t config_build_encoder_pull(uint8_t encoder, uint8_t* message);
+		size_t config_build_system(uint8_t subcommand, uint8_t* message);
+
+		// Builds part 'part' of an encoder push, settings set to
+		// CONFIG_UNSET are left out. Returns 0 past the last part
+		size_t config_build_encoder_push(uint8_t encoder, const uint8_t* values, uint8_t part, uint8_t* message);
+
+		// Takes the settings from a push or a pull reply, the encoder is
+		// set for config_msg_encoder
+		config_msg_t config_parse_message(twister_config_t* config, const uint8_t* message, size_t length, uint8_t* encoder);
+
+		bool config_read_syx(twister_config_t* config, const char* path);
+		bool config_write_syx(const twister_config_t* config, const char* path);
+
+		// "global" gives -1, "B:E" an encoder of bank B or "sP:E" one of
+		// shift page P. Returns false if not a target
+		bool config_parse_target(const char* text, int* encoder);
+		void config_target_name(uint8_t encoder, char* name);
+
+		int config_find_setting(const config_setting_t* settings, uint8_t count, const char* name);
+
+		// True if an encoder reads back as pushed, settings the firmware
+		// does not keep are skipped
+		bool config_encoder_matches(const uint8_t* pushed, const uint8_t* pulled);
+
+#endif /* CONFIG_PROTOCOL_H_ */
@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Runs twister_config against the host build of the firmware over
+# twister_sim's pseudo-terminal: backs up the factory settings, edits an
+# encoder and the globals, checks the edits read back and show up in a
+# diff, then restores the backup and checks nothing is left different.
+#
+#   loopback_test.sh TWISTER_SIM TWISTER_CONFIG
+
+set -e
+
+sim=$1
+tool=$2
+dir=$(mktemp -d)
+sim_pid=
+
+cleanup() {
+	[ -n "$sim_pid" ] && kill "$sim_pid" 2>/dev/null
+	rm -rf "$dir"
+}
+trap cleanup EXIT
+
+fail() {
+	echo "loopback: $*" >&2
+	exit 1
+}
+
+"$sim" --pty --eeprom "$dir/twister.eep" 2>"$dir/sim.log" &
+sim_pid=$!
+
+# The pseudo-terminal is named as soon as it is open
+for i in $(seq 50); do
+	port=$(sed -n 's/^sim: MIDI on //p' "$dir/sim.log")
+	[ -n "$port" ] && break
+	sleep 0.1
+done
+[ -n "$port" ] || fail "twister_sim did not open a pseudo-terminal"
+
+config() {
+	"$tool" --port "$port" "$@"
+}
+
+config backup "$dir/factory.syx"
+
+config set 2:5 encoder_midi_number=99 active_color=10
+config set s1:3 detent_color=42
+config set global rgb_brightness=50
+
+config show 2:5 | grep -qx "2:5 encoder_midi_number 99" || fail "encoder edit did not read back"
+config show global | grep -qx "global rgb_brightness 50" || fail "global edit did not read back"
+
+config backup "$dir/edited.syx"
+
+status=0
+"$tool" diff "$dir/factory.syx" "$dir/edited.syx" >"$dir/diff.txt" || status=$?
+[ "$status" -eq 1 ] || fail "diff of the edits exited with $status"
+[ "$(wc -l <"$dir/diff.txt")" -eq 4 ] || fail "diff found $(wc -l <"$dir/diff.txt") differences, not 4"
+grep -qx "s1:3 detent_color .* -> 42" "$dir/diff.txt" || fail "diff missed the shift page edit"
+
+config --window 3 restore "$dir/factory.syx"
+config diff "$dir/factory.syx" || fail "settings still differ after the restore"
+
+echo "loopback: ok"
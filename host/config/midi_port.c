@@ -0,0 +1,223 @@
+/*
+ * midi_port.c
+ *
+ * Created: 10/18/2026 7:10:51 PM
+ *
+ *  Raw MIDI port for twister_config, see midi_port.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "midi_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static int open_path(const char* path, int flags)
+{
+	int fd = open(path, flags | O_NOCTTY);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+
+	// A pseudo-terminal must pass MIDI through untouched
+	if (isatty(fd)) {
+		struct termios tio;
+		tcgetattr(fd, &tio);
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+	return fd;
+}
+
+/**
+ * Opens the MIDI port.
+ *
+ * \param port [out]	The port
+ * \param name [in]		hw:CARD,DEVICE[,SUBDEVICE] or a file, may be NULL
+ *						when in_path and out_path are both given
+ * \param in_path [in]	File to read from instead of the port, or NULL
+ * \param out_path [in]	File to write to instead of the port, or NULL
+ *
+ * \return true if the port is open both ways
+ */
+
+bool midi_port_open(midi_port_t* port, const char* name, const char* in_path, const char* out_path)
+{
+	char device[64];
+	int card;
+	int dev;
+
+	memset(port, 0, sizeof(*port));
+	port->in_fd  = -1;
+	port->out_fd = -1;
+
+	// The rawmidi subdevice, if given, is left to the driver to pick
+	if (name && sscanf(name, "hw:%d,%d", &card, &dev) == 2) {
+		snprintf(device, sizeof(device), "/dev/snd/midiC%dD%d", card, dev);
+		name = device;
+	}
+
+	if (name && (!in_path || !out_path)) {
+		int fd = open_path(name, O_RDWR);
+		if (fd < 0) {
+			return false;
+		}
+		port->in_fd  = fd;
+		port->out_fd = fd;
+	}
+
+	if (in_path) {
+		port->in_fd = open_path(in_path, O_RDONLY);
+	}
+
+	if (out_path) {
+		port->out_fd = open_path(out_path, O_WRONLY | O_CREAT | O_TRUNC);
+	}
+
+	if (port->in_fd < 0 || port->out_fd < 0) {
+		midi_port_close(port);
+		return false;
+	}
+
+	return true;
+}
+
+void midi_port_close(midi_port_t* port)
+{
+	if (port->out_fd >= 0 && port->out_fd != port->in_fd) {
+		close(port->out_fd);
+	}
+
+	if (port->in_fd >= 0) {
+		close(port->in_fd);
+	}
+
+	port->in_fd  = -1;
+	port->out_fd = -1;
+}
+
+bool midi_port_send(midi_port_t* port, const uint8_t* data, size_t length)
+{
+	while (length) {
+		ssize_t written = write(port->out_fd, data, length);
+		if (written < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+			perror("midi: write");
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+
+	return true;
+}
+
+static uint64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Adds a received byte to the SysEx message being built.
+ *
+ * \return true once a whole message has been received
+ */
+
+static bool parse_byte(midi_port_t* port, uint8_t data)
+{
+	// Real time messages may come in the middle of anything
+	if (data >= 0xF8) {
+		return false;
+	}
+
+	if (data == 0xF0) {
+		port->in_sysex = true;
+		port->sysex_length = 0;
+	} else if (!port->in_sysex) {
+		return false;
+	} else if ((data & 0x80) && data != 0xF7) {
+		// Any other status byte ends the message without completing it
+		port->in_sysex = false;
+		return false;
+	}
+
+	if (port->sysex_length == sizeof(port->sysex)) {
+		port->in_sysex = false;
+		return false;
+	}
+
+	port->sysex[port->sysex_length++] = data;
+
+	if (data == 0xF7) {
+		port->in_sysex = false;
+		return true;
+	}
+
+	return false;
+}
+
+size_t midi_port_receive_sysex(midi_port_t* port, uint8_t* message, uint32_t timeout_ms)
+{
+	uint64_t deadline = now_ms() + timeout_ms;
+
+	for (;;) {
+		while (port->buffer_start < port->buffer_end) {
+			if (parse_byte(port, port->buffer[port->buffer_start++])) {
+				memcpy(message, port->sysex, port->sysex_length);
+				return port->sysex_length;
+			}
+		}
+
+		uint64_t now = now_ms();
+		if (now >= deadline) {
+			return 0;
+		}
+
+		struct pollfd pfd = {.fd = port->in_fd, .events = POLLIN};
+		if (poll(&pfd, 1, (int)(deadline - now)) <= 0) {
+			continue;
+		}
+
+		ssize_t length = read(port->in_fd, port->buffer, sizeof(port->buffer));
+
+		if (length < 0 && errno != EAGAIN && errno != EINTR) {
+			perror("midi: read");
+			return 0;
+		}
+
+		// The end of a file never gets any more, wait out the time as for
+		// a device which has gone quiet
+		if (length == 0) {
+			usleep(1000);
+		}
+
+		port->buffer_start = 0;
+		port->buffer_end   = length > 0 ? length : 0;
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * midi_port.h
+ *
+ * Created: 10/18/2026 7:02:14 PM
+ *
+ *  Raw MIDI byte stream to and from the Twister for twister_config. The
+ *  port is an ALSA rawmidi device, given as hw:CARD,DEVICE and opened
+ *  through its /dev/snd/midiC<card>D<device> node, or any file which reads
+ *  and writes MIDI such as the pseudo-terminal of twister_sim. The input
+ *  and output may also be separate files or pipes.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef MIDI_PORT_H_
+#define MIDI_PORT_H_
+
+	/*	Includes: */
+
+		#include <stdbool.h>
+		#include <stddef.h>
+		#include <stdint.h>
+
+	/*	Macros: */
+
+		// Longest SysEx message kept, the firmware never sends more than
+		// its own receive buffer holds
+		#define MIDI_PORT_MAX_SYSEX		128
+
+	/*	Types: */
+
+		typedef struct {
+			int in_fd;
+			int out_fd;
+
+			// Read but not yet parsed
+			uint8_t buffer[256];
+			size_t  buffer_start;
+			size_t  buffer_end;
+
+			// The SysEx message being received
+			uint8_t sysex[MIDI_PORT_MAX_SYSEX];
+			size_t  sysex_length;
+			bool    in_sysex;
+		} midi_port_t;
+
+	/*	Function Prototypes: */
+
+		// Opens PORT for reading and writing, or IN and OUT if given
+		bool midi_port_open(midi_port_t* port, const char* name, const char* in_path, const char* out_path);
+		void midi_port_close(midi_port_t* port);
+
+		bool midi_port_send(midi_port_t* port, const uint8_t* data, size_t length);
+
+		// Waits up to timeout_ms for a whole SysEx message, F0 to F7, and
+		// returns its length or 0 on a timeout. Anything else on the port
+		// is skipped
+		size_t midi_port_receive_sysex(midi_port_t* port, uint8_t* message, uint32_t timeout_ms);
+
+#endif /* MIDI_PORT_H_ */
@@ -0,0 +1,637 @@
+/*
+ * twister_config.c
+ *
+ * Created: 10/18/2026 8:14:37 PM
+ *
+ *  Backs up, restores, compares and edits the settings of a Twister from
+ *  the command line, over the SysEx the configuration utility uses.
+ *
+ *  twister_config [options] COMMAND [ARGS]
+ *    backup FILE              save every setting to a .syx file
+ *    restore FILE             push a backup and check it took
+ *    diff FILE [FILE]         compare two backups, or one with the Twister
+ *    show [TARGET]            print the settings
+ *    set TARGET NAME=VALUE..  change settings
+ *    factory-reset            restore the factory settings and restart
+ *    bootloader               restart into the boot loader
+ *
+ *  A TARGET is "global", or an encoder as BANK:ENCODER, 1:1 to 4:16, or
+ *  sPAGE:ENCODER for the shift pages, s1:1 to s2:16.
+ *
+ *    -p, --port PORT      hw:CARD,DEVICE or a file such as twister_sim's
+ *                         pseudo-terminal
+ *    -i, --in FILE        read MIDI from FILE instead of the port
+ *    -o, --out FILE       write MIDI to FILE instead of the port
+ *    -w, --window N       encoders in flight at once, default 8
+ *    -t, --timeout MS     longest wait for a reply, default 2000
+ *
+ *  Rather than pacing messages with fixed delays every transfer is
+ *  acknowledged. Encoders go out a window at a time, each push followed by
+ *  a pull which the firmware only answers once it has handled the push,
+ *  and whatever does not read back as pushed is sent again. A global push
+ *  is acknowledged by the settings the firmware sends back after loading
+ *  them. The firmware only takes encoder changes on a global push, so one
+ *  always ends a restore or an encoder edit.
+ *
+ *  The exit status is 0 on success and 2 on an error. diff exits with 1
+ *  when there are differences.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_protocol.h"
+#include "midi_port.h"
+
+#define EXIT_DIFFERENT	1
+#define EXIT_ERROR		2
+
+// Times a transfer is tried before giving up
+#define TRANSFER_TRIES	3
+
+#define DEFAULT_WINDOW		8
+#define DEFAULT_TIMEOUT_MS	2000
+
+static midi_port_t port;
+static const char* port_name;
+static const char* in_path;
+static const char* out_path;
+static bool        port_open;
+
+static uint8_t  window = DEFAULT_WINDOW;
+static uint32_t timeout_ms = DEFAULT_TIMEOUT_MS;
+
+static bool open_port(void)
+{
+	if (port_open) {
+		return true;
+	}
+
+	if (!port_name && (!in_path || !out_path)) {
+		fprintf(stderr, "twister_config: no port, use --port\n");
+		return false;
+	}
+
+	port_open = midi_port_open(&port, port_name, in_path, out_path);
+	return port_open;
+}
+
+static bool send(const uint8_t* message, size_t length)
+{
+	return midi_port_send(&port, message, length);
+}
+
+/**
+ * Waits for the next configuration message from the Twister.
+ *
+ * \return config_msg_none on a timeout
+ */
+
+static config_msg_t receive(twister_config_t* config, uint8_t* encoder)
+{
+	uint8_t message[MIDI_PORT_MAX_SYSEX];
+	size_t length;
+
+	while ((length = midi_port_receive_sysex(&port, message, timeout_ms))) {
+		config_msg_t msg = config_parse_message(config, message, length, encoder);
+		if (msg != config_msg_none) {
+			return msg;
+		}
+	}
+
+	return config_msg_none;
+}
+
+static bool send_encoder_push(uint8_t encoder, const uint8_t* values)
+{
+	uint8_t message[CONFIG_MAX_MESSAGE];
+	size_t length;
+
+	for (uint8_t part=1;(length = config_build_encoder_push(encoder, values, part, message));++part) {
+		if (!send(message, length)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool send_encoder_pull(uint8_t encoder)
+{
+	uint8_t message[CONFIG_MAX_MESSAGE];
+	return send(message, config_build_encoder_pull(encoder, message));
+}
+
+/**
+ * Moves a set of encoders a window at a time. With settings to push each
+ * encoder is pushed then pulled back and compared, otherwise only pulled.
+ * An encoder not answered, or not reading back as pushed, is tried again.
+ *
+ * \param encoders [in]	The encoders to transfer
+ * \param count [in]	How many
+ * \param push [in]		Settings to push, CONFIG_UNSET to leave as it is,
+ *						or NULL to only pull
+ * \param result [out]	Settings read back
+ *
+ * \return true if every encoder was transferred
+ */
+
+static bool transfer_encoders(const uint8_t* encoders, uint8_t count, const twister_config_t* push,
+                              twister_config_t* result)
+{
+	for (uint8_t start=0;start<count;start += window) {
+		uint8_t end = start + window < count ? start + window : count;
+		bool done[CONFIG_ENCODERS] = {false};
+		uint8_t pending = end - start;
+
+		for (uint8_t attempt=0;pending && attempt<TRANSFER_TRIES;++attempt) {
+			for (uint8_t i=start;i<end;++i) {
+				uint8_t encoder = encoders[i];
+				if (done[encoder]) {
+					continue;
+				}
+				result->has_encoder[encoder] = false;
+				if ((push && !send_encoder_push(encoder, push->encoder[encoder])) ||
+				    !send_encoder_pull(encoder)) {
+					return false;
+				}
+			}
+
+			uint8_t waiting = pending;
+			uint8_t encoder;
+			config_msg_t msg;
+
+			while (waiting && (msg = receive(result, &encoder)) != config_msg_none) {
+				if (msg != config_msg_encoder || done[encoder]) {
+					continue;
+				}
+
+				// Only the window's own replies are expected, anything else
+				// is left over from an earlier attempt
+				bool in_window = false;
+				for (uint8_t i=start;i<end;++i) {
+					in_window |= encoders[i] == encoder;
+				}
+				if (!in_window) {
+					continue;
+				}
+
+				waiting--;
+				if (!push || config_encoder_matches(push->encoder[encoder], result->encoder[encoder])) {
+					done[encoder] = true;
+					pending--;
+				}
+			}
+		}
+
+		if (pending) {
+			for (uint8_t i=start;i<end;++i) {
+				if (!done[encoders[i]]) {
+					char name[CONFIG_TARGET_NAME_SIZE];
+					config_target_name(encoders[i], name);
+					fprintf(stderr, "twister_config: encoder %s %s\n", name,
+					        result->has_encoder[encoders[i]] ? "did not take the settings" : "did not answer");
+				}
+			}
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool pull_global(twister_config_t* config)
+{
+	uint8_t message[CONFIG_MAX_MESSAGE];
+	size_t length = config_build_global_pull(message);
+
+	for (uint8_t attempt=0;attempt<TRANSFER_TRIES;++attempt) {
+		if (!send(message, length)) {
+			return false;
+		}
+
+		uint8_t encoder;
+		config_msg_t msg;
+		while ((msg = receive(config, &encoder)) != config_msg_none) {
+			if (msg == config_msg_global) {
+				return true;
+			}
+		}
+	}
+
+	fprintf(stderr, "twister_config: no reply to the global settings request\n");
+	return false;
+}
+
+/**
+ * Pushes the global settings, which also has the firmware reload every
+ * setting, and checks the settings it sends back.
+ */
+
+static bool push_global(const twister_config_t* config)
+{
+	uint8_t message[CONFIG_MAX_MESSAGE];
+	size_t length = config_build_global_push(config, message);
+
+	for (uint8_t attempt=0;attempt<TRANSFER_TRIES;++attempt) {
+		if (!send(message, length)) {
+			return false;
+		}
+
+		twister_config_t reply = {0};
+		uint8_t encoder;
+		config_msg_t msg;
+
+		while ((msg = receive(&reply, &encoder)) != config_msg_none) {
+			if (msg != config_msg_global) {
+				continue;
+			}
+
+			bool matches = true;
+			for (uint8_t i=0;i<CONFIG_GLOBAL_SETTINGS;++i) {
+				if (reply.global[i] != config->global[i]) {
+					fprintf(stderr, "twister_config: global %s reads back as %u, not %u\n",
+					        config_global_settings[i].name, reply.global[i], config->global[i]);
+					matches = false;
+				}
+			}
+			return matches;
+		}
+	}
+
+	fprintf(stderr, "twister_config: no reply to the global settings push\n");
+	return false;
+}
+
+static bool pull_all(twister_config_t* config)
+{
+	uint8_t encoders[CONFIG_ENCODERS];
+
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		encoders[i] = i;
+	}
+
+	memset(config, 0, sizeof(*config));
+
+	return pull_global(config) && transfer_encoders(encoders, CONFIG_ENCODERS, NULL, config);
+}
+
+static void print_settings(const char* target, const config_setting_t* settings, uint8_t count,
+                           const uint8_t* values)
+{
+	for (uint8_t i=0;i<count;++i) {
+		if (values[i] < CONFIG_UNSET) {
+			printf("%s %s %u\n", target, settings[i].name, values[i]);
+		}
+	}
+}
+
+static void print_config(const twister_config_t* config, int target)
+{
+	if (config->has_global && (target < 0 || target == CONFIG_ENCODERS)) {
+		print_settings("global", config_global_settings, CONFIG_GLOBAL_SETTINGS, config->global);
+	}
+
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		if (config->has_encoder[i] && (target == CONFIG_ENCODERS || target == i)) {
+			char name[CONFIG_TARGET_NAME_SIZE];
+			config_target_name(i, name);
+			print_settings(name, config_encoder_settings, CONFIG_ENCODER_SETTINGS, config->encoder[i]);
+		}
+	}
+}
+
+/**
+ * Prints the settings which differ, as TARGET NAME OLD -> NEW.
+ *
+ * \return the number of differences
+ */
+
+static int diff_settings(const char* target, const config_setting_t* settings, uint8_t count,
+                         const uint8_t* a, const uint8_t* b)
+{
+	int differences = 0;
+
+	for (uint8_t i=0;i<count;++i) {
+		if (a[i] < CONFIG_UNSET && b[i] < CONFIG_UNSET && a[i] != b[i]) {
+			printf("%s %s %u -> %u\n", target, settings[i].name, a[i], b[i]);
+			differences++;
+		}
+	}
+
+	return differences;
+}
+
+static int diff_config(const twister_config_t* a, const twister_config_t* b)
+{
+	int differences = 0;
+
+	if (a->has_global != b->has_global) {
+		printf("global %s\n", a->has_global ? "removed" : "added");
+		differences++;
+	} else if (a->has_global) {
+		differences += diff_settings("global", config_global_settings, CONFIG_GLOBAL_SETTINGS,
+		                             a->global, b->global);
+	}
+
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		char name[CONFIG_TARGET_NAME_SIZE];
+		config_target_name(i, name);
+
+		if (a->has_encoder[i] != b->has_encoder[i]) {
+			printf("%s %s\n", name, a->has_encoder[i] ? "removed" : "added");
+			differences++;
+		} else if (a->has_encoder[i]) {
+			differences += diff_settings(name, config_encoder_settings, CONFIG_ENCODER_SETTINGS,
+			                             a->encoder[i], b->encoder[i]);
+		}
+	}
+
+	return differences;
+}
+
+static int command_backup(int argc, char* argv[])
+{
+	static twister_config_t config;
+
+	if (argc != 1) {
+		return -1;
+	}
+
+	if (!open_port() || !pull_all(&config) || !config_write_syx(&config, argv[0])) {
+		return EXIT_ERROR;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static int command_restore(int argc, char* argv[])
+{
+	static twister_config_t config;
+	static twister_config_t result;
+
+	if (argc != 1) {
+		return -1;
+	}
+
+	if (!config_read_syx(&config, argv[0]) || !open_port()) {
+		return EXIT_ERROR;
+	}
+
+	uint8_t encoders[CONFIG_ENCODERS];
+	uint8_t count = 0;
+
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		if (config.has_encoder[i]) {
+			encoders[count++] = i;
+		}
+	}
+
+	// Even after a failure the global push brings the display back, the
+	// firmware turns it off for the length of a bulk transfer
+	bool ok = transfer_encoders(encoders, count, &config, &result);
+
+	// A backup without the global settings still needs a global push for
+	// the firmware to take the encoders
+	if (!config.has_global && !pull_global(&config)) {
+		return EXIT_ERROR;
+	}
+
+	return push_global(&config) && ok ? EXIT_SUCCESS : EXIT_ERROR;
+}
+
+static int command_diff(int argc, char* argv[])
+{
+	static twister_config_t a;
+	static twister_config_t b;
+
+	if (argc < 1 || argc > 2) {
+		return -1;
+	}
+
+	if (!config_read_syx(&a, argv[0])) {
+		return EXIT_ERROR;
+	}
+
+	if (argc == 2) {
+		if (!config_read_syx(&b, argv[1])) {
+			return EXIT_ERROR;
+		}
+	} else if (!open_port() || !pull_all(&b)) {
+		return EXIT_ERROR;
+	}
+
+	return diff_config(&a, &b) ? EXIT_DIFFERENT : EXIT_SUCCESS;
+}
+
+static int command_show(int argc, char* argv[])
+{
+	static twister_config_t config;
+	int target = CONFIG_ENCODERS;
+
+	if (argc > 1 || (argc == 1 && !config_parse_target(argv[0], &target))) {
+		return -1;
+	}
+
+	if (!open_port()) {
+		return EXIT_ERROR;
+	}
+
+	if (target < 0) {
+		if (!pull_global(&config)) {
+			return EXIT_ERROR;
+		}
+	} else if (target < CONFIG_ENCODERS) {
+		uint8_t encoder = target;
+		if (!transfer_encoders(&encoder, 1, NULL, &config)) {
+			return EXIT_ERROR;
+		}
+	} else if (!pull_all(&config)) {
+		return EXIT_ERROR;
+	}
+
+	print_config(&config, target);
+	return EXIT_SUCCESS;
+}
+
+static int command_set(int argc, char* argv[])
+{
+	static twister_config_t config;
+	static twister_config_t result;
+	int target;
+
+	if (argc < 2 || !config_parse_target(argv[0], &target)) {
+		return -1;
+	}
+
+	const config_setting_t* settings = target < 0 ? config_global_settings : config_encoder_settings;
+	uint8_t count = target < 0 ? CONFIG_GLOBAL_SETTINGS : CONFIG_ENCODER_SETTINGS;
+	uint8_t values[CONFIG_GLOBAL_SETTINGS];
+
+	memset(values, CONFIG_UNSET, sizeof(values));
+
+	for (int i=1;i<argc;++i) {
+		char name[64];
+		unsigned value;
+		int setting;
+
+		if (sscanf(argv[i], "%63[^=]=%u", name, &value) != 2 ||
+		    (setting = config_find_setting(settings, count, name)) < 0 || value > 0x7F) {
+			fprintf(stderr, "twister_config: bad setting %s\n", argv[i]);
+			return EXIT_ERROR;
+		}
+
+		values[setting] = value;
+	}
+
+	if (!open_port() || !pull_global(&config)) {
+		return EXIT_ERROR;
+	}
+
+	bool ok = true;
+
+	if (target >= 0) {
+		uint8_t encoder = target;
+		memcpy(config.encoder[encoder], values, CONFIG_ENCODER_SETTINGS);
+
+		// The global push still follows a failure, as in a restore
+		ok = transfer_encoders(&encoder, 1, &config, &result);
+	} else {
+		for (uint8_t i=0;i<CONFIG_GLOBAL_SETTINGS;++i) {
+			if (values[i] < CONFIG_UNSET) {
+				config.global[i] = values[i];
+			}
+		}
+	}
+
+	return push_global(&config) && ok ? EXIT_SUCCESS : EXIT_ERROR;
+}
+
+static int command_system(uint8_t subcommand, int argc)
+{
+	uint8_t message[CONFIG_MAX_MESSAGE];
+
+	if (argc) {
+		return -1;
+	}
+
+	if (!open_port() || !send(message, config_build_system(subcommand, message))) {
+		return EXIT_ERROR;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options] COMMAND [ARGS]\n"
+	        "  backup FILE              save every setting to a .syx file\n"
+	        "  restore FILE             push a backup and check it took\n"
+	        "  diff FILE [FILE]         compare two backups, or one with the Twister\n"
+	        "  show [TARGET]            print the settings\n"
+	        "  set TARGET NAME=VALUE..  change settings\n"
+	        "  factory-reset            restore the factory settings and restart\n"
+	        "  bootloader               restart into the boot loader\n"
+	        "TARGET is global, BANK:ENCODER (1:1 to 4:16) or sPAGE:ENCODER (s1:1 to s2:16)\n"
+	        "  -p, --port PORT      hw:CARD,DEVICE or a file\n"
+	        "  -i, --in FILE        read MIDI from FILE instead of the port\n"
+	        "  -o, --out FILE       write MIDI to FILE instead of the port\n"
+	        "  -w, --window N       encoders in flight at once, default %u\n"
+	        "  -t, --timeout MS     longest wait for a reply, default %u\n",
+	        name, DEFAULT_WINDOW, DEFAULT_TIMEOUT_MS);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option options[] = {
+		{"port",    required_argument, NULL, 'p'},
+		{"in",      required_argument, NULL, 'i'},
+		{"out",     required_argument, NULL, 'o'},
+		{"window",  required_argument, NULL, 'w'},
+		{"timeout", required_argument, NULL, 't'},
+		{"help",    no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "+p:i:o:w:t:h", options, NULL)) != -1) {
+		switch (opt) {
+			case 'p':
+				port_name = optarg;
+				break;
+			case 'i':
+				in_path = optarg;
+				break;
+			case 'o':
+				out_path = optarg;
+				break;
+			case 'w':
+				window = strtoul(optarg, NULL, 0);
+				break;
+			case 't':
+				timeout_ms = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? EXIT_SUCCESS : EXIT_ERROR;
+		}
+	}
+
+	if (optind == argc || !window) {
+		usage(argv[0]);
+		return EXIT_ERROR;
+	}
+
+	const char* command = argv[optind];
+	int args = argc - optind - 1;
+	char** arg = &argv[optind + 1];
+	int result;
+
+	if (!strcmp(command, "backup")) {
+		result = command_backup(args, arg);
+	} else if (!strcmp(command, "restore")) {
+		result = command_restore(args, arg);
+	} else if (!strcmp(command, "diff")) {
+		result = command_diff(args, arg);
+	} else if (!strcmp(command, "show")) {
+		result = command_show(args, arg);
+	} else if (!strcmp(command, "set")) {
+		result = command_set(args, arg);
+	} else if (!strcmp(command, "factory-reset")) {
+		result = command_system(CONFIG_SYSTEM_FACTORY_RESET, args);
+	} else if (!strcmp(command, "bootloader")) {
+		result = command_system(CONFIG_SYSTEM_BOOTLOADER, args);
+	} else {
+		result = -1;
+	}
+
+	if (port_open) {
+		midi_port_close(&port);
+	}
+
+	if (result < 0) {
+		usage(argv[0]);
+		return EXIT_ERROR;
+	}
+
+	return result;
+}
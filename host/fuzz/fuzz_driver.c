@@ -0,0 +1,112 @@
+/*
+ * fuzz_driver.c
+ *
+ * Created: 10/18/2026 5:02:37 PM
+ *
+ *  Runs a fuzz harness without libFuzzer, for AFL and for replaying the
+ *  corpus and crash reproducers from ctest with any compiler.
+ *
+ *  fuzz_<harness>_run [FILE|DIR]...
+ *
+ *  Each file, and each file in a directory, is one input. With no arguments
+ *  one input is read from stdin, which is how AFL runs it.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "fuzz_firmware.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+// Larger than any message the firmware can take
+#define FUZZ_MAX_INPUT	65536
+
+static uint8_t input[FUZZ_MAX_INPUT];
+
+static size_t read_input(FILE* file)
+{
+	return fread(input, 1, sizeof(input), file);
+}
+
+static int run_file(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		perror(path);
+		return 1;
+	}
+
+	size_t size = read_input(file);
+	fclose(file);
+
+	fprintf(stderr, "%s: %zu bytes\n", path, size);
+	LLVMFuzzerTestOneInput(input, size);
+	return 0;
+}
+
+static int run_path(const char* path)
+{
+	struct stat st;
+
+	if (stat(path, &st)) {
+		perror(path);
+		return 1;
+	}
+
+	if (!S_ISDIR(st.st_mode)) {
+		return run_file(path);
+	}
+
+	struct dirent** entries;
+	int count = scandir(path, &entries, NULL, alphasort);
+	if (count < 0) {
+		perror(path);
+		return 1;
+	}
+
+	int errors = 0;
+	for (int i=0;i<count;++i) {
+		if (entries[i]->d_name[0] != '.') {
+			char name[4096];
+			snprintf(name, sizeof(name), "%s/%s", path, entries[i]->d_name);
+			errors += run_file(name);
+		}
+		free(entries[i]);
+	}
+	free(entries);
+
+	return errors;
+}
+
+int main(int argc, char* argv[])
+{
+	LLVMFuzzerInitialize(&argc, &argv);
+
+	if (argc < 2) {
+		LLVMFuzzerTestOneInput(input, read_input(stdin));
+		return 0;
+	}
+
+	int errors = 0;
+	for (int i=1;i<argc;++i) {
+		errors += run_path(argv[i]);
+	}
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * fuzz_firmware.c
+ *
+ * Created: 10/18/2026 4:20:13 PM
+ *
+ *  Boots the firmware for each fuzz input and feeds it MIDI. A reset of the
+ *  MCU, such as the one after a SysEx factory reset, jumps back here and
+ *  ends the input.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "fuzz_firmware.h"
+
+#include <setjmp.h>
+
+#include "config.h"
+#include "display_driver.h"
+#include "input.h"
+#include "midi.h"
+#include "encoders.h"
+#include "side_switch.h"
+#include "sequencer.h"
+#include "sequencer_display.h"
+#include "watchdog.h"
+
+// main.c
+void system_init(void);
+
+// sysex.c, the state of the SysEx reassembly
+extern bool sysex_is_reading;
+
+static uint8_t factory_eeprom[EEPROM_SIZE];
+static bool    booted;
+
+static jmp_buf reset_jump;
+static bool    was_reset;
+
+static void on_reset(uint8_t cause)
+{
+	UNUSED(cause);
+	longjmp(reset_jump, 1);
+}
+
+/**
+ * Runs the start up of main() as far as its main loop, then enumerates so
+ * the MIDI output has somewhere to go.
+ */
+
+static void boot(void)
+{
+	sim_set_reset_cause(CHIP_RESET_CAUSE_POR);
+
+	watchdog_init();
+
+	system_init();
+	config_init();
+	load_config();
+
+	input_init();
+	midi_init();
+	encoders_init();
+	side_switch_init();
+	gestures_init();
+	combos_init();
+	macros_init();
+	display_init();
+	sequencer_init();
+
+	display_disable();
+	clear_display_buffer();
+
+	// A SysEx message can arrive part way through the last one
+	sysex_is_reading = false;
+
+	// USB_Init() has just detached, the host enumerates on the next frame
+	sim_advance(SIM_CYCLES_PER_MS);
+	USB_USBTask();
+}
+
+int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	UNUSED(argc);
+	UNUSED(argv);
+
+	sim_eeprom_open(NULL);
+	usb_sim_set_attach_ms(1);
+	sim_set_reset_hook(on_reset);
+
+	// The first boot finds the EEPROM erased and writes the factory settings
+	boot();
+	memcpy(factory_eeprom, sim_eeprom_data(), sizeof(factory_eeprom));
+	booted = true;
+
+	return 0;
+}
+
+void fuzz_begin(void)
+{
+	if (!booted) {
+		LLVMFuzzerInitialize(NULL, NULL);
+	}
+
+	memcpy(sim_eeprom_data(), factory_eeprom, sizeof(factory_eeprom));
+	was_reset = false;
+
+	boot();
+}
+
+bool fuzz_packet(uint8_t event, uint8_t data1, uint8_t data2, uint8_t data3)
+{
+	if (was_reset) {
+		return false;
+	}
+
+	if (setjmp(reset_jump)) {
+		was_reset = true;
+		return false;
+	}
+
+	MIDI_EventPacket_t packet = {
+		.Event = event,
+		.Data1 = data1,
+		.Data2 = data2,
+		.Data3 = data3,
+	};
+
+	// As the main loop does for received USB MIDI
+	PMIC.CTRL &= ~(PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm);
+	process_midi_packet(packet);
+	PMIC.CTRL = PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm | PMIC_HILVLEN_bm;
+
+	return true;
+}
+
+void fuzz_end(void)
+{
+	if (was_reset) {
+		return;
+	}
+
+	if (setjmp(reset_jump)) {
+		was_reset = true;
+		return;
+	}
+
+	commit_combos();
+	commit_side_switch_layers();
+	commit_macros();
+
+	// Draw what the input changed, as the display task does over 16 passes
+	if (get_op_mode() == sequencer) {
+		run_sequencer_display();
+	} else {
+		for (uint8_t i=0;i<16;++i) {
+			update_encoder_display();
+		}
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ * fuzz_firmware.h
+ *
+ * Created: 10/18/2026 4:12:40 PM
+ *
+ *  Common set up for the fuzz harnesses. The firmware is started on the
+ *  simulated hardware as far as its main loop, with an in memory EEPROM and
+ *  the MIDI output thrown away, then each input is fed to the MIDI receive
+ *  path the way the main loop does it. Every input starts from the same
+ *  EEPROM and a freshly initialized firmware so a crash can be reproduced
+ *  from its input alone.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef FUZZ_FIRMWARE_H_
+#define FUZZ_FIRMWARE_H_
+
+	/*	Includes: */
+
+		#include "hal_sim.h"
+
+	/*	Function Prototypes: */
+
+		// libFuzzer entry points, also called by fuzz_driver.c
+		int LLVMFuzzerInitialize(int* argc, char*** argv);
+		int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+		// Starts each input from the factory EEPROM and a fresh firmware
+		void fuzz_begin(void);
+
+		// Hands one USB-MIDI event packet to the firmware, the header byte
+		// as received. Returns false if it reset the MCU, after which the
+		// rest of the input is dropped
+		bool fuzz_packet(uint8_t event, uint8_t data1, uint8_t data2, uint8_t data3);
+
+		// Runs the main loop's EEPROM task to write out what the input set,
+		// then draws the display
+		void fuzz_end(void);
+
+#endif /* FUZZ_FIRMWARE_H_ */
@@ -0,0 +1,102 @@
+/*
+ * fuzz_sysex.c
+ *
+ * Created: 10/18/2026 4:47:05 PM
+ *
+ *  Fuzzes the DJTT SysEx command handlers. The input is a series of
+ *  message bodies, each ended by 0xF7. Every body is sent as
+ *
+ *    F0 00 01 79 <body> F7
+ *
+ *  split into USB-MIDI packets the way midi_stream_sysex() does it, so the
+ *  first byte of a body is the command. Body bytes are not masked to 7 bits
+ *  as nothing stops a host from sending them. A multi part transfer is a
+ *  series of bodies in one input.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "fuzz_firmware.h"
+
+#include "midi.h"
+
+#define SYSEX_EOX		0xF7
+
+/**
+ * Sends one DJTT SysEx message.
+ *
+ * \return	false if the firmware reset the MCU
+ */
+
+static bool send_message(const uint8_t* body, size_t length)
+{
+	uint8_t message[MIDI_MAX_SYSEX * 2];
+	size_t size = 0;
+
+	message[size++] = 0xF0;
+	message[size++] = MIDI_MFR_ID_0;
+	message[size++] = MIDI_MFR_ID_1;
+	message[size++] = MIDI_MFR_ID_2;
+
+	// Longer than the firmware can take is still worth sending, it must
+	// be dropped
+	if (length > sizeof(message) - 5) {
+		length = sizeof(message) - 5;
+	}
+	memcpy(&message[size], body, length);
+	size += length;
+
+	message[size++] = SYSEX_EOX;
+
+	const uint8_t* data = message;
+	while (size > 3) {
+		if (!fuzz_packet(0x04, data[0], data[1], data[2])) {
+			return false;
+		}
+		data += 3;
+		size -= 3;
+	}
+
+	// 1, 2 or 3 byte end
+	switch (size) {
+		case 1:
+			return fuzz_packet(0x05, data[0], 0, 0);
+		case 2:
+			return fuzz_packet(0x06, data[0], data[1], 0);
+		default:
+			return fuzz_packet(0x07, data[0], data[1], data[2]);
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	fuzz_begin();
+
+	size_t start = 0;
+	for (size_t i=0;i <= size;++i) {
+		// The last body may be left open
+		if (i == size ? i > start : data[i] == SYSEX_EOX) {
+			if (!send_message(&data[start], i - start)) {
+				break;
+			}
+			start = i + 1;
+		}
+	}
+
+	fuzz_end();
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * fuzz_usb_midi.c
+ *
+ * Created: 10/18/2026 4:41:52 PM
+ *
+ *  Fuzzes process_midi_packet() with USB-MIDI event packets as the host
+ *  would send them. Every 4 bytes of the input is one packet, header byte
+ *  first, a short tail is dropped. This covers the note and CC handling as
+ *  well as the SysEx reassembly, fuzz_sysex.c goes deeper into the SysEx
+ *  command handlers.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "fuzz_firmware.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	fuzz_begin();
+
+	for (size_t i=0;i + 4 <= size;i += 4) {
+		if (!fuzz_packet(data[i], data[i + 1], data[i + 2], data[i + 3])) {
+			break;
+		}
+	}
+
+	fuzz_end();
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * golden.c
+ *
+ * Created: 10/18/2026 10:58:04 PM
+ *
+ *  Golden output tests for the encoder and MIDI paths. Each scenario, see
+ *  scenario.h, is played into a freshly booted firmware on the simulated
+ *  hardware and the MIDI it sends is compared with the NAME.golden file
+ *  next to the scenario script. A scenario sets up the encoders it turns,
+ *  so a change to how any setting is handled shows up as a difference in
+ *  the messages sent for it.
+ *
+ *  A golden file holds one message a line, the time in mS from the first
+ *  step then the bytes in hex, a SysEx on one line. Lines match when the
+ *  bytes are the same and the times no further apart than --slack, so
+ *  work which only moves when the firmware gets round to sending does not
+ *  fail the test. On a failure the lines which differ are listed, - for
+ *  the golden file and + for this run.
+ *
+ *  twister_golden [options] SCENARIO...
+ *    -u, --update            write the golden files from this run
+ *    -s, --slack MS          time two matching messages may be apart,
+ *                            default 2
+ *
+ *  The exit status is 1 if any scenario's output differs.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+#include "golden_file.h"
+#include "../scenario/scenario.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Boot, enumeration and the start up animation are over by then
+#define WARM_UP_MS			1000
+
+typedef struct {
+	bool     update;
+	uint32_t slack_ms;
+} golden_options_t;
+
+static golden_options_t options = {
+	.slack_ms = 2,
+};
+
+static const scenario_t* child_scenario;
+static FILE*             child_output;
+
+static void on_message(uint64_t time_us, const uint8_t* data, uint16_t length)
+{
+	golden_print(child_output, time_us, data, length);
+}
+
+static void on_done(void)
+{
+	sim_exit(SIM_EXIT_OK);
+}
+
+static void start_scenario(void)
+{
+	scenario_play(child_scenario, NULL, on_message, on_done);
+}
+
+/**
+ * Plays a scenario on a firmware of its own, so nothing is left over from
+ * the one before. The MIDI is written to the given file.
+ *
+ * \return true if the firmware ran it through
+ */
+
+static bool run_scenario(const scenario_t* scenario, FILE* output)
+{
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("golden");
+		return false;
+	}
+
+	if (!pid) {
+		child_scenario = scenario;
+		child_output   = output;
+
+		sim_eeprom_open(NULL);
+		sim_schedule((uint64_t)WARM_UP_MS * SIM_CYCLES_PER_MS, start_scenario);
+		firmware_main();
+		exit(SIM_EXIT_ERROR);
+	}
+
+	int status;
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("golden");
+		return false;
+	}
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != SIM_EXIT_OK) {
+		fprintf(stderr, "%s: the firmware stopped before the end\n", scenario->name);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Runs one scenario and checks or writes its golden file.
+ *
+ * \return true if it ran and matched, or its golden file was written
+ */
+
+static bool test_scenario(const char* script)
+{
+	scenario_t* scenario = malloc(sizeof(scenario_t));
+	if (!scenario || !scenario_read(scenario, script)) {
+		free(scenario);
+		return false;
+	}
+
+	char path[512];
+	golden_path(script, path, sizeof(path));
+
+	FILE* output = tmpfile();
+	bool ok = output && run_scenario(scenario, output);
+
+	if (ok) {
+		rewind(output);
+
+		if (options.update) {
+			char comment[128];
+			snprintf(comment, sizeof(comment),
+			         "twister_golden %s: mS from the first step, then the MIDI sent", scenario->name);
+
+			ok = golden_write(path, comment, output);
+			if (ok) {
+				printf("%s: wrote %s\n", scenario->name, path);
+			}
+		} else {
+			ok = golden_check(scenario->name, path, output, options.slack_ms);
+		}
+	}
+
+	if (output) {
+		fclose(output);
+	}
+	scenario_free(scenario);
+	free(scenario);
+	return ok;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options] SCENARIO...\n"
+	        "  -u, --update            write the golden files from this run\n"
+	        "  -s, --slack MS          time two matching messages may be apart\n",
+	        name);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option long_options[] = {
+		{"update", no_argument,       NULL, 'u'},
+		{"slack",  required_argument, NULL, 's'},
+		{"help",   no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "us:h", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'u':
+				options.update = true;
+				break;
+			case 's':
+				options.slack_ms = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? SIM_EXIT_OK : SIM_EXIT_ERROR;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return SIM_EXIT_ERROR;
+	}
+
+	int status = SIM_EXIT_OK;
+
+	for (int i=optind;i<argc;++i) {
+		if (!test_scenario(argv[i])) {
+			status = SIM_EXIT_ERROR;
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,259 @@
+/*
+ * golden_file.c
+ *
+ * Created: 10/18/2026 1:44:51 PM
+ *
+ *  Reading, writing and comparing golden MIDI output files, see
+ *  golden_file.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "golden_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Longest line of a golden file, a 256 byte SysEx and its time
+#define MAX_LINE			800
+
+// Lines listed of one output's differences
+#define MAX_DIFF_LINES		40
+
+// Largest table the diff of the differing middle of two outputs builds,
+// past that it lists both middles whole
+#define MAX_DIFF_CELLS		(4UL * 1024 * 1024)
+
+typedef struct {
+	uint32_t ms;
+	char*    bytes;			// Hex, space separated
+} golden_line_t;
+
+typedef struct {
+	golden_line_t* lines;
+	uint32_t       count;
+	uint32_t       capacity;
+} golden_t;
+
+void golden_print(FILE* output, uint64_t time_us, const uint8_t* data, uint16_t length)
+{
+	fprintf(output, "%llu", (unsigned long long)(time_us / 1000));
+	for (uint16_t i=0;i<length;++i) {
+		fprintf(output, " %02X", data[i]);
+	}
+	fputc('\n', output);
+}
+
+static void add_line(golden_t* golden, uint32_t ms, const char* bytes)
+{
+	if (golden->count == golden->capacity) {
+		golden->capacity = golden->capacity ? golden->capacity * 2 : 256;
+		golden->lines = realloc(golden->lines, golden->capacity * sizeof(golden_line_t));
+		if (!golden->lines) {
+			perror("golden_file");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	golden_line_t* line = &golden->lines[golden->count++];
+	line->ms    = ms;
+	line->bytes = strdup(bytes);
+}
+
+/**
+ * Reads MIDI lines, # starts a comment.
+ */
+
+static void read_golden(golden_t* golden, FILE* file)
+{
+	char line[MAX_LINE];
+	unsigned long ms;
+	int used;
+
+	while (fgets(line, sizeof(line), file)) {
+		line[strcspn(line, "#\r\n")] = '\0';
+		if (sscanf(line, "%lu %n", &ms, &used) == 1) {
+			add_line(golden, ms, line + used);
+		}
+	}
+}
+
+static void free_golden(golden_t* golden)
+{
+	for (uint32_t i=0;i<golden->count;++i) {
+		free(golden->lines[i].bytes);
+	}
+	free(golden->lines);
+	memset(golden, 0x00, sizeof(golden_t));
+}
+
+static bool lines_match(const golden_line_t* a, const golden_line_t* b, uint32_t slack_ms)
+{
+	uint32_t apart = a->ms > b->ms ? a->ms - b->ms : b->ms - a->ms;
+	return apart <= slack_ms && !strcmp(a->bytes, b->bytes);
+}
+
+static uint32_t diff_lines_shown;
+
+static void show_line(char sign, uint32_t number, const golden_line_t* line)
+{
+	if (diff_lines_shown++ < MAX_DIFF_LINES) {
+		printf("%c%6u  %u %s\n", sign, number + 1, line->ms, line->bytes);
+	}
+}
+
+/**
+ * Lists the lines of the golden output and of this run which differ, with
+ * their line numbers. The common start and end are left out before the
+ * longest common run of lines is found for the rest.
+ */
+
+static void show_diff(const golden_t* expected, const golden_t* actual, uint32_t slack_ms)
+{
+	uint32_t start = 0;
+	while (start < expected->count && start < actual->count &&
+	       lines_match(&expected->lines[start], &actual->lines[start], slack_ms)) {
+		start++;
+	}
+
+	uint32_t end_e = expected->count;
+	uint32_t end_a = actual->count;
+	while (end_e > start && end_a > start &&
+	       lines_match(&expected->lines[end_e - 1], &actual->lines[end_a - 1], slack_ms)) {
+		end_e--;
+		end_a--;
+	}
+
+	uint32_t n = end_e - start;
+	uint32_t m = end_a - start;
+
+	diff_lines_shown = 0;
+
+	if ((uint64_t)(n + 1) * (m + 1) > MAX_DIFF_CELLS) {
+		for (uint32_t i=0;i<n;++i) {
+			show_line('-', start + i, &expected->lines[start + i]);
+		}
+		for (uint32_t j=0;j<m;++j) {
+			show_line('+', start + j, &actual->lines[start + j]);
+		}
+	} else {
+		// lcs[i][j] is the longest common run of the lines from i and j on
+		uint32_t* lcs = calloc((size_t)(n + 1) * (m + 1), sizeof(uint32_t));
+		if (!lcs) {
+			perror("golden_file");
+			exit(EXIT_FAILURE);
+		}
+		#define LCS(i, j) lcs[(size_t)(i) * (m + 1) + (j)]
+
+		for (uint32_t i=n;i-- > 0;) {
+			for (uint32_t j=m;j-- > 0;) {
+				if (lines_match(&expected->lines[start + i], &actual->lines[start + j], slack_ms)) {
+					LCS(i, j) = LCS(i + 1, j + 1) + 1;
+				} else {
+					LCS(i, j) = LCS(i + 1, j) > LCS(i, j + 1) ? LCS(i + 1, j) : LCS(i, j + 1);
+				}
+			}
+		}
+
+		uint32_t i = 0, j = 0;
+		while (i < n || j < m) {
+			if (i < n && j < m && lines_match(&expected->lines[start + i], &actual->lines[start + j], slack_ms)) {
+				i++;
+				j++;
+			} else if (j == m || (i < n && LCS(i + 1, j) >= LCS(i, j + 1))) {
+				show_line('-', start + i, &expected->lines[start + i]);
+				i++;
+			} else {
+				show_line('+', start + j, &actual->lines[start + j]);
+				j++;
+			}
+		}
+
+		#undef LCS
+		free(lcs);
+	}
+
+	if (diff_lines_shown > MAX_DIFF_LINES) {
+		printf("  ... %u more\n", diff_lines_shown - MAX_DIFF_LINES);
+	}
+}
+
+void golden_path(const char* source, char* path, size_t size)
+{
+	snprintf(path, size, "%s", source);
+
+	char* dot = strrchr(path, '.');
+	char* slash = strrchr(path, '/');
+	if (dot && (!slash || dot > slash)) {
+		*dot = '\0';
+	}
+
+	size_t length = strlen(path);
+	snprintf(path + length, size - length, ".golden");
+}
+
+bool golden_write(const char* path, const char* comment, FILE* output)
+{
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		perror(path);
+		return false;
+	}
+
+	fprintf(file, "# %s\n", comment);
+
+	char line[MAX_LINE];
+	while (fgets(line, sizeof(line), output)) {
+		fputs(line, file);
+	}
+
+	if (fclose(file)) {
+		perror(path);
+		return false;
+	}
+	return true;
+}
+
+bool golden_check(const char* name, const char* path, FILE* output, uint32_t slack_ms)
+{
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		fprintf(stderr, "%s: no %s, make it with --update\n", name, path);
+		return false;
+	}
+
+	golden_t expected = {0};
+	golden_t actual = {0};
+	read_golden(&expected, file);
+	read_golden(&actual, output);
+	fclose(file);
+
+	bool ok = expected.count == actual.count;
+	for (uint32_t i=0;ok && i<expected.count;++i) {
+		ok = lines_match(&expected.lines[i], &actual.lines[i], slack_ms);
+	}
+
+	if (ok) {
+		printf("%s: %u messages match\n", name, actual.count);
+	} else {
+		printf("%s: differs from %s\n", name, path);
+		show_diff(&expected, &actual, slack_ms);
+	}
+
+	free_golden(&expected);
+	free_golden(&actual);
+	return ok;
+}
@@ -0,0 +1,54 @@
+/*
+ * golden_file.h
+ *
+ * Created: 10/18/2026 1:42:16 PM
+ *
+ *  Golden MIDI output files, shared by twister_golden and twister_replay.
+ *  A golden file holds one message a line, the time in mS then the bytes
+ *  in hex, a SysEx on one line, # starts a comment. Lines match when the
+ *  bytes are the same and the times no further apart than the slack given.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef GOLDEN_FILE_H_
+#define GOLDEN_FILE_H_
+
+	/*	Includes: */
+
+		#include <stdbool.h>
+		#include <stddef.h>
+		#include <stdint.h>
+		#include <stdio.h>
+
+	/*	Function Prototypes: */
+
+		// Writes a message as a golden file line
+		void golden_print(FILE* output, uint64_t time_us, const uint8_t* data, uint16_t length);
+
+		// The golden file of a script or capture, its path with .golden for
+		// the extension
+		void golden_path(const char* source, char* path, size_t size);
+
+		// Writes the lines in 'output' to 'path' under a comment line
+		bool golden_write(const char* path, const char* comment, FILE* output);
+
+		// Compares the lines in 'output' with the golden file at 'path'. Prints
+		// the result under 'name' and, on a difference, the lines which differ,
+		// - for the golden file and + for this run
+		bool golden_check(const char* name, const char* path, FILE* output, uint32_t slack_ms);
+
+#endif /* GOLDEN_FILE_H_ */
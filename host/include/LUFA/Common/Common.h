@@ -0,0 +1,47 @@
+/*
+ * Common.h
+ *
+ * Created: 10/18/2026 1:11:20 PM
+ *
+ *  Host build replacement for LUFA's common header: attribute macros and
+ *  the LUFA delay helper.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef HOST_LUFA_COMMON_H
+#define HOST_LUFA_COMMON_H
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+		#include <util/delay.h>
+
+	/* Macros: */
+
+		#define ATTR_NO_INIT
+		#define ATTR_NO_RETURN
+		#define ATTR_INIT_SECTION(section)
+		#define ATTR_WARN_UNUSED_RESULT     __attribute__ ((warn_unused_result))
+		#define ATTR_NON_NULL_PTR_ARG(...)
+		#define ATTR_ALWAYS_INLINE          __attribute__ ((always_inline))
+		#define ATTR_PACKED                 __attribute__ ((packed))
+		#define ATTR_CONST                  __attribute__ ((const))
+
+		#define Delay_MS(ms)                _delay_ms(ms)
+
+#endif
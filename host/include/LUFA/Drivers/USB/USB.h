@@ -0,0 +1,141 @@
+/*
+ * USB.h
+ *
+ * Created: 10/18/2026 1:14:48 PM
+ *
+ *  Host build replacement for the LUFA USB stack. The endpoint functions 
+ *  work on the emulated MIDI endpoints in usb_sim.c, and the descriptor 
+ *  types are opaque since Descriptors.c is not part of the host build.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef HOST_LUFA_USB_H
+#define HOST_LUFA_USB_H
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+		#include <avr/io.h>
+		#include <LUFA/Common/Common.h>
+		#include <LUFA/Platform/Platform.h>
+
+	/* Macros: */
+
+		#define ENDPOINT_DIR_OUT                0x00
+		#define ENDPOINT_DIR_IN                 0x80
+
+		#define MIDI_EVENT(virtualcable, command)  (((virtualcable) << 4) | ((command) >> 4))
+
+		#define MIDI_COMMAND_NOTE_OFF           0x80
+		#define MIDI_COMMAND_NOTE_ON            0x90
+		#define MIDI_COMMAND_CONTROL_CHANGE     0xB0
+		#define MIDI_COMMAND_SYSEX_START_3BYTE  0x40
+		#define MIDI_COMMAND_SYSEX_1BYTE        0x50
+		#define MIDI_COMMAND_SYSEX_2BYTE        0x60
+		#define MIDI_COMMAND_SYSEX_3BYTE        0x70
+		#define MIDI_COMMAND_SYSEX_END_1BYTE    0x50
+		#define MIDI_COMMAND_SYSEX_END_2BYTE    0x60
+		#define MIDI_COMMAND_SYSEX_END_3BYTE    0x70
+
+	/* Types: */
+
+		typedef struct { uint8_t Size; uint8_t Type; } USB_Descriptor_Header_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_Descriptor_Configuration_Header_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_Descriptor_Interface_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_Audio_Descriptor_Interface_AC_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_MIDI_Descriptor_AudioInterface_AS_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_MIDI_Descriptor_InputJack_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_MIDI_Descriptor_OutputJack_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_Audio_Descriptor_StreamEndpoint_Std_t;
+		typedef struct { USB_Descriptor_Header_t Header; } USB_MIDI_Descriptor_Jack_Endpoint_t;
+
+		typedef struct {
+			uint8_t  Event;
+			uint8_t  Data1;
+			uint8_t  Data2;
+			uint8_t  Data3;
+		} MIDI_EventPacket_t;
+
+		typedef struct {
+			uint8_t  Address;
+			uint16_t Size;
+			uint8_t  Type;
+			uint8_t  Banks;
+		} USB_Endpoint_Table_t;
+
+		typedef struct {
+			struct {
+				uint8_t StreamingInterfaceNumber;
+				USB_Endpoint_Table_t DataINEndpoint;
+				USB_Endpoint_Table_t DataOUTEndpoint;
+			} Config;
+		} USB_ClassInfo_MIDI_Device_t;
+
+		enum USB_Device_States_t {
+			DEVICE_STATE_Unattached = 0,
+			DEVICE_STATE_Powered,
+			DEVICE_STATE_Default,
+			DEVICE_STATE_Addressed,
+			DEVICE_STATE_Configured,
+			DEVICE_STATE_Suspended,
+		};
+
+		#define ENDPOINT_CONTROLEP          0
+
+	/* Variables: */
+
+		extern volatile uint8_t USB_DeviceState;
+
+	/* Function Prototypes: */
+
+		void USB_Init(void);
+		void USB_Disable(void);
+		void USB_USBTask(void);
+
+		uint8_t Endpoint_GetCurrentEndpoint(void);
+		void Endpoint_SelectEndpoint(const uint8_t Address);
+		bool Endpoint_IsSETUPReceived(void);
+		bool Endpoint_IsOUTReceived(void);
+		void Endpoint_ClearIN(void);
+		void Endpoint_ClearOUT(void);
+		uint8_t Endpoint_Read_8(void);
+		void Endpoint_Write_8(const uint8_t Data);
+		uint16_t Endpoint_BytesInEndpoint(void);
+		void USB_Device_EnableSOFEvents(void);
+		void EVENT_USB_Device_StartOfFrame(void);
+
+		extern volatile USB_EP_t* USB_Endpoint_SelectedHandle;
+
+		bool MIDI_Device_ConfigureEndpoints(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo);
+		void MIDI_Device_ProcessControlRequest(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo);
+		void MIDI_Device_USBTask(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo);
+		uint8_t MIDI_Device_SendEventPacket(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo,
+		                                    const MIDI_EventPacket_t* const Event);
+		uint8_t MIDI_Device_Flush(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo);
+		bool MIDI_Device_ReceiveEventPacket(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo,
+		                                    MIDI_EventPacket_t* const Event);
+
+		// Application event hooks, implemented in main.c
+		void EVENT_USB_Device_Connect(void);
+		void EVENT_USB_Device_Disconnect(void);
+		void EVENT_USB_Device_ConfigurationChanged(void);
+		void EVENT_USB_Device_ControlRequest(void);
+		void EVENT_USB_Device_Suspend(void);
+		void EVENT_USB_Device_Wakeup(void);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Platform.h
+ *
+ * Created: 10/18/2026 1:13:02 PM
+ *
+ *  Host build replacement for LUFA's XMEGA clock management helpers.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef HOST_LUFA_PLATFORM_H
+#define HOST_LUFA_PLATFORM_H
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+	/* Macros: */
+
+		#define CLOCK_SRC_INT_RC2MHZ    0
+		#define CLOCK_SRC_INT_RC32MHZ   1
+		#define CLOCK_SRC_INT_RC32KHZ   2
+		#define CLOCK_SRC_XOSC          3
+		#define CLOCK_SRC_PLL           4
+
+		#define DFLL_REF_INT_RC32KHZ    0
+		#define DFLL_REF_EXT_RC32KHZ    1
+		#define DFLL_REF_INT_USBSOF     2
+
+	/* Function Prototypes: */
+
+		bool XMEGACLK_StartPLL(uint8_t Source, uint32_t SourceFreq, uint32_t Frequency);
+		bool XMEGACLK_SetCPUClockSource(uint8_t Source);
+		bool XMEGACLK_StartInternalOscillator(uint8_t Source);
+		bool XMEGACLK_StartDFLL(uint8_t Source, uint8_t Reference, uint32_t Frequency);
+
+#endif
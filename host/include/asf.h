@@ -0,0 +1,312 @@
+/*
+ * asf.h
+ *
+ * Created: 10/18/2026 1:02:14 PM
+ *
+ *  Host build replacement for the Atmel Software Framework umbrella header.
+ *  Provides just enough of the XMEGA register map and the ASF driver API
+ *  for the firmware sources to compile and run against the simulated
+ *  hardware in host/sim.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef ASF_H
+#define ASF_H
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+		#include <stddef.h>
+		#include <string.h>
+
+		#include <avr/io.h>
+		#include <avr/interrupt.h>
+		#include <avr/pgmspace.h>
+		#include <util/delay.h>
+
+	/* Macros: */
+
+		// Compiler abstraction
+		#define Assert(expr)        ((void)0)
+		#define UNUSED(v)           (void)(v)
+		#ifndef MIN
+		#define MIN(a, b)           (((a) < (b)) ? (a) : (b))
+		#endif
+		#define Min(a, b)           (((a) < (b)) ? (a) : (b))
+		#define Max(a, b)           (((a) > (b)) ? (a) : (b))
+		#define min(a, b)           Min(a, b)
+		#define max(a, b)           Max(a, b)
+		#ifndef MAX
+		#define MAX(a, b)           (((a) > (b)) ? (a) : (b))
+		#endif
+
+		// IOPORT
+		#define IOPORT_PORTA        0
+		#define IOPORT_PORTB        1
+		#define IOPORT_PORTC        2
+		#define IOPORT_PORTD        3
+		#define IOPORT_PORTE        4
+		#define IOPORT_PORTF        5
+		#define IOPORT_PORTR        7
+		#define IOPORT_CREATE_PIN(port, pin) ((IOPORT_ ## port) * 8 + (pin))
+
+		#define IOPORT_MODE_TOTEM       0x00
+		#define IOPORT_MODE_PULLDOWN    0x10
+		#define IOPORT_MODE_PULLUP      0x18
+		#define IOPORT_MODE_INVERT_PIN  0x40
+
+		// NVM
+		#define EEPROM_SIZE         2048
+		#define EEPROM_PAGE_SIZE    32
+
+		// Reset cause
+		#define CHIP_RESET_CAUSE_POR        0x01
+		#define CHIP_RESET_CAUSE_EXTRST     0x02
+		#define CHIP_RESET_CAUSE_BOD_IO     0x04
+		#define CHIP_RESET_CAUSE_WDT        0x08
+		#define CHIP_RESET_CAUSE_OCD        0x10
+		#define CHIP_RESET_CAUSE_SOFT       0x20
+		#define CHIP_RESET_CAUSE_SPIKE      0x40
+
+	/* Types: */
+
+		typedef uint8_t  ioport_pin_t;
+		typedef uint8_t  ioport_port_mask_t;
+		typedef uint16_t eeprom_addr_t;
+		typedef uint8_t  irqflags_t;
+		typedef uint8_t  reset_cause_t;
+		typedef uint8_t  dma_channel_num_t;
+
+		enum ioport_direction {
+			IOPORT_DIR_INPUT,
+			IOPORT_DIR_OUTPUT,
+		};
+
+		enum ioport_value {
+			IOPORT_PIN_LEVEL_LOW,
+			IOPORT_PIN_LEVEL_HIGH,
+		};
+
+		// Timer/counter
+		typedef void (*tc_callback_t) (void);
+
+		enum tc_cc_channel_t {
+			TC_CCA = 1,
+			TC_CCB = 2,
+			TC_CCC = 3,
+			TC_CCD = 4,
+		};
+
+		enum TC_INT_LEVEL_enum {
+			TC_INT_LVL_OFF = 0x00,
+			TC_INT_LVL_LO  = 0x01,
+			TC_INT_LVL_MED = 0x02,
+			TC_INT_LVL_HI  = 0x03,
+		};
+
+		enum tc_wg_mode_t {
+			TC_WG_NORMAL = 0x00,
+			TC_WG_FRQ    = 0x01,
+			TC_WG_SS     = 0x03,
+		};
+
+		// Watchdog
+		enum wdt_timeout_period_t {
+			WDT_TIMEOUT_PERIOD_8CLK    = 0x00,
+			WDT_TIMEOUT_PERIOD_16CLK   = 0x01,
+			WDT_TIMEOUT_PERIOD_32CLK   = 0x02,
+			WDT_TIMEOUT_PERIOD_64CLK   = 0x03,
+			WDT_TIMEOUT_PERIOD_125CLK  = 0x04,
+			WDT_TIMEOUT_PERIOD_250CLK  = 0x05,
+			WDT_TIMEOUT_PERIOD_500CLK  = 0x06,
+			WDT_TIMEOUT_PERIOD_1KCLK   = 0x07,
+			WDT_TIMEOUT_PERIOD_2KCLK   = 0x08,
+			WDT_TIMEOUT_PERIOD_4KCLK   = 0x09,
+			WDT_TIMEOUT_PERIOD_8KCLK   = 0x0A,
+		};
+
+		// DMA
+		struct dma_channel_config {
+			uint8_t  ctrla;
+			uint8_t  ctrlb;
+			uint8_t  addrctrl;
+			uint8_t  trigsrc;
+			uint16_t trfcnt;
+			uint8_t  repcnt;
+			uint16_t srcaddr16;
+			uint16_t destaddr16;
+		};
+
+		// USART
+		typedef struct usart_serial_options {
+			uint32_t baudrate;
+			uint8_t  charlength;
+			uint8_t  paritytype;
+			bool     stopbits;
+		} usart_serial_options_t;
+
+		typedef struct usart_spi_options {
+			uint32_t baudrate;
+			uint8_t  spimode;
+			uint8_t  data_order;
+		} usart_spi_options_t;
+
+		// FIFO
+		struct fifo_desc {
+			uint8_t *buffer;
+			volatile uint8_t read_index;
+			volatile uint8_t write_index;
+			uint8_t size;
+			uint8_t mask;
+		};
+		typedef struct fifo_desc fifo_desc_t;
+
+		// Sleep manager
+		enum sleepmgr_mode {
+			SLEEPMGR_ACTIVE = 0,
+			SLEEPMGR_IDLE,
+			SLEEPMGR_ESTDBY,
+			SLEEPMGR_PSAVE,
+			SLEEPMGR_STDBY,
+			SLEEPMGR_PDOWN,
+			SLEEPMGR_NR_OF_MODES,
+		};
+
+	/* Function Prototypes: */
+
+		// Interrupts
+		void cpu_irq_enable(void);
+		void cpu_irq_disable(void);
+		bool cpu_irq_is_enabled(void);
+		irqflags_t cpu_irq_save(void);
+		void cpu_irq_restore(irqflags_t flags);
+
+		// IOPORT
+		void ioport_init(void);
+		void ioport_set_pin_dir(ioport_pin_t pin, enum ioport_direction dir);
+		void ioport_set_pin_mode(ioport_pin_t pin, uint8_t mode);
+		void ioport_set_pin_level(ioport_pin_t pin, bool level);
+		bool ioport_get_pin_level(ioport_pin_t pin);
+		void ioport_toggle_pin_level(ioport_pin_t pin);
+
+		// Timer/counter
+		void tc_enable(volatile void *tc);
+		void tc_disable(volatile void *tc);
+		void tc_set_wgm(volatile void *tc, enum tc_wg_mode_t wgm);
+		void tc_write_clock_source(volatile void *tc, uint8_t clk_sel);
+		void tc_write_period(volatile void *tc, uint16_t per_value);
+		void tc_write_cc(volatile void *tc, enum tc_cc_channel_t channel, uint16_t value);
+		uint16_t tc_read_cc(volatile void *tc, enum tc_cc_channel_t channel);
+		uint16_t tc_read_count(volatile void *tc);
+		void tc_set_cca_interrupt_callback(volatile void *tc, tc_callback_t callback);
+		void tc_set_ccb_interrupt_callback(volatile void *tc, tc_callback_t callback);
+		void tc_set_overflow_interrupt_callback(volatile void *tc, tc_callback_t callback);
+		void tc_set_cca_interrupt_level(volatile void *tc, enum TC_INT_LEVEL_enum level);
+		void tc_set_ccb_interrupt_level(volatile void *tc, enum TC_INT_LEVEL_enum level);
+		void tc_set_overflow_interrupt_level(volatile void *tc, enum TC_INT_LEVEL_enum level);
+
+		// DMA
+		void dma_enable(void);
+		void dma_disable(void);
+		void dma_set_double_buffer_mode(uint8_t mode);
+		void dma_channel_set_burst_length(struct dma_channel_config *config, uint8_t burst_length);
+		void dma_channel_set_transfer_count(struct dma_channel_config *config, uint16_t count);
+		void dma_channel_set_single_shot(struct dma_channel_config *config);
+		void dma_channel_set_src_dir_mode(struct dma_channel_config *config, uint8_t mode);
+		void dma_channel_set_src_reload_mode(struct dma_channel_config *config, uint8_t mode);
+		void dma_channel_set_dest_dir_mode(struct dma_channel_config *config, uint8_t mode);
+		void dma_channel_set_dest_reload_mode(struct dma_channel_config *config, uint8_t mode);
+		void dma_channel_set_source_address(struct dma_channel_config *config, uint16_t address);
+		void dma_channel_set_destination_address(struct dma_channel_config *config, uint16_t address);
+		void dma_channel_set_trigger_source(struct dma_channel_config *config, uint8_t source);
+		void dma_channel_write_config(dma_channel_num_t num, struct dma_channel_config *config);
+		void dma_channel_write_source(dma_channel_num_t num, uint16_t source);
+		void dma_channel_enable(dma_channel_num_t num);
+		bool dma_channel_is_busy(dma_channel_num_t num);
+
+		// USART
+		bool usart_init_spi(USART_t *usart, const usart_spi_options_t *opt);
+		bool usart_serial_init(USART_t *usart, const usart_serial_options_t *opt);
+		int usart_serial_write_packet(USART_t *usart, const uint8_t *data, size_t len);
+		void usart_serial_getchar(USART_t *usart, uint8_t *data);
+
+		// NVM
+		uint8_t nvm_eeprom_read_byte(eeprom_addr_t addr);
+		void nvm_eeprom_write_byte(eeprom_addr_t address, uint8_t value);
+		void nvm_eeprom_read_buffer(eeprom_addr_t address, void *buf, uint16_t len);
+		void nvm_eeprom_erase_and_write_buffer(eeprom_addr_t address, const void *buf, uint16_t len);
+		void nvm_eeprom_load_page_to_buffer(const uint8_t *values);
+		void nvm_eeprom_atomic_write_page(uint8_t page_addr);
+
+		// Watchdog
+		void wdt_enable(void);
+		void wdt_disable(void);
+		void wdt_reset(void);
+		void wdt_reset_mcu(void);
+		void wdt_set_timeout_period(enum wdt_timeout_period_t period);
+
+		// Reset cause
+		reset_cause_t reset_cause_get_causes(void);
+		void reset_cause_clear_causes(reset_cause_t causes);
+
+		// Sleep manager
+		void sleepmgr_init(void);
+		void sleepmgr_lock_mode(enum sleepmgr_mode mode);
+		void sleepmgr_unlock_mode(enum sleepmgr_mode mode);
+		void sleepmgr_enter_sleep(void);
+
+		// FIFO
+		int fifo_init(fifo_desc_t *fifo_desc, void *buffer, uint8_t size);
+
+	/* Inline Functions: */
+
+		static inline uint8_t fifo_get_used_size(fifo_desc_t *fifo_desc)
+		{
+			return ((fifo_desc->write_index - fifo_desc->read_index) & fifo_desc->mask);
+		}
+
+		static inline bool fifo_is_empty(fifo_desc_t *fifo_desc)
+		{
+			return (fifo_desc->write_index == fifo_desc->read_index);
+		}
+
+		static inline bool fifo_is_full(fifo_desc_t *fifo_desc)
+		{
+			return (fifo_get_used_size(fifo_desc) == fifo_desc->size);
+		}
+
+		static inline int fifo_push_uint8(fifo_desc_t *fifo_desc, uint32_t item)
+		{
+			if (fifo_is_full(fifo_desc)) {
+				return -1;
+			}
+			fifo_desc->buffer[fifo_desc->write_index & (fifo_desc->size - 1)] = item;
+			fifo_desc->write_index = (fifo_desc->write_index + 1) & fifo_desc->mask;
+			return 0;
+		}
+
+		static inline int fifo_pull_uint8(fifo_desc_t *fifo_desc, uint8_t *item)
+		{
+			if (fifo_is_empty(fifo_desc)) {
+				return -1;
+			}
+			*item = fifo_desc->buffer[fifo_desc->read_index & (fifo_desc->size - 1)];
+			fifo_desc->read_index = (fifo_desc->read_index + 1) & fifo_desc->mask;
+			return 0;
+		}
+
+#endif
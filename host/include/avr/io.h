@@ -0,0 +1,127 @@
+/*
+ * io.h
+ *
+ * Created: 10/18/2026 1:04:51 PM
+ *
+ *  Host build replacement for <avr/io.h>. Only the XMEGA peripherals the
+ *  firmware touches directly are modelled; everything else goes through the
+ *  ASF driver stubs in asf.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+	/* Includes: */
+		#include <stdint.h>
+
+	/* Types: */
+
+		typedef struct PMIC_struct {
+			volatile uint8_t STATUS;
+			volatile uint8_t INTPRI;
+			volatile uint8_t CTRL;
+		} PMIC_t;
+
+		typedef struct TC_struct {
+			volatile uint8_t  CTRLA;
+			volatile uint8_t  CTRLB;
+			volatile uint8_t  INTCTRLA;
+			volatile uint8_t  INTCTRLB;
+			volatile uint16_t CNT;
+			volatile uint16_t PER;
+			volatile uint16_t CCA;
+			volatile uint16_t CCB;
+		} TC_t;
+
+		typedef struct USB_struct {
+			volatile uint8_t INTCTRLA;
+			volatile uint8_t INTCTRLB;
+			volatile uint8_t INTFLAGSASET;
+			volatile uint8_t INTFLAGSACLR;
+			volatile uint8_t INTFLAGSBCLR;
+			volatile uint16_t EPPTR;
+		} USB_t;
+
+		typedef struct USB_EP_struct {
+			volatile uint8_t  STATUS;
+			volatile uint8_t  CTRL;
+			volatile uint16_t CNT;
+			volatile uint16_t DATAPTR;
+			volatile uint16_t AUXDATA;
+		} USB_EP_t;
+
+		typedef struct USART_struct {
+			volatile uint8_t DATA;
+			volatile uint8_t STATUS;
+			volatile uint8_t CTRLA;
+			volatile uint8_t CTRLB;
+			volatile uint8_t CTRLC;
+		} USART_t;
+
+	/* Macros: */
+
+		#define USB_TRNIE_bm            0x02
+		#define USB_SOFIE_bm            0x80
+		#define USB_SOFIF_bm            0x80
+		#define USB_TRNIF_bm            0x02
+		#define USB_EP_INTDSBL_bm       0x08
+		#define USB_EP_TRNCOMPL0_bm     0x20
+		#define USB_EP_BUSNACK0_bm      0x40
+
+		#define PMIC_LOLVLEN_bm         0x01
+		#define PMIC_MEDLVLEN_bm        0x02
+		#define PMIC_HILVLEN_bm         0x04
+
+		#define TC_CLKSEL_OFF_gc        0x00
+		#define TC_CLKSEL_DIV1_gc       0x01
+		#define TC_CLKSEL_DIV2_gc       0x02
+		#define TC_CLKSEL_DIV4_gc       0x03
+		#define TC_CLKSEL_DIV8_gc       0x04
+		#define TC_CLKSEL_DIV64_gc      0x05
+		#define TC_CLKSEL_DIV256_gc     0x06
+		#define TC_CLKSEL_DIV1024_gc    0x07
+
+		#define USART_RXCINTLVL0_bm     0x10
+		#define USART_RXCINTLVL1_bm     0x20
+		#define USART_CHSIZE_8BIT_gc    0x03
+		#define USART_PMODE_DISABLED_gc 0x00
+
+		#define DMA_CH_BURSTLEN_1BYTE_gc        0x00
+		#define DMA_CH_SRCRELOAD_NONE_gc        0x00
+		#define DMA_CH_SRCDIR_INC_gc            0x10
+		#define DMA_CH_DESTRELOAD_NONE_gc       0x00
+		#define DMA_CH_DESTDIR_FIXED_gc         0x00
+		#define DMA_CH_TRIGSRC_USARTD0_DRE_gc   0x6B
+
+		#define USARTE0_CTRLA           USARTE0.CTRLA
+
+		// ATxmega128A4U flash layout
+		#define BOOT_SECTION_START      0x20000
+
+	/* Variables: */
+
+		extern PMIC_t  PMIC;
+		extern TC_t    TCC0;
+		extern TC_t    TCC1;
+		extern TC_t    TCD0;
+		extern USB_t   USB;
+		extern USART_t USARTD0;
+		extern USART_t USARTE0;
+		extern volatile uint8_t EIND;
+
+#endif
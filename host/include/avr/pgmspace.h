@@ -0,0 +1,58 @@
+/*
+ * pgmspace.h
+ *
+ * Created: 10/18/2026 1:08:09 PM
+ *
+ *  Host build replacement for <avr/pgmspace.h>. Flash and RAM share one
+ *  address space on the host so program memory reads are plain loads.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <string.h>
+
+	/* Macros: */
+
+		#define PROGMEM
+		#define PSTR(s)             (s)
+		#define pgm_read_byte(p)    (*(const uint8_t *)(p))
+		#define pgm_read_word(p)    pgm_read_word_host(p)
+		#define pgm_read_dword(p)   pgm_read_dword_host(p)
+		#define memcpy_P            memcpy
+
+	/* Inline Functions: */
+
+		// Flash has no alignment, the firmware reads words from any address
+		static inline uint16_t pgm_read_word_host(const void* p)
+		{
+			uint16_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		static inline uint32_t pgm_read_dword_host(const void* p)
+		{
+			uint32_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+#endif
@@ -0,0 +1,463 @@
+/*
+ * latency.c
+ *
+ * Created: 10/18/2026 6:05:48 PM
+ *
+ *  Measures how long an encoder turn takes to become a USB MIDI packet.
+ *  The firmware runs its main loop on the simulated hardware with the
+ *  factory settings, where encoder N of the first bank sends CC N on
+ *  channel 1. Each trial turns the encoder by one detent, starting at a
+ *  random point in the scan period, and times the first edge to the first
+ *  CC for it committed to the MIDI IN endpoint. Trials alternate direction
+ *  so the value never sticks at an end.
+ *
+ *  The simulator charges time for the hardware the firmware waits on, and
+ *  for its own code a set number of cycles each time a profiled path ends,
+ *  see sim_set_profile_cost(). The figures used are estimates for a 32 MHz
+ *  XMEGA. Calibrate them from a unit's profiler dump, diagnostics SUB 0x3,
+ *  taking a path's typical duration less that of the paths it calls, and
+ *  pass them with --cost. Feedback and animations then load the main loop
+ *  and the interrupts as they would on the unit, and move the figures.
+ *
+ *  twister_latency [options]
+ *    -n, --trials N        number of trials, default 1000
+ *    -e, --encoder N       encoder to turn, 0-15
+ *    -E, --edge-us US      time between the quadrature edges of a detent
+ *    -g, --gap-ms MS       idle time between trials
+ *    -f, --feedback N      incoming CC feedback for the other encoders,
+ *                          in messages per second
+ *    -A, --animations N    encoders running a rainbow and indicator pulse
+ *    -c, --cost P=CYCLES   cycles charged each time profile point P ends,
+ *                          numbered as in the profiler dump, 0 for none
+ *    -s, --seed N          seed for the trial start times
+ *    -o, --csv FILE        write each trial to FILE
+ *    -S, --summary FILE    append the results as a row of FILE
+ *
+ *  The exit status is 1 if any trial timed out without a packet.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "input.h"
+#include "profiler.h"
+
+// Boot, enumeration and the start up animation are over by then
+#define WARM_UP_MS			1000
+
+// A trial with no packet by then has been lost
+#define TRIAL_TIMEOUT_MS	100
+
+// Quadrature edges to one detent
+#define EDGES_PER_DETENT	4
+
+// The idle encoder scan period, the start of a trial is spread over it
+#define SCAN_PERIOD_CYCLES	((uint64_t)INPUT_SCAN_RATE * 1024)
+
+typedef struct {
+	uint32_t trials;
+	uint8_t  encoder;
+	uint32_t edge_us;
+	uint32_t gap_ms;
+	uint32_t feedback;
+	uint8_t  animations;
+	uint32_t seed;
+	const char* csv_path;
+	const char* summary_path;
+} latency_options_t;
+
+static latency_options_t options = {
+	.trials     = 1000,
+	.encoder    = 0,
+	.edge_us    = 1000,
+	.gap_ms     = 20,
+	.feedback   = 0,
+	.animations = 0,
+	.seed       = 1,
+};
+
+// Estimated cycles of the firmware's own work on each path. The tasks
+// which only call another profiled path are left to that path
+static uint32_t profile_cost[PROFILE_POINT_COUNT] = {
+	[PROFILE_TASK_FIRST + TASK_DISPLAY] = 20000,	// Ring and RGB redraw
+	[PROFILE_ISR_ENCODER_SCAN]          = 1000,
+	[PROFILE_ISR_DISPLAY_FRAME]         = 400,
+	[PROFILE_ISR_DO_TASK]               = 100,
+	[PROFILE_ENCODER_INPUT]             = 2000,
+	[PROFILE_MIDI_PACKET]               = 300,
+	[PROFILE_ELEMENT_MIDI]              = 600,
+};
+
+static uint32_t* latency_us;
+static uint32_t  trial;
+static uint32_t  missed;
+
+static uint64_t  trial_start;
+static bool      trial_waiting;
+static uint8_t   edges_left;
+// Flipped before each trial, the first turns up from the factory value 0
+static int8_t    direction = -1;
+
+// Feedback messages owed, in thousandths
+static uint32_t  feedback_credit;
+static uint8_t   feedback_encoder;
+static uint8_t   feedback_value;
+
+static void timeout_trial(void);
+static void start_trial(void);
+static void finish(void);
+
+/**
+ * Random number for spreading the trial start times, the same sequence
+ * for the same seed.
+ */
+
+static uint32_t next_random(void)
+{
+	options.seed = options.seed * 1103515245UL + 12345UL;
+	return options.seed >> 8;
+}
+
+static void send_cc(uint8_t channel, uint8_t number, uint8_t value)
+{
+	uint8_t message[] = {0xB0 | channel, number, value};
+	sim_midi_in(message, sizeof(message));
+}
+
+/**
+ * Steps through the detent one edge at a time, then waits out the timeout.
+ */
+
+static void next_edge(void)
+{
+	sim_encoder_step(options.encoder, direction);
+
+	if (--edges_left) {
+		sim_schedule(sim_get_cycles() + (uint64_t)options.edge_us * SIM_CYCLES_PER_US, next_edge);
+	} else {
+		sim_schedule(trial_start + (uint64_t)TRIAL_TIMEOUT_MS * SIM_CYCLES_PER_MS, timeout_trial);
+	}
+}
+
+static void timeout_trial(void)
+{
+	if (trial_waiting) {
+		trial_waiting = false;
+		latency_us[trial++] = UINT32_MAX;
+		missed++;
+		start_trial();
+	}
+}
+
+/**
+ * Turns the encoder by one detent after the gap and a random part of a scan
+ * period, then waits for the packet.
+ */
+
+static void begin_trial(void)
+{
+	trial_start   = sim_get_cycles();
+	trial_waiting = true;
+	edges_left    = EDGES_PER_DETENT;
+	next_edge();
+}
+
+static void start_trial(void)
+{
+	if (trial == options.trials) {
+		finish();
+	}
+
+	// Let the encoder settle back to the idle scan rate. Turning back the
+	// other way keeps the value off the end stops
+	direction = -direction;
+
+	uint64_t at = sim_get_cycles() + (uint64_t)options.gap_ms * SIM_CYCLES_PER_MS +
+	              next_random() % SCAN_PERIOD_CYCLES;
+	sim_schedule(at, begin_trial);
+}
+
+/**
+ * Watches the packets committed to the MIDI IN endpoint for the first CC
+ * from the encoder under test.
+ */
+
+static void on_usb_in(const uint8_t* packets, uint8_t length)
+{
+	if (!trial_waiting) {
+		return;
+	}
+
+	for (uint8_t i=0;i + 4 <= length;i += 4) {
+		if ((packets[i] & 0x0F) == 0x0B && packets[i + 1] == 0xB0 &&
+		    packets[i + 2] == options.encoder) {
+			trial_waiting = false;
+			latency_us[trial++] = (sim_get_cycles() - trial_start) / SIM_CYCLES_PER_US;
+
+			// Cancels the timeout, or edges still to come
+			sim_schedule(0, NULL);
+			start_trial();
+			return;
+		}
+	}
+}
+
+/**
+ * Sends the MIDI feedback flood and, once warmed up, the animations.
+ */
+
+static void on_frame(void)
+{
+	uint64_t now_ms = sim_get_time_us() / 1000;
+
+	if (now_ms < WARM_UP_MS) {
+		return;
+	}
+
+	if (now_ms == WARM_UP_MS) {
+		for (uint8_t i=0;i<options.animations;++i) {
+			// Rainbow RGB and a pulsing indicator, the busiest to draw
+			send_cc(ENCODER_ANIMATION_CHANNEL, i, 127);
+			send_cc(SWITCH_ANIMATION_CHANNEL, i, 60);
+		}
+		start_trial();
+	}
+
+	feedback_credit += options.feedback;
+	while (feedback_credit >= 1000 && sim_midi_in_space() >= 3) {
+		feedback_credit -= 1000;
+
+		do {
+			feedback_encoder = (feedback_encoder + 1) % 16;
+		} while (feedback_encoder == options.encoder);
+
+		feedback_value = (feedback_value + 13) & 0x7F;
+		send_cc(ENCODER_ROTARY_CHANNEL, feedback_encoder, feedback_value);
+	}
+}
+
+static int compare_latency(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a;
+	uint32_t y = *(const uint32_t*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * Nearest rank percentile of the sorted trials which got a packet.
+ */
+
+static uint32_t percentile(const uint32_t* sorted, uint32_t count, uint32_t pct)
+{
+	if (!count) {
+		return 0;
+	}
+
+	uint32_t rank = (count * pct + 99) / 100;
+	return sorted[rank ? rank - 1 : 0];
+}
+
+static void write_csv(void)
+{
+	FILE* file = fopen(options.csv_path, "w");
+	if (!file) {
+		perror(options.csv_path);
+		return;
+	}
+
+	fprintf(file, "trial,latency_us\n");
+	for (uint32_t i=0;i<options.trials;++i) {
+		if (latency_us[i] == UINT32_MAX) {
+			fprintf(file, "%u,\n", i);
+		} else {
+			fprintf(file, "%u,%u\n", i, latency_us[i]);
+		}
+	}
+
+	fclose(file);
+}
+
+static void write_summary(uint32_t p50, uint32_t p99, uint32_t max)
+{
+	FILE* file = fopen(options.summary_path, "a");
+	if (!file) {
+		perror(options.summary_path);
+		return;
+	}
+
+	if (ftell(file) == 0) {
+		fprintf(file, "trials,missed,encoder,edge_us,gap_ms,feedback_per_s,animations,p50_us,p99_us,max_us\n");
+	}
+
+	fprintf(file, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+	        options.trials, missed, options.encoder, options.edge_us, options.gap_ms,
+	        options.feedback, options.animations, p50, p99, max);
+
+	fclose(file);
+}
+
+/**
+ * Reports the results and ends the run.
+ */
+
+static void finish(void)
+{
+	if (options.csv_path) {
+		write_csv();
+	}
+
+	// Lost trials sort to the end and are left out of the figures
+	qsort(latency_us, options.trials, sizeof(uint32_t), compare_latency);
+
+	uint32_t count = options.trials - missed;
+	uint32_t p50 = percentile(latency_us, count, 50);
+	uint32_t p99 = percentile(latency_us, count, 99);
+	uint32_t max = count ? latency_us[count - 1] : 0;
+
+	printf("trials %u, missed %u\n", options.trials, missed);
+	printf("p50 %u us, p99 %u us, max %u us\n", p50, p99, max);
+
+	if (options.summary_path) {
+		write_summary(p50, p99, max);
+	}
+
+	sim_exit(missed ? SIM_EXIT_ERROR : SIM_EXIT_OK);
+}
+
+/**
+ * Sets a profile point's cost from a POINT=CYCLES argument.
+ *
+ * \return false if the argument is not understood
+ */
+
+static bool read_cost(const char* arg)
+{
+	unsigned int point, cycles;
+
+	if (sscanf(arg, "%u=%u", &point, &cycles) != 2 || point >= PROFILE_POINT_COUNT) {
+		return false;
+	}
+
+	profile_cost[point] = cycles;
+	return true;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options]\n"
+	        "  -n, --trials N        number of trials, default 1000\n"
+	        "  -e, --encoder N       encoder to turn, 0-15\n"
+	        "  -E, --edge-us US      time between the quadrature edges of a detent\n"
+	        "  -g, --gap-ms MS       idle time between trials\n"
+	        "  -f, --feedback N      incoming CC feedback, messages per second\n"
+	        "  -A, --animations N    encoders running animations\n"
+	        "  -c, --cost P=CYCLES   cycles charged when profile point P ends\n"
+	        "  -s, --seed N          seed for the trial start times\n"
+	        "  -o, --csv FILE        write each trial to FILE\n"
+	        "  -S, --summary FILE    append the results as a row of FILE\n",
+	        name);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option long_options[] = {
+		{"trials",     required_argument, NULL, 'n'},
+		{"encoder",    required_argument, NULL, 'e'},
+		{"edge-us",    required_argument, NULL, 'E'},
+		{"gap-ms",     required_argument, NULL, 'g'},
+		{"feedback",   required_argument, NULL, 'f'},
+		{"animations", required_argument, NULL, 'A'},
+		{"cost",       required_argument, NULL, 'c'},
+		{"seed",       required_argument, NULL, 's'},
+		{"csv",        required_argument, NULL, 'o'},
+		{"summary",    required_argument, NULL, 'S'},
+		{"help",       no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "n:e:E:g:f:A:c:s:o:S:h", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'n':
+				options.trials = strtoul(optarg, NULL, 0);
+				break;
+			case 'e':
+				options.encoder = strtoul(optarg, NULL, 0) % SIM_ENCODERS;
+				break;
+			case 'E':
+				options.edge_us = strtoul(optarg, NULL, 0);
+				break;
+			case 'g':
+				options.gap_ms = strtoul(optarg, NULL, 0);
+				break;
+			case 'f':
+				options.feedback = strtoul(optarg, NULL, 0);
+				break;
+			case 'A':
+				options.animations = strtoul(optarg, NULL, 0) % (SIM_ENCODERS + 1);
+				break;
+			case 'c':
+				if (!read_cost(optarg)) {
+					usage(argv[0]);
+					return SIM_EXIT_ERROR;
+				}
+				break;
+			case 's':
+				options.seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'o':
+				options.csv_path = optarg;
+				break;
+			case 'S':
+				options.summary_path = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? SIM_EXIT_OK : SIM_EXIT_ERROR;
+		}
+	}
+
+	if (!options.trials || (uint64_t)options.edge_us * (EDGES_PER_DETENT - 1) >= TRIAL_TIMEOUT_MS * 1000UL) {
+		usage(argv[0]);
+		return SIM_EXIT_ERROR;
+	}
+
+	latency_us = calloc(options.trials, sizeof(uint32_t));
+	if (!latency_us) {
+		perror("latency");
+		return SIM_EXIT_ERROR;
+	}
+
+	for (uint8_t i=0;i<PROFILE_POINT_COUNT;++i) {
+		sim_set_profile_cost(i, profile_cost[i]);
+	}
+
+	sim_eeprom_open(NULL);
+	sim_set_frame_hook(on_frame);
+	usb_sim_set_in_hook(on_usb_in);
+
+	firmware_main();
+
+	return SIM_EXIT_OK;
+}
@@ -0,0 +1,572 @@
+/*
+ * powercut.c
+ *
+ * Created: 10/18/2026 11:41:26 PM
+ *
+ *  Power cut sweeps of configuration uploads. Each upload is a scenario,
+ *  see scenario.h, whose settings are sent to a freshly booted Twister.
+ *  It is first run through to count the EEPROM byte operations, or page
+ *  writes, it takes. Then for every one of those the upload is run again
+ *  on a new firmware with the power cut straight after it, see
+ *  sim_eeprom_set_power_cut(), and the EEPROM image left behind is booted
+ *  through config_init() and load_config() on another. That one must boot
+ *  and give back every setting in range over the configuration SysEx.
+ *
+ *  A setting which reads back as neither its value before the upload nor
+ *  the one pushed is torn. Torn settings are listed but are not a failure,
+ *  the firmware writes settings in place with no journal to go back to.
+ *
+ *  twister_powercut [options] UPLOAD...
+ *    -p, --pages             cut between page writes only, not between
+ *                            the erase and write of each byte
+ *    -v, --verbose           list the torn settings of every cut
+ *    -j, --jobs N            cuts tried at once, default one a CPU
+ *
+ *  The exit status is 1 if any cut leaves a Twister which does not boot or
+ *  has a setting out of range.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+#include "../scenario/scenario.h"
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "encoders.h"
+#include "gestures.h"
+#include "side_switch.h"
+
+// The first boot writes the factory settings, which is over by then
+#define FIRST_BOOT_MS		1000
+
+// Later boots start from the factory image, enumeration is over by then
+#define WARM_UP_MS			300
+
+// Torn settings listed for one cut
+#define MAX_TORN_SHOWN		8
+
+#define MAX_JOBS			64
+
+// Exit status of a cut's process
+#define CUT_OK				0
+#define CUT_TORN			1
+#define CUT_FAILED			2
+
+// The range a setting must read back in
+typedef struct {
+	uint8_t min;
+	uint8_t max;
+} setting_range_t;
+
+// In config_global_settings order
+static const setting_range_t global_ranges[CONFIG_GLOBAL_SETTINGS] = {
+	{1, 16},								// midi_channel
+	{0, 1},									// side_is_banked
+	{0, SIDE_SW_ACTION_COUNT - 1},			// side_func_1 to 6
+	{0, SIDE_SW_ACTION_COUNT - 1},
+	{0, SIDE_SW_ACTION_COUNT - 1},
+	{0, SIDE_SW_ACTION_COUNT - 1},
+	{0, SIDE_SW_ACTION_COUNT - 1},
+	{0, SIDE_SW_ACTION_COUNT - 1},
+	{0, 127},								// super_start
+	{0, 127},								// super_end
+	{0, 127},								// rgb_brightness
+	{0, 127},								// ind_brightness
+	{1, 127},								// gesture_double_tap
+	{1, 127},								// gesture_long_press
+	{1, 127},								// gesture_turn_steps
+	{0, 1},									// gesture_midi
+	{1, FINE_ADJUST_SHIFT_MAX},				// fine_shift
+	{1, 127},								// side_repeat_delay
+	{1, 127},								// side_repeat_rate
+	{1, 16},								// gesture_channel
+	{0, GESTURE_ACTION_COUNT - 1},			// tap to hold_turn action and number
+	{0, 127},
+	{0, GESTURE_ACTION_COUNT - 1},
+	{0, 127},
+	{0, GESTURE_ACTION_COUNT - 1},
+	{0, 127},
+	{0, GESTURE_ACTION_COUNT - 1},
+	{0, 127},
+};
+
+// In config_encoder_settings order
+static const setting_range_t encoder_ranges[CONFIG_ENCODER_SETTINGS] = {
+	{0, 1},									// has_detent
+	{DIRECT, EMULATION},					// movement
+	{CC_HOLD, ENC_SHIFT_TOGGLE},			// switch_action_type
+	{1, 16},								// switch_midi_channel
+	{0, 127},								// switch_midi_number
+	{0, 127},								// switch_midi_type
+	{1, 16},								// encoder_midi_channel
+	{0, 127},								// encoder_midi_number
+	{SEND_NOTE, SEND_REL_ENC},				// encoder_midi_type
+	{0, 127},								// active_color
+	{0, 127},								// inactive_color
+	{0, 127},								// detent_color
+	{DOT, BLENDED_DOT},						// indicator_display_type
+	{0, 1},									// is_super_knob
+	{0, 15},								// encoder_shift_midi_channel
+};
+
+typedef struct {
+	sim_nvm_unit_t unit;
+	bool           verbose;
+	uint32_t       jobs;
+} powercut_options_t;
+
+static powercut_options_t options = {
+	.unit = sim_nvm_bytes,
+};
+
+// Files shared with the firmware processes, each cut has its own
+static char work_dir[64];
+
+// Room for the working directory and the longest file name in it,
+// "/cut4294967295.eep"
+#define WORK_PATH_SIZE		(sizeof(work_dir) + 24)
+
+static char factory_path[WORK_PATH_SIZE];
+static char image_path[WORK_PATH_SIZE];
+static char config_path[WORK_PATH_SIZE];
+static char counts_path[WORK_PATH_SIZE];
+
+// What the firmware process does
+static const scenario_t* upload;
+static uint32_t          cut_point;
+static twister_config_t  config;
+static uint32_t          start_count[2];
+
+static void exit_with_config(void)
+{
+	sim_exit(config_write_syx(&config, config_path) ? SIM_EXIT_OK : SIM_EXIT_ERROR);
+}
+
+static void read_config(void)
+{
+	scenario_read_config(&config, exit_with_config);
+}
+
+/**
+ * Saves the counts the upload took, then reads back what it left.
+ */
+
+static void counted(void)
+{
+	FILE* file = fopen(counts_path, "w");
+	if (!file) {
+		perror(counts_path);
+		sim_exit(SIM_EXIT_ERROR);
+	}
+
+	fprintf(file, "%u %u\n", sim_eeprom_count(sim_nvm_bytes) - start_count[sim_nvm_bytes],
+	        sim_eeprom_count(sim_nvm_pages) - start_count[sim_nvm_pages]);
+	for (uint8_t page=0;page<EEPROM_SIZE / EEPROM_PAGE_SIZE;++page) {
+		fprintf(file, "%u\n", sim_eeprom_page_wear(page));
+	}
+	fclose(file);
+
+	read_config();
+}
+
+static void start_upload(void)
+{
+	start_count[sim_nvm_bytes] = sim_eeprom_count(sim_nvm_bytes);
+	start_count[sim_nvm_pages] = sim_eeprom_count(sim_nvm_pages);
+	scenario_play(upload, NULL, NULL, counted);
+}
+
+static void power_lost(void)
+{
+	sim_exit(SIM_EXIT_OK);
+}
+
+static void not_cut(void)
+{
+	fprintf(stderr, "%s: the upload finished before the cut\n", upload->name);
+	sim_exit(SIM_EXIT_ERROR);
+}
+
+static void start_cut_upload(void)
+{
+	sim_eeprom_set_power_cut(options.unit, sim_eeprom_count(options.unit) + cut_point, power_lost);
+	scenario_play(upload, NULL, NULL, not_cut);
+}
+
+/**
+ * Copies one EEPROM image over another.
+ */
+
+static bool copy_image(const char* from, const char* to)
+{
+	FILE* in  = fopen(from, "rb");
+	FILE* out = fopen(to, "wb");
+	uint8_t image[EEPROM_SIZE];
+
+	bool ok = in && out && fread(image, 1, sizeof(image), in) == sizeof(image) &&
+	          fwrite(image, 1, sizeof(image), out) == sizeof(image);
+
+	if (in) {
+		fclose(in);
+	}
+	if (out && fclose(out)) {
+		ok = false;
+	}
+	if (!ok) {
+		perror(to);
+	}
+	return ok;
+}
+
+/**
+ * Runs the firmware in a process of its own on the EEPROM image, with
+ * the given hook called once it has warmed up.
+ *
+ * \return true if it exited with SIM_EXIT_OK
+ */
+
+static bool run_firmware(uint32_t warm_up_ms, sim_event_hook_t hook)
+{
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("powercut");
+		return false;
+	}
+
+	if (!pid) {
+		if (!sim_eeprom_open(image_path)) {
+			exit(SIM_EXIT_ERROR);
+		}
+		sim_schedule((uint64_t)warm_up_ms * SIM_CYCLES_PER_MS, hook);
+		firmware_main();
+		exit(SIM_EXIT_ERROR);
+	}
+
+	int status;
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("powercut");
+		return false;
+	}
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == SIM_EXIT_OK;
+}
+
+/**
+ * Lists the settings read back out of range, and counts those which are
+ * neither as before nor as pushed.
+ *
+ * \return the number out of range
+ */
+
+static uint32_t check_config(const twister_config_t* before, const twister_config_t* after,
+                             const twister_config_t* cut, uint32_t* torn, const char* cut_name)
+{
+	uint32_t invalid = 0;
+	uint32_t shown = 0;
+
+	*torn = 0;
+
+	for (int16_t e=-1;e<CONFIG_ENCODERS;++e) {
+		const config_setting_t* settings = e < 0 ? config_global_settings : config_encoder_settings;
+		const setting_range_t*  ranges   = e < 0 ? global_ranges : encoder_ranges;
+		uint8_t count = e < 0 ? CONFIG_GLOBAL_SETTINGS : CONFIG_ENCODER_SETTINGS;
+
+		const uint8_t* was = e < 0 ? before->global : before->encoder[e];
+		const uint8_t* now = e < 0 ? after->global : after->encoder[e];
+		const uint8_t* got = e < 0 ? cut->global : cut->encoder[e];
+
+		char target[CONFIG_TARGET_NAME_SIZE] = "global";
+		if (e >= 0) {
+			config_target_name(e, target);
+		}
+
+		for (uint8_t i=0;i<count;++i) {
+			if (got[i] < ranges[i].min || got[i] > ranges[i].max) {
+				printf("  %s: %s %s is %u, out of range\n", cut_name, target, settings[i].name, got[i]);
+				invalid++;
+			} else if (got[i] != was[i] && got[i] != now[i]) {
+				if (options.verbose && shown++ < MAX_TORN_SHOWN) {
+					printf("  %s: %s %s is %u, was %u then %u\n", cut_name, target, settings[i].name,
+					       got[i], was[i], now[i]);
+				}
+				(*torn)++;
+			}
+		}
+	}
+
+	return invalid;
+}
+
+static void cut_paths(uint32_t cut, char* image, char* config, char* report)
+{
+	snprintf(image, WORK_PATH_SIZE, "%s/cut%u.eep", work_dir, cut);
+	snprintf(config, WORK_PATH_SIZE, "%s/cut%u.syx", work_dir, cut);
+	snprintf(report, WORK_PATH_SIZE, "%s/cut%u.txt", work_dir, cut);
+}
+
+/**
+ * Cuts the power after the given operation of the upload, then boots what
+ * is left and checks it, in a process of its own which reports to a file.
+ *
+ * \return the process, or -1 if it could not be started
+ */
+
+static pid_t start_cut(uint32_t cut, const twister_config_t* before, const twister_config_t* after)
+{
+	static twister_config_t left;
+	char report[WORK_PATH_SIZE];
+
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid) {
+		if (pid < 0) {
+			perror("powercut");
+		}
+		return pid;
+	}
+
+	cut_paths(cut, image_path, config_path, report);
+	cut_point = cut;
+
+	int fd = open(report, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(report);
+		exit(CUT_FAILED);
+	}
+	dup2(fd, STDOUT_FILENO);
+	dup2(fd, STDERR_FILENO);
+	close(fd);
+
+	char cut_name[32];
+	snprintf(cut_name, sizeof(cut_name), "%s %u", options.unit == sim_nvm_pages ? "page" : "byte", cut);
+
+	if (!copy_image(factory_path, image_path) || !run_firmware(WARM_UP_MS, start_cut_upload)) {
+		printf("  %s: the upload did not reach the cut\n", cut_name);
+		exit(CUT_FAILED);
+	}
+
+	// Powered up again on what was left
+	if (!run_firmware(WARM_UP_MS, read_config) || !config_read_syx(&left, config_path)) {
+		printf("  %s: the Twister did not come back\n", cut_name);
+		exit(CUT_FAILED);
+	}
+
+	uint32_t torn;
+	if (check_config(before, after, &left, &torn, cut_name)) {
+		exit(CUT_FAILED);
+	}
+	exit(torn ? CUT_TORN : CUT_OK);
+}
+
+/**
+ * Waits for a cut's process and passes on its report.
+ *
+ * \return CUT_OK, CUT_TORN or CUT_FAILED
+ */
+
+static uint8_t finish_cut(uint32_t cut, pid_t pid)
+{
+	char image[WORK_PATH_SIZE], config[WORK_PATH_SIZE], report[WORK_PATH_SIZE];
+	int status;
+
+	cut_paths(cut, image, config, report);
+
+	uint8_t result = CUT_FAILED;
+	if (pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) <= CUT_FAILED) {
+		result = WEXITSTATUS(status);
+	}
+
+	FILE* file = fopen(report, "r");
+	if (file) {
+		char line[256];
+		while (fgets(line, sizeof(line), file)) {
+			fputs(line, stdout);
+		}
+		fclose(file);
+	}
+
+	unlink(image);
+	unlink(config);
+	unlink(report);
+	return result;
+}
+
+/**
+ * Counts an upload's EEPROM operations, then cuts the power after each
+ * in turn and checks what boots from what is left.
+ *
+ * \return true if every cut left a Twister which boots in range
+ */
+
+static bool sweep_upload(const char* path)
+{
+	static scenario_t scenario;
+	static twister_config_t before, after;
+
+	if (!scenario_read(&scenario, path)) {
+		return false;
+	}
+	upload = &scenario;
+
+	// The factory settings, which every run after starts from, then the
+	// upload run through
+	unlink(image_path);
+	bool ok = run_firmware(FIRST_BOOT_MS, read_config) && config_read_syx(&before, config_path) &&
+	          copy_image(image_path, factory_path);
+
+	ok = ok && copy_image(factory_path, image_path) &&
+	     run_firmware(WARM_UP_MS, start_upload) && config_read_syx(&after, config_path);
+
+	uint32_t counts[2] = {0};
+	uint32_t most_worn = 0, most_worn_page = 0;
+	FILE* file = ok ? fopen(counts_path, "r") : NULL;
+
+	if (file) {
+		ok = fscanf(file, "%u %u", &counts[sim_nvm_bytes], &counts[sim_nvm_pages]) == 2;
+		for (uint32_t page=0, wear;fscanf(file, "%u", &wear) == 1;++page) {
+			if (wear > most_worn) {
+				most_worn      = wear;
+				most_worn_page = page;
+			}
+		}
+		fclose(file);
+	}
+
+	if (!ok) {
+		fprintf(stderr, "%s: the upload did not run through\n", scenario.name);
+		scenario_free(&scenario);
+		return false;
+	}
+
+	printf("%s: %u byte operations in %u page writes, page %u written most, %u times since boot\n",
+	       scenario.name, counts[sim_nvm_bytes], counts[sim_nvm_pages], most_worn_page, most_worn);
+
+	uint32_t failures = 0;
+	uint32_t torn_cuts = 0;
+
+	// Cuts run in processes of their own, their reports are taken in
+	// order so the output does not depend on the number of jobs
+	pid_t jobs[MAX_JOBS];
+	uint32_t total = counts[options.unit];
+	uint32_t next = 1;
+
+	for (uint32_t done=1;done<=total;++done) {
+		while (next <= total && next - done < options.jobs) {
+			jobs[next % options.jobs] = start_cut(next, &before, &after);
+			next++;
+		}
+
+		uint8_t result = finish_cut(done, jobs[done % options.jobs]);
+		failures  += result == CUT_FAILED;
+		torn_cuts += result == CUT_TORN;
+	}
+
+	printf("%s: %u cuts, %u failed, %u left torn settings\n", scenario.name,
+	       counts[options.unit], failures, torn_cuts);
+
+	scenario_free(&scenario);
+	return !failures;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options] UPLOAD...\n"
+	        "  -p, --pages             cut between page writes only\n"
+	        "  -v, --verbose           list the torn settings of every cut\n"
+	        "  -j, --jobs N            cuts tried at once\n",
+	        name);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option long_options[] = {
+		{"pages",   no_argument,       NULL, 'p'},
+		{"verbose", no_argument,       NULL, 'v'},
+		{"jobs",    required_argument, NULL, 'j'},
+		{"help",    no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "pvj:h", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'p':
+				options.unit = sim_nvm_pages;
+				break;
+			case 'v':
+				options.verbose = true;
+				break;
+			case 'j':
+				options.jobs = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? SIM_EXIT_OK : SIM_EXIT_ERROR;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return SIM_EXIT_ERROR;
+	}
+
+	if (!options.jobs) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		options.jobs = cpus > 0 ? cpus : 1;
+	}
+	if (options.jobs > MAX_JOBS) {
+		options.jobs = MAX_JOBS;
+	}
+
+	snprintf(work_dir, sizeof(work_dir), "/tmp/twister_powercut.XXXXXX");
+	if (!mkdtemp(work_dir)) {
+		perror("powercut");
+		return SIM_EXIT_ERROR;
+	}
+
+	snprintf(factory_path, sizeof(factory_path), "%s/factory.eep", work_dir);
+	snprintf(image_path, sizeof(image_path), "%s/twister.eep", work_dir);
+	snprintf(config_path, sizeof(config_path), "%s/config.syx", work_dir);
+	snprintf(counts_path, sizeof(counts_path), "%s/counts", work_dir);
+
+	int status = SIM_EXIT_OK;
+
+	for (int i=optind;i<argc;++i) {
+		if (!sweep_upload(argv[i])) {
+			status = SIM_EXIT_ERROR;
+		}
+	}
+
+	unlink(factory_path);
+	unlink(image_path);
+	unlink(config_path);
+	unlink(counts_path);
+	rmdir(work_dir);
+
+	return status;
+}
@@ -0,0 +1,494 @@
+/*
+ * replay.c
+ *
+ * Created: 10/18/2026 2:06:33 PM
+ *
+ *  Replays raw input captures into the firmware and checks the MIDI it
+ *  sends. A capture is the diagnostics input capture dump, see
+ *  diagnostics.c, saved as the Twister sends it, for example with
+ *
+ *    amidi -p hw:1 -S 'F0 00 01 79 05 01 00 F7' -r capture.syx -t 1
+ *
+ *  Each capture is played into a freshly booted firmware with the factory
+ *  settings. The encoder, switch and side switch levels of every sample
+ *  are set on the simulated hardware the recorded number of 32 uS ticks
+ *  after the sample before, so the decode, the encoder settings and the
+ *  MIDI out all see the input as the Twister did. The inputs start at
+ *  rest, so a capture should be cleared with the Twister at rest and hold
+ *  fewer samples than the ring, or its first samples may move encoders
+ *  which were not moved.
+ *
+ *  The MIDI sent is compared with the NAME.golden file next to the
+ *  capture as twister_golden does, in mS from the first sample.
+ *
+ *  twister_replay [options] CAPTURE...
+ *    -u, --update            write the golden files from this run
+ *    -s, --slack MS          time two matching messages may be apart,
+ *                            default 2
+ *    -r, --record SCENARIO   play the scenario, which must not change any
+ *                            settings, and save the capture the firmware
+ *                            took of it as CAPTURE
+ *
+ *  The exit status is 1 if any capture's output differs.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+#include "../golden/golden_file.h"
+#include "../scenario/scenario.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "config.h"
+
+// Boot, enumeration and the start up animation are over by then
+#define WARM_UP_MS			1000
+
+// Time after the last sample for the output it caused
+#define SETTLE_MS			500
+
+// Time the firmware has to send the dump of a recording
+#define DUMP_MS				200
+
+#define CAPTURE_TICK_US		32
+#define CAPTURE_ENCODERS	16
+#define CAPTURE_SIDE_SWITCHES	6
+
+// A dump message holding a sample, from F0 to F7
+#define DUMP_LENGTH			23
+
+typedef struct {
+	input_sample_t samples[INPUT_CAPTURE_SIZE];
+	uint8_t        count;
+} capture_t;
+
+typedef struct {
+	bool        update;
+	uint32_t    slack_ms;
+	const char* record;
+} replay_options_t;
+
+static replay_options_t options = {
+	.slack_ms = 2,
+};
+
+static const uint8_t dump_header[] = {
+	0xF0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7F,
+	SYSEX_COMMAND_DIAGNOSTICS, DIAG_INPUT_CAPTURE, DIAG_CAPTURE_DUMP,
+};
+
+static uint16_t unpack_u16(const uint8_t* src)
+{
+	return src[0] | (src[1] << 7) | ((uint16_t)src[2] << 14);
+}
+
+/**
+ * Reads a capture from the dump messages in a SysEx file. Anything else
+ * in the file is skipped, the samples must all be there once.
+ *
+ * \return false, with a message, if the file holds no whole capture
+ */
+
+static bool read_capture(capture_t* capture, const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		perror(path);
+		return false;
+	}
+
+	uint8_t  message[DUMP_LENGTH];
+	uint16_t length = 0;
+	int16_t  total = -1;
+	uint64_t seen = 0;
+	int      c;
+
+	while ((c = fgetc(file)) != EOF) {
+		if (c == 0xF0) {
+			length = 0;
+		}
+		if (length < sizeof(message)) {
+			message[length] = c;
+		}
+		length++;
+
+		if (c != 0xF7) {
+			continue;
+		}
+
+		// An empty capture is the header, its index and total 0 then F7
+		if (length < sizeof(dump_header) + 3 ||
+		    memcmp(message, dump_header, sizeof(dump_header))) {
+			continue;
+		}
+
+		uint8_t index = message[7];
+		total = message[8];
+
+		if (total > INPUT_CAPTURE_SIZE || (total && length != DUMP_LENGTH) || index >= INPUT_CAPTURE_SIZE) {
+			fprintf(stderr, "%s: a dump message is not whole\n", path);
+			fclose(file);
+			return false;
+		}
+
+		if (total) {
+			input_sample_t* sample = &capture->samples[index];
+			sample->ticks       = unpack_u16(&message[9]);
+			sample->enc_switch  = unpack_u16(&message[12]);
+			sample->cha         = unpack_u16(&message[15]);
+			sample->chb         = unpack_u16(&message[18]);
+			sample->side_switch = message[21];
+			seen |= 1ULL << index;
+		}
+	}
+
+	fclose(file);
+
+	if (total < 0) {
+		fprintf(stderr, "%s: holds no input capture dump\n", path);
+		return false;
+	}
+
+	uint64_t all = total == INPUT_CAPTURE_SIZE ? ~0ULL : (1ULL << total) - 1;
+	if ((seen & all) != all) {
+		fprintf(stderr, "%s: samples are missing from the dump\n", path);
+		return false;
+	}
+
+	capture->count = total;
+	return true;
+}
+
+static const capture_t* child_capture;
+static FILE*            child_output;
+static uint8_t          next_sample;
+static uint64_t         start_us;
+
+static void on_message(const uint8_t* data, uint16_t length)
+{
+	golden_print(child_output, sim_get_time_us() - start_us, data, length);
+}
+
+static void on_done(void)
+{
+	sim_exit(SIM_EXIT_OK);
+}
+
+/**
+ * Sets the inputs to a sample's levels, then waits out the ticks to the
+ * next one.
+ */
+
+static void play_sample(void)
+{
+	const input_sample_t* sample = &child_capture->samples[next_sample++];
+
+	for (uint8_t i=0;i<CAPTURE_ENCODERS;++i) {
+		uint16_t bit = 0x01 << i;
+		sim_encoder_levels(i, sample->cha & bit, sample->chb & bit);
+		sim_encoder_switch(i, sample->enc_switch & bit);
+	}
+
+	for (uint8_t i=0;i<CAPTURE_SIDE_SWITCHES;++i) {
+		sim_side_switch(i, sample->side_switch & (0x01 << i));
+	}
+
+	if (next_sample < child_capture->count) {
+		uint64_t wait_us = (uint64_t)child_capture->samples[next_sample].ticks * CAPTURE_TICK_US;
+		sim_schedule(sim_get_cycles() + wait_us * SIM_CYCLES_PER_US, play_sample);
+	} else {
+		sim_schedule(sim_get_cycles() + (uint64_t)SETTLE_MS * SIM_CYCLES_PER_MS, on_done);
+	}
+}
+
+/**
+ * The first sample is played at once, its ticks count from when the
+ * capture was cleared.
+ */
+
+static void start_replay(void)
+{
+	start_us = sim_get_time_us();
+	sim_set_midi_out_hook(on_message);
+
+	if (child_capture->count) {
+		play_sample();
+	} else {
+		sim_schedule(sim_get_cycles() + (uint64_t)SETTLE_MS * SIM_CYCLES_PER_MS, on_done);
+	}
+}
+
+/**
+ * Forks a firmware of its own and runs 'start' in it once it is warmed
+ * up, as twister_golden does.
+ *
+ * \return true if it ran through
+ */
+
+static bool run_firmware(const char* name, sim_event_hook_t start)
+{
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("replay");
+		return false;
+	}
+
+	if (!pid) {
+		sim_eeprom_open(NULL);
+		sim_schedule((uint64_t)WARM_UP_MS * SIM_CYCLES_PER_MS, start);
+		firmware_main();
+		exit(SIM_EXIT_ERROR);
+	}
+
+	int status;
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("replay");
+		return false;
+	}
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != SIM_EXIT_OK) {
+		fprintf(stderr, "%s: the firmware stopped before the end\n", name);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * A capture's name, its file's less the directory and extension.
+ */
+
+static void capture_name(const char* path, char* name, size_t size)
+{
+	const char* slash = strrchr(path, '/');
+	snprintf(name, size, "%s", slash ? slash + 1 : path);
+
+	char* dot = strrchr(name, '.');
+	if (dot && dot != name) {
+		*dot = '\0';
+	}
+}
+
+/**
+ * Replays one capture and checks or writes its golden file.
+ *
+ * \return true if it ran and matched, or its golden file was written
+ */
+
+static bool test_capture(const char* path)
+{
+	capture_t capture = {0};
+	if (!read_capture(&capture, path)) {
+		return false;
+	}
+
+	char name[SCENARIO_MAX_NAME];
+	capture_name(path, name, sizeof(name));
+
+	char golden[512];
+	golden_path(path, golden, sizeof(golden));
+
+	child_capture = &capture;
+	child_output  = tmpfile();
+	next_sample   = 0;
+
+	FILE* output = child_output;
+	bool ok = output && run_firmware(name, start_replay);
+
+	if (ok) {
+		rewind(output);
+
+		if (options.update) {
+			char comment[128];
+			snprintf(comment, sizeof(comment),
+			         "twister_replay %s: mS from the first sample, then the MIDI sent", name);
+
+			ok = golden_write(golden, comment, output);
+			if (ok) {
+				printf("%s: wrote %s\n", name, golden);
+			}
+		} else {
+			ok = golden_check(name, golden, output, options.slack_ms);
+		}
+	}
+
+	if (output) {
+		fclose(output);
+	}
+	return ok;
+}
+
+// Recording ------------------------------------------------------------------
+
+static const scenario_t* record_scenario;
+
+static void on_dump(const uint8_t* data, uint16_t length)
+{
+	if (length && data[0] == 0xF0) {
+		fwrite(data, 1, length, child_output);
+	}
+}
+
+static void send_capture_request(uint8_t op)
+{
+	const uint8_t request[] = {
+		0xF0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7F,
+		SYSEX_COMMAND_DIAGNOSTICS, DIAG_INPUT_CAPTURE, op, 0xF7,
+	};
+
+	if (sim_midi_in(request, sizeof(request)) != sizeof(request)) {
+		fprintf(stderr, "%s: the firmware did not take the capture request\n", record_scenario->name);
+		sim_exit(SIM_EXIT_ERROR);
+	}
+}
+
+static void finish_recording(void)
+{
+	fflush(child_output);
+	sim_exit(SIM_EXIT_OK);
+}
+
+static void dump_capture(void)
+{
+	sim_set_midi_out_hook(on_dump);
+	send_capture_request(DIAG_CAPTURE_DUMP);
+	sim_schedule(sim_get_cycles() + (uint64_t)DUMP_MS * SIM_CYCLES_PER_MS, finish_recording);
+}
+
+static void clear_capture(void)
+{
+	send_capture_request(DIAG_CAPTURE_CLEAR);
+}
+
+static void start_recording(void)
+{
+	scenario_play(record_scenario, clear_capture, NULL, dump_capture);
+}
+
+/**
+ * Plays a scenario and saves the capture the firmware took of it. A
+ * capture which filled the ring may have lost its start, so is refused.
+ */
+
+static bool record_capture(const char* script, const char* path)
+{
+	scenario_t* scenario = malloc(sizeof(scenario_t));
+	if (!scenario || !scenario_read(scenario, script)) {
+		free(scenario);
+		return false;
+	}
+
+	bool ok = !scenario->has_settings;
+	if (!ok) {
+		fprintf(stderr, "%s: captures are replayed with the factory settings, "
+		        "the scenario must not change them\n", scenario->name);
+	}
+
+	if (ok) {
+		record_scenario = scenario;
+		child_output    = fopen(path, "wb");
+		if (!child_output) {
+			perror(path);
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		ok = run_firmware(scenario->name, start_recording);
+		ok = !fclose(child_output) && ok;
+	}
+
+	capture_t capture = {0};
+	if (ok && (ok = read_capture(&capture, path))) {
+		if (capture.count == INPUT_CAPTURE_SIZE) {
+			fprintf(stderr, "%s: the capture filled the ring, shorten the scenario\n", scenario->name);
+			ok = false;
+		} else {
+			printf("%s: wrote %u samples to %s\n", scenario->name, capture.count, path);
+		}
+	}
+
+	scenario_free(scenario);
+	free(scenario);
+	return ok;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options] CAPTURE...\n"
+	        "  -u, --update            write the golden files from this run\n"
+	        "  -s, --slack MS          time two matching messages may be apart\n"
+	        "  -r, --record SCENARIO   save the capture of a scenario as CAPTURE\n",
+	        name);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option long_options[] = {
+		{"update", no_argument,       NULL, 'u'},
+		{"slack",  required_argument, NULL, 's'},
+		{"record", required_argument, NULL, 'r'},
+		{"help",   no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "us:r:h", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'u':
+				options.update = true;
+				break;
+			case 's':
+				options.slack_ms = strtoul(optarg, NULL, 0);
+				break;
+			case 'r':
+				options.record = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? SIM_EXIT_OK : SIM_EXIT_ERROR;
+		}
+	}
+
+	if (optind == argc || (options.record && argc - optind != 1)) {
+		usage(argv[0]);
+		return SIM_EXIT_ERROR;
+	}
+
+	if (options.record) {
+		return record_capture(options.record, argv[optind]) ? SIM_EXIT_OK : SIM_EXIT_ERROR;
+	}
+
+	int status = SIM_EXIT_OK;
+
+	for (int i=optind;i<argc;++i) {
+		if (!test_capture(argv[i])) {
+			status = SIM_EXIT_ERROR;
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,665 @@
+/*
+ * scenario.c
+ *
+ * Created: 10/18/2026 10:26:50 PM
+ *
+ *  Scripted scenarios for the host tools, see scenario.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "scenario.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+
+// Quiet time after the settings are in and after the last step, so
+// nothing either started is still going when the steps or the next
+// scenario begin
+#define SETTLE_MS			100
+
+// Time the firmware has to answer each settings message
+#define SETTINGS_TIMEOUT_MS	2000
+
+#define EDGES_PER_DETENT	4
+
+// MIDI clock ticks to a beat
+#define CLOCK_PPQN			24
+
+#define SIDE_SWITCHES		6
+
+// Longest MIDI message put back together from the firmware's output
+#define MAX_MESSAGE			256
+
+#define SYSEX_START			0xF0
+#define SYSEX_EOX			0xF7
+
+typedef enum {
+	step_encoder,
+	step_press,
+	step_release,
+	step_side_press,
+	step_side_release,
+	step_midi,
+	step_host_hold,
+	step_host_read,
+} step_type_t;
+
+typedef enum {
+	play_idle,
+	play_pulling,			// Waiting for the global settings
+	play_pushing,			// Waiting for the reply to the global push
+	play_settling,
+	play_running,
+	play_reading,			// Waiting for every setting to come back
+} play_state_t;
+
+static const scenario_t*   playing;
+static play_state_t        state;
+static sim_event_hook_t    started_hook;
+static scenario_midi_hook_t midi_hook;
+static sim_event_hook_t    done_hook;
+static uint32_t            next_step;
+static uint64_t            start_us;
+static uint64_t            deadline_us;
+
+// Settings messages for the firmware, sent as it has room
+static uint8_t*            outgoing;
+static uint32_t            outgoing_length;
+static uint32_t            outgoing_sent;
+static uint32_t            outgoing_capacity;
+
+// The firmware's output, put back together into messages
+static uint8_t             message[MAX_MESSAGE];
+static uint16_t            message_length;
+static uint16_t            message_expected;
+static bool                message_corrupt;
+static bool                global_reply;
+static twister_config_t    reply;
+
+// Settings being read back
+static twister_config_t*   read_config;
+static uint8_t             read_count;
+
+static void run_steps(void);
+
+static void* grow(void* buffer, uint32_t* capacity, uint32_t needed, size_t size)
+{
+	if (needed <= *capacity) {
+		return buffer;
+	}
+
+	while (*capacity < needed) {
+		*capacity = *capacity ? *capacity * 2 : 256;
+	}
+
+	buffer = realloc(buffer, *capacity * size);
+	if (!buffer) {
+		perror("scenario");
+		exit(SIM_EXIT_ERROR);
+	}
+	return buffer;
+}
+
+static scenario_step_t* add_step(scenario_t* s, uint64_t at_us, step_type_t type)
+{
+	s->steps = grow(s->steps, &s->capacity, s->count + 1, sizeof(scenario_step_t));
+
+	scenario_step_t* step = &s->steps[s->count];
+	memset(step, 0x00, sizeof(scenario_step_t));
+	step->at_us = at_us;
+	step->order = s->count++;
+	step->type  = type;
+
+	if (at_us > s->length_us) {
+		s->length_us = at_us;
+	}
+
+	return step;
+}
+
+static void add_midi(scenario_t* s, uint64_t at_us, const uint8_t* data, uint8_t length)
+{
+	scenario_step_t* step = add_step(s, at_us, step_midi);
+	step->length = length;
+	memcpy(step->data, data, length);
+}
+
+static int compare_steps(const void* a, const void* b)
+{
+	const scenario_step_t* x = a;
+	const scenario_step_t* y = b;
+
+	if (x->at_us != y->at_us) {
+		return x->at_us < y->at_us ? -1 : 1;
+	}
+	return x->order < y->order ? -1 : x->order > y->order;
+}
+
+/**
+ * Reads the NAME=VALUE settings of a global or encoder line.
+ *
+ * \return false if a setting is not known or out of range
+ */
+
+static bool read_settings(scenario_t* s, const char* args)
+{
+	char target_name[16];
+	int target;
+	int used;
+
+	if (sscanf(args, "%15s%n", target_name, &used) != 1 || !config_parse_target(target_name, &target)) {
+		return false;
+	}
+	args += used;
+
+	const config_setting_t* settings = target < 0 ? config_global_settings : config_encoder_settings;
+	uint8_t count = target < 0 ? CONFIG_GLOBAL_SETTINGS : CONFIG_ENCODER_SETTINGS;
+
+	char pair[80];
+	bool any = false;
+
+	while (sscanf(args, "%79s%n", pair, &used) == 1) {
+		char name[64];
+		unsigned value;
+		int setting;
+
+		args += used;
+
+		if (sscanf(pair, "%63[^=]=%u", name, &value) != 2 ||
+		    (setting = config_find_setting(settings, count, name)) < 0 || value > 0x7F) {
+			return false;
+		}
+
+		if (target < 0) {
+			s->global_set[setting] = true;
+			s->settings.global[setting] = value;
+		} else {
+			s->settings.has_encoder[target] = true;
+			s->settings.encoder[target][setting] = value;
+		}
+		any = true;
+	}
+
+	s->has_settings |= any;
+	return any;
+}
+
+bool scenario_read(scenario_t* s, const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		return false;
+	}
+
+	memset(s, 0x00, sizeof(scenario_t));
+	memset(s->settings.encoder, CONFIG_UNSET, sizeof(s->settings.encoder));
+
+	// The name is the file's, less any directory and extension
+	const char* base = strrchr(path, '/');
+	snprintf(s->name, sizeof(s->name), "%s", base ? base + 1 : path);
+	char* dot = strrchr(s->name, '.');
+	if (dot) {
+		*dot = '\0';
+	}
+
+	char line[256];
+	uint32_t line_number = 0;
+	uint64_t now_us = 0;
+	bool ok = true;
+
+	while (ok && fgets(line, sizeof(line), file)) {
+		line_number++;
+
+		char* hash = strchr(line, '#');
+		if (hash) {
+			*hash = '\0';
+		}
+
+		char command[16];
+		int used;
+		if (sscanf(line, "%15s%n", command, &used) != 1) {
+			continue;
+		}
+		const char* args = line + used;
+
+		int a, b, c;
+
+		if (!strcmp(command, "global")) {
+			// The command is its own target
+			ok = read_settings(s, line);
+		} else if (!strcmp(command, "encoder")) {
+			ok = read_settings(s, args);
+		} else if (!strcmp(command, "wait") && sscanf(args, "%d", &a) == 1 && a >= 0) {
+			now_us += (uint64_t)a * 1000;
+		} else if (!strcmp(command, "turn") && sscanf(args, "%d %d %d", &a, &b, &c) == 3 &&
+		           a >= 0 && a < SIM_ENCODERS && c > 0) {
+			uint32_t edges = abs(b) * EDGES_PER_DETENT;
+			for (uint32_t i=0;i<edges;++i) {
+				scenario_step_t* step = add_step(s, now_us + (uint64_t)i * c, step_encoder);
+				step->target    = a;
+				step->direction = b < 0 ? -1 : 1;
+			}
+		} else if ((!strcmp(command, "press") || !strcmp(command, "release")) &&
+		           sscanf(args, " side %d", &a) == 1) {
+			if (a < 1 || a > SIDE_SWITCHES) {
+				ok = false;
+			} else {
+				scenario_step_t* step = add_step(s, now_us, command[0] == 'p' ? step_side_press : step_side_release);
+				step->target = a - 1;
+			}
+		} else if ((!strcmp(command, "press") || !strcmp(command, "release")) &&
+		           sscanf(args, "%d", &a) == 1 && a >= 0 && a < SIM_ENCODERS) {
+			scenario_step_t* step = add_step(s, now_us, command[0] == 'p' ? step_press : step_release);
+			step->target = a;
+		} else if (!strcmp(command, "midi")) {
+			uint8_t data[3];
+			uint8_t length = 0;
+			unsigned int value;
+			while (length < sizeof(data) && sscanf(args, "%x%n", &value, &used) == 1 && value <= 0xFF) {
+				data[length++] = value;
+				args += used;
+			}
+			if (!length || sscanf(args, "%x", &value) == 1) {
+				ok = false;
+			} else {
+				add_midi(s, now_us, data, length);
+			}
+		} else if (!strcmp(command, "feedback") && sscanf(args, "%d %d", &a, &b) == 2 && a >= 0 && b > 0) {
+			for (int i=0;i<a;++i) {
+				uint8_t data[] = {0xB0 | ENCODER_ROTARY_CHANNEL, i % 16, (i * 13) & 0x7F};
+				add_midi(s, now_us + (uint64_t)i * 1000000 / b, data, sizeof(data));
+			}
+		} else if (!strcmp(command, "clock") && sscanf(args, "%d %d", &a, &b) == 2 && a >= 0 && b > 0) {
+			for (int i=0;i<a;++i) {
+				uint8_t data[] = {0xF8};
+				add_midi(s, now_us + (uint64_t)i * 60000000 / (b * CLOCK_PPQN), data, sizeof(data));
+			}
+		} else if (!strcmp(command, "host") && sscanf(args, "%15s", command) == 1 &&
+		           (!strcmp(command, "hold") || !strcmp(command, "read"))) {
+			add_step(s, now_us, command[0] == 'h' ? step_host_hold : step_host_read);
+		} else {
+			ok = false;
+		}
+	}
+
+	if (!ok) {
+		fprintf(stderr, "%s:%u: not understood\n", path, line_number);
+	}
+
+	// A trailing wait still counts
+	if (now_us > s->length_us) {
+		s->length_us = now_us;
+	}
+
+	fclose(file);
+
+	// A script of settings alone has no steps to sort
+	if (s->count) {
+		qsort(s->steps, s->count, sizeof(scenario_step_t), compare_steps);
+	}
+	return ok;
+}
+
+void scenario_free(scenario_t* s)
+{
+	free(s->steps);
+	s->steps    = NULL;
+	s->count    = 0;
+	s->capacity = 0;
+}
+
+static void queue_message(const uint8_t* data, size_t length)
+{
+	outgoing = grow(outgoing, &outgoing_capacity, outgoing_length + length, 1);
+	memcpy(&outgoing[outgoing_length], data, length);
+	outgoing_length += length;
+}
+
+/**
+ * Queues the encoder settings then the global push, which has the
+ * firmware load them all. Globals the scenario leaves alone keep the
+ * values just pulled.
+ */
+
+static void queue_settings(void)
+{
+	const scenario_t* s = playing;
+	twister_config_t config = reply;
+	uint8_t data[CONFIG_MAX_MESSAGE];
+	size_t length;
+
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		if (!s->settings.has_encoder[i]) {
+			continue;
+		}
+		for (uint8_t part=1;(length = config_build_encoder_push(i, s->settings.encoder[i], part, data));++part) {
+			queue_message(data, length);
+		}
+	}
+
+	for (uint8_t i=0;i<CONFIG_GLOBAL_SETTINGS;++i) {
+		if (s->global_set[i]) {
+			config.global[i] = s->settings.global[i];
+		}
+	}
+
+	queue_message(data, config_build_global_push(&config, data));
+}
+
+/**
+ * Hands a whole message from the firmware on, to the settings while they
+ * are sent and to the scenario's hook once the steps have started.
+ */
+
+static void take_message(const uint8_t* data, uint16_t length)
+{
+	if (state == play_running) {
+		if (midi_hook) {
+			midi_hook(sim_get_time_us() - start_us, data, length);
+		}
+		return;
+	}
+
+	uint8_t encoder;
+
+	if (state == play_reading) {
+		if (config_parse_message(read_config, data, length, &encoder) == config_msg_encoder) {
+			read_count++;
+		}
+		return;
+	}
+
+	if ((state == play_pulling || state == play_pushing) &&
+	    config_parse_message(&reply, data, length, &encoder) == config_msg_global) {
+		global_reply = true;
+	}
+}
+
+/**
+ * Expected length of a message from its status byte, 0 for SysEx.
+ */
+
+static uint16_t message_size(uint8_t status)
+{
+	switch (status & 0xF0) {
+		case 0xC0:
+		case 0xD0:
+			return 2;
+		case 0xF0:
+			break;
+		default:
+			return 3;
+	}
+
+	switch (status) {
+		case 0xF1:
+		case 0xF3:
+			return 2;
+		case 0xF2:
+			return 3;
+		case SYSEX_START:
+			return 0;
+		default:
+			return 1;
+	}
+}
+
+/**
+ * Puts the firmware's MIDI back into whole messages, it always sends a
+ * status byte so running status is not followed. A SysEx holding a byte
+ * which is not 7 bit is dropped.
+ */
+
+static void capture_midi_out(const uint8_t* data, uint16_t length)
+{
+	for (uint16_t i=0;i<length;++i) {
+		uint8_t byte = data[i];
+
+		// The firmware builds each SysEx whole, so a status byte inside
+		// one is a setting out of range rather than a real time message
+		if (message_length && !message_expected && byte & 0x80 && byte != SYSEX_EOX) {
+			message_corrupt = true;
+			continue;
+		}
+
+		// Real time messages may come between the bytes of any other
+		if (byte >= 0xF8) {
+			take_message(&byte, 1);
+			continue;
+		}
+
+		if (byte & 0x80 && byte != SYSEX_EOX) {
+			message_length   = 0;
+			message_expected = message_size(byte);
+			message_corrupt  = false;
+		} else if (!message_length) {
+			continue;
+		}
+
+		if (message_length < MAX_MESSAGE) {
+			message[message_length++] = byte;
+		}
+
+		if ((message_expected && message_length == message_expected) ||
+		    (!message_expected && byte == SYSEX_EOX)) {
+			if (!message_corrupt) {
+				take_message(message, message_length);
+			}
+			message_length = 0;
+		}
+	}
+}
+
+/**
+ * Feeds the settings to the firmware and waits for its replies, then
+ * starts the steps once things have settled.
+ */
+
+static void run_settings(void)
+{
+	uint64_t now_us = sim_get_time_us();
+
+	while (outgoing_sent < outgoing_length) {
+		uint16_t sent = sim_midi_in(&outgoing[outgoing_sent], outgoing_length - outgoing_sent);
+		if (!sent) {
+			break;
+		}
+		outgoing_sent += sent;
+	}
+
+	if (global_reply) {
+		global_reply = false;
+		deadline_us  = now_us + SETTINGS_TIMEOUT_MS * 1000UL;
+
+		if (state == play_pulling) {
+			state = play_pushing;
+			outgoing_length = outgoing_sent = 0;
+			queue_settings();
+		} else {
+			state = play_settling;
+			sim_schedule((now_us + SETTLE_MS * 1000UL) * SIM_CYCLES_PER_US, run_settings);
+			return;
+		}
+	} else if (state == play_settling) {
+		state     = play_running;
+		start_us  = now_us;
+		next_step = 0;
+		if (started_hook) {
+			started_hook();
+		}
+		run_steps();
+		return;
+	} else if (now_us >= deadline_us) {
+		fprintf(stderr, "%s: the firmware did not take the settings\n", playing->name);
+		sim_exit(SIM_EXIT_ERROR);
+	}
+
+	sim_schedule(sim_get_cycles() + SIM_CYCLES_PER_MS, run_settings);
+}
+
+static void end_scenario(void)
+{
+	state   = play_idle;
+	playing = NULL;
+	sim_set_midi_out_hook(NULL);
+
+	if (done_hook) {
+		done_hook();
+	}
+}
+
+/**
+ * Plays every step which is due, then waits for the next.
+ */
+
+static void run_steps(void)
+{
+	const scenario_t* s = playing;
+	uint64_t now_us = sim_get_time_us() - start_us;
+
+	while (next_step < s->count && s->steps[next_step].at_us <= now_us) {
+		const scenario_step_t* step = &s->steps[next_step++];
+
+		switch (step->type) {
+			case step_encoder:
+				sim_encoder_step(step->target, step->direction);
+				break;
+			case step_press:
+				sim_encoder_switch(step->target, true);
+				break;
+			case step_release:
+				sim_encoder_switch(step->target, false);
+				break;
+			case step_side_press:
+				sim_side_switch(step->target, true);
+				break;
+			case step_side_release:
+				sim_side_switch(step->target, false);
+				break;
+			case step_midi:
+				// The host holds back until the firmware has room
+				if (sim_midi_in_space() < step->length) {
+					next_step--;
+					sim_schedule(sim_get_cycles() + SIM_CYCLES_PER_MS, run_steps);
+					return;
+				}
+				sim_midi_in(step->data, step->length);
+				break;
+			case step_host_hold:
+				usb_sim_set_in_held(true);
+				break;
+			case step_host_read:
+				usb_sim_set_in_held(false);
+				break;
+		}
+	}
+
+	uint64_t at_us = next_step < s->count ? s->steps[next_step].at_us : s->length_us + SETTLE_MS * 1000UL;
+	sim_schedule((start_us + at_us) * SIM_CYCLES_PER_US,
+	             next_step < s->count ? run_steps : end_scenario);
+}
+
+void scenario_play(const scenario_t* scenario, sim_event_hook_t started,
+                   scenario_midi_hook_t midi, sim_event_hook_t done)
+{
+	playing        = scenario;
+	started_hook   = started;
+	midi_hook      = midi;
+	done_hook      = done;
+	message_length = 0;
+	global_reply   = false;
+
+	sim_set_midi_out_hook(capture_midi_out);
+
+	if (!scenario->has_settings) {
+		state = play_settling;
+		run_settings();
+		return;
+	}
+
+	// The globals are pulled first, so those the scenario leaves alone
+	// are pushed back as they were
+	uint8_t data[CONFIG_MAX_MESSAGE];
+	outgoing_length = outgoing_sent = 0;
+	queue_message(data, config_build_global_pull(data));
+
+	state       = play_pulling;
+	deadline_us = sim_get_time_us() + SETTINGS_TIMEOUT_MS * 1000UL;
+	run_settings();
+}
+
+/**
+ * Waits for every setting to come back, as run_settings() does for the
+ * scenario's.
+ */
+
+static void run_read(void)
+{
+	while (outgoing_sent < outgoing_length) {
+		uint16_t sent = sim_midi_in(&outgoing[outgoing_sent], outgoing_length - outgoing_sent);
+		if (!sent) {
+			break;
+		}
+		outgoing_sent += sent;
+	}
+
+	if (read_config->has_global && read_count == CONFIG_ENCODERS) {
+		state       = play_idle;
+		read_config = NULL;
+		sim_set_midi_out_hook(NULL);
+
+		if (done_hook) {
+			done_hook();
+		}
+		return;
+	}
+
+	if (sim_get_time_us() >= deadline_us) {
+		fprintf(stderr, "scenario: the settings did not all come back\n");
+		sim_exit(SIM_EXIT_ERROR);
+	}
+
+	sim_schedule(sim_get_cycles() + SIM_CYCLES_PER_MS, run_read);
+}
+
+void scenario_read_config(twister_config_t* config, sim_event_hook_t done)
+{
+	uint8_t data[CONFIG_MAX_MESSAGE];
+
+	memset(config, 0x00, sizeof(twister_config_t));
+	read_config    = config;
+	read_count     = 0;
+	done_hook      = done;
+	message_length = 0;
+
+	// The global pull reply is parsed into the same settings
+	outgoing_length = outgoing_sent = 0;
+	queue_message(data, config_build_global_pull(data));
+	for (uint8_t i=0;i<CONFIG_ENCODERS;++i) {
+		queue_message(data, config_build_encoder_pull(i, data));
+	}
+
+	sim_set_midi_out_hook(capture_midi_out);
+
+	state       = play_reading;
+	deadline_us = sim_get_time_us() + SETTINGS_TIMEOUT_MS * 1000UL;
+	run_read();
+}
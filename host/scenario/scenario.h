@@ -0,0 +1,103 @@
+/*
+ * scenario.h
+ *
+ * Created: 10/18/2026 10:12:37 PM
+ *
+ *  Scripted scenarios for the host tools, played into the firmware on the
+ *  simulated hardware. A scenario is a text file of one command a line,
+ *  # starts a comment. Settings are sent first, over the configuration
+ *  SysEx as the editor would, then the timed commands are played. Those
+ *  take effect at the scenario's current time, only wait moves it on, so
+ *  turns and MIDI streams started together overlap.
+ *
+ *    global NAME=VALUE...          global settings, as twister_config names
+ *    encoder B:E NAME=VALUE...     an encoder's settings, B:E or sP:E
+ *    wait MS                       move the current time on
+ *    turn ENCODER DETENTS EDGE_US  turn encoder 0-15 by DETENTS, negative
+ *                                  turns down, EDGE_US between edges
+ *    press ENCODER, release ENCODER
+ *    press side N, release side N  side switch 1-6, as side_func_N
+ *    midi BYTE...                  one MIDI message, in hex
+ *    feedback COUNT RATE           COUNT CCs to the encoders of the first
+ *                                  bank in turn, RATE a second
+ *    clock COUNT BPM               COUNT MIDI clock ticks
+ *    host hold, host read          the host stops, or goes back to,
+ *                                  reading the USB MIDI IN endpoint
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef SCENARIO_H_
+#define SCENARIO_H_
+
+	/*	Includes: */
+
+		#include "hal_sim.h"
+		#include "../config/config_protocol.h"
+
+	/*	Macros: */
+
+		#define SCENARIO_MAX_NAME	64
+
+	/*	Types: */
+
+		typedef struct {
+			uint64_t at_us;			// From the start of the scenario
+			uint32_t order;			// Keeps steps at the same time in script order
+			uint8_t  type;
+			uint8_t  target;		// Encoder or side switch
+			int8_t   direction;
+			uint8_t  length;
+			uint8_t  data[3];
+		} scenario_step_t;
+
+		typedef struct {
+			char             name[SCENARIO_MAX_NAME];
+			scenario_step_t* steps;
+			uint32_t         count;
+			uint32_t         capacity;
+			uint64_t         length_us;
+
+			// Settings sent before the steps, encoder settings left
+			// CONFIG_UNSET and globals not in global_set are kept
+			bool             has_settings;
+			bool             global_set[CONFIG_GLOBAL_SETTINGS];
+			twister_config_t settings;
+		} scenario_t;
+
+		// Called with the firmware's MIDI once the steps have started
+		typedef void (*scenario_midi_hook_t)(uint64_t time_us, const uint8_t* data, uint16_t length);
+
+	/*	Function Prototypes: */
+
+		// Reads a scenario, the name is the file's less its directory and
+		// extension. Returns false, with a message, on any line not understood
+		bool scenario_read(scenario_t* scenario, const char* path);
+		void scenario_free(scenario_t* scenario);
+
+		// Sends the settings then plays the steps, from a hook or before
+		// the firmware starts. 'started' is called once the settings are
+		// in and 'done' a settle time after the last step. Takes over the
+		// scheduled event and the MIDI out hook until then
+		void scenario_play(const scenario_t* scenario, sim_event_hook_t started,
+		                   scenario_midi_hook_t midi, sim_event_hook_t done);
+
+		// Pulls the global settings and every encoder's, as the editor
+		// would, then calls 'done'. Exits the simulation if any do not
+		// come back whole
+		void scenario_read_config(twister_config_t* config, sim_event_hook_t done);
+
+#endif /* SCENARIO_H_ */
@@ -0,0 +1,1263 @@
+/*
+ * hal_sim.c
+ *
+ * Created: 10/18/2026 1:20:36 PM
+ *
+ *  The simulated CPU core and on chip peripherals: the clock, interrupt
+ *  delivery, the three timer/counters, IO ports with the encoder shift
+ *  register chain and side switches, the display DMA, both USARTs, the
+ *  watchdog and the sleep manager.
+ *
+ *  The firmware code itself takes no simulated time, each hardware access
+ *  is charged a few cycles instead so polling loops always make progress.
+ *  A tool may also charge a cost for each profiled path of the firmware,
+ *  see sim_set_profile_cost().
+ *  Interrupts are delivered whenever time moves with interrupts enabled,
+ *  highest PMIC level first and pre-empting lower levels like the XMEGA,
+ *  which makes every HAL call a possible pre-emption point.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+
+#include <input.h>
+#include <profiler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Cycles charged for each hardware access
+#define COST_IRQ		1
+#define COST_IO			2
+#define COST_TC			4
+
+// Interrupt levels, 0 is the main loop
+#define LEVEL_NONE		0
+#define LEVEL_LO		1
+#define LEVEL_MED		2
+#define LEVEL_HI		3
+
+// Marks a write-one-to-clear flag register as untouched by the firmware
+#define W1C_MARK		0x01
+
+// Firmware interrupt vectors
+void USARTE0_RXC_vect(void);
+void USB_TRNCOMPL_vect(void);
+
+// Peripheral registers used directly by the firmware
+PMIC_t  PMIC;
+TC_t    TCC0;
+TC_t    TCC1;
+TC_t    TCD0;
+USB_t   USB;
+USART_t USARTD0;
+USART_t USARTE0;
+volatile uint8_t EIND;
+
+// Interrupt sources in vector order, which is also their priority within
+// a level
+typedef enum {
+	IRQ_TCC0_OVF,
+	IRQ_TCC0_CCA,
+	IRQ_TCC0_CCB,
+	IRQ_TCC1_OVF,
+	IRQ_TCC1_CCA,
+	IRQ_TCC1_CCB,
+	IRQ_TCD0_OVF,
+	IRQ_TCD0_CCA,
+	IRQ_TCD0_CCB,
+	IRQ_USARTE0_RXC,
+	IRQ_USB_BUSEVENT,
+	IRQ_USB_TRNCOMPL,
+	IRQ_COUNT,
+} irq_t;
+
+// Timer/counter channels, matching the order of the IRQs
+#define TC_CH_OVF		0
+#define TC_CH_CCA		1
+#define TC_CH_CCB		2
+#define TC_CHANNELS		3
+
+typedef struct {
+	TC_t*         regs;
+	uint32_t      residue;				// CPU cycles towards the next tick
+	tc_callback_t callback[TC_CHANNELS];
+	bool          flag[TC_CHANNELS];
+} sim_tc_t;
+
+static sim_tc_t tcs[] = {
+	{ .regs = &TCC0 },
+	{ .regs = &TCC1 },
+	{ .regs = &TCD0 },
+};
+
+#define TC_COUNT (sizeof(tcs) / sizeof(tcs[0]))
+
+static const uint16_t tc_prescale[8] = {0, 1, 2, 4, 8, 64, 256, 1024};
+
+// Clock
+static uint64_t now;
+static uint64_t next_frame = SIM_CYCLES_PER_MS;
+static uint64_t time_limit;
+static bool     realtime;
+static struct timespec wall_start;
+
+// CPU
+static bool     irq_enabled;
+static uint8_t  running_level;
+static uint32_t irq_count;
+static reset_cause_t reset_cause = CHIP_RESET_CAUSE_POR;
+
+// USB interrupt flags, the registers are mirrored from these
+static uint8_t usb_flags_a;
+static uint8_t usb_flags_b;
+
+// IO ports, one bit per pin
+static uint64_t pin_output;
+static uint64_t pin_level;
+static uint64_t pin_pullup;
+static uint64_t pin_driven_low;
+
+// Encoder shift register chain
+static uint16_t enc_switch_pressed;
+static uint8_t  enc_phase[SIM_ENCODERS];
+static uint8_t  chain_bits[48];
+static uint8_t  chain_pos;
+
+static const ioport_pin_t side_switch_pins[6] = {
+	SIDE_SW1, SIDE_SW2, SIDE_SW3, SIDE_SW4, SIDE_SW5, SIDE_SW6
+};
+
+// Display DMA to USARTD0 in SPI mode
+static uint16_t dma_trfcnt;
+static uint64_t dma_busy_until;
+static uint32_t spi_baudrate;
+
+// Legacy MIDI on USARTE0
+static bool     serial_enabled;
+static uint32_t serial_baudrate;
+static uint64_t serial_next_rx;
+static bool     serial_rx_full;
+static uint8_t  serial_rx_data;
+
+// Host MIDI waiting to be received
+static uint8_t  midi_in_ring[SIM_MIDI_IN_SIZE];
+static uint16_t midi_in_head;
+static uint16_t midi_in_tail;
+
+// Cycles charged for the firmware's own work on each profiled path
+static uint32_t profile_cost[PROFILE_POINT_COUNT];
+
+// Watchdog
+static bool     wdt_enabled;
+static uint32_t wdt_period_ms = 8;
+static uint64_t wdt_deadline;
+
+// Hooks
+static sim_frame_hook_t    frame_hook;
+static sim_midi_out_hook_t midi_out_hook;
+static sim_reset_hook_t    reset_hook;
+
+// Scheduled event
+static sim_event_hook_t    event_hook;
+static uint64_t            event_at;
+
+static void dispatch(void);
+
+// Clock ----------------------------------------------------------------------
+
+uint64_t sim_get_cycles(void)
+{
+	return now;
+}
+
+uint64_t sim_get_time_us(void)
+{
+	return now / SIM_CYCLES_PER_US;
+}
+
+void sim_set_time_limit_ms(uint32_t ms)
+{
+	time_limit = (uint64_t)ms * SIM_CYCLES_PER_MS;
+}
+
+void sim_set_realtime(bool enable)
+{
+	realtime = enable;
+	clock_gettime(CLOCK_MONOTONIC, &wall_start);
+}
+
+/**
+ * Holds the simulation back to the host clock in real time mode.
+ */
+
+static void sync_realtime(void)
+{
+	struct timespec wall;
+	clock_gettime(CLOCK_MONOTONIC, &wall);
+
+	int64_t wall_us = (int64_t)(wall.tv_sec - wall_start.tv_sec) * 1000000 +
+	                  (wall.tv_nsec - wall_start.tv_nsec) / 1000;
+	int64_t ahead_us = (int64_t)sim_get_time_us() - wall_us;
+
+	if (ahead_us > 0) {
+		struct timespec delay = {
+			.tv_sec  = ahead_us / 1000000,
+			.tv_nsec = (ahead_us % 1000000) * 1000,
+		};
+		nanosleep(&delay, NULL);
+	}
+}
+
+void sim_exit(int code)
+{
+	sim_eeprom_close();
+	fflush(stdout);
+	fflush(stderr);
+	exit(code);
+}
+
+void sim_set_reset_cause(reset_cause_t cause)
+{
+	reset_cause = cause;
+}
+
+void sim_set_reset_hook(sim_reset_hook_t hook)
+{
+	reset_hook = hook;
+}
+
+/**
+ * Resets the MCU. The process can not re-run the firmware with its RAM
+ * cleared so it exits, unless a hook takes over.
+ */
+
+void sim_reset(reset_cause_t cause)
+{
+	if (reset_hook) {
+		reset_hook(cause);
+	}
+
+	fprintf(stderr, "sim: %s reset at %llu ms\n",
+	        cause == CHIP_RESET_CAUSE_WDT ? "watchdog" : "software",
+	        (unsigned long long)(sim_get_time_us() / 1000));
+	sim_exit(SIM_EXIT_RESET);
+}
+
+// Timer/counters -------------------------------------------------------------
+
+static sim_tc_t* find_tc(volatile void* tc)
+{
+	for (uint8_t i=0;i<TC_COUNT;++i) {
+		if ((volatile void*)tcs[i].regs == tc) {
+			return &tcs[i];
+		}
+	}
+
+	fprintf(stderr, "sim: unknown timer/counter %p\n", (void*)tc);
+	sim_exit(SIM_EXIT_ERROR);
+	return NULL;
+}
+
+static uint8_t tc_level(sim_tc_t* t, uint8_t ch)
+{
+	if (ch == TC_CH_OVF) {
+		return t->regs->INTCTRLA & 0x03;
+	}
+	return (t->regs->INTCTRLB >> ((ch - 1) * 2)) & 0x03;
+}
+
+static uint16_t tc_compare(sim_tc_t* t, uint8_t ch)
+{
+	return ch == TC_CH_CCA ? t->regs->CCA : t->regs->CCB;
+}
+
+/**
+ * Returns the ticks until a channel next fires, 0 if it never does.
+ */
+
+static uint32_t tc_ticks_to(sim_tc_t* t, uint8_t ch)
+{
+	uint32_t top = (uint32_t)t->regs->PER + 1;
+	uint32_t cnt = t->regs->CNT;
+
+	if (ch == TC_CH_OVF) {
+		return top - cnt;
+	}
+
+	uint16_t cc = tc_compare(t, ch);
+	if (cc > t->regs->PER) {
+		return 0;
+	}
+
+	uint32_t ticks = (cc + top - cnt) % top;
+	return ticks ? ticks : top;
+}
+
+/**
+ * Returns the CPU cycles until the next enabled interrupt of a timer.
+ */
+
+static uint64_t tc_next_event(sim_tc_t* t)
+{
+	uint16_t prescale = tc_prescale[t->regs->CTRLA & 0x07];
+	uint64_t next = UINT64_MAX;
+
+	if (!prescale) {
+		return next;
+	}
+
+	for (uint8_t ch=0;ch<TC_CHANNELS;++ch) {
+		uint32_t ticks = tc_ticks_to(t, ch);
+		if (tc_level(t, ch) && ticks) {
+			uint64_t cycles = (uint64_t)ticks * prescale - t->residue;
+			if (cycles < next) {
+				next = cycles;
+			}
+		}
+	}
+
+	return next;
+}
+
+/**
+ * Counts a timer on by a number of CPU cycles. The flags are set whether
+ * or not their interrupt is enabled, like the hardware.
+ */
+
+static void tc_tick(sim_tc_t* t, uint64_t cycles)
+{
+	uint16_t prescale = tc_prescale[t->regs->CTRLA & 0x07];
+
+	if (!prescale) {
+		return;
+	}
+
+	uint64_t total = t->residue + cycles;
+	uint64_t ticks = total / prescale;
+	t->residue = total % prescale;
+
+	if (!ticks) {
+		return;
+	}
+
+	for (uint8_t ch=0;ch<TC_CHANNELS;++ch) {
+		uint32_t to = tc_ticks_to(t, ch);
+		if (to && to <= ticks) {
+			t->flag[ch] = true;
+		}
+	}
+
+	uint32_t top = (uint32_t)t->regs->PER + 1;
+	t->regs->CNT = (t->regs->CNT + ticks) % top;
+}
+
+void tc_enable(volatile void *tc)
+{
+	sim_tc_t* t = find_tc(tc);
+	t->regs->PER = 0xFFFF;
+}
+
+void tc_disable(volatile void *tc)
+{
+	find_tc(tc)->regs->CTRLA = TC_CLKSEL_OFF_gc;
+}
+
+void tc_set_wgm(volatile void *tc, enum tc_wg_mode_t wgm)
+{
+	find_tc(tc)->regs->CTRLB = wgm;
+}
+
+void tc_write_clock_source(volatile void *tc, uint8_t clk_sel)
+{
+	find_tc(tc)->regs->CTRLA = clk_sel;
+	sim_advance(COST_TC);
+}
+
+void tc_write_period(volatile void *tc, uint16_t per_value)
+{
+	find_tc(tc)->regs->PER = per_value;
+}
+
+void tc_write_cc(volatile void *tc, enum tc_cc_channel_t channel, uint16_t value)
+{
+	sim_tc_t* t = find_tc(tc);
+
+	if (channel == TC_CCA) {
+		t->regs->CCA = value;
+	} else if (channel == TC_CCB) {
+		t->regs->CCB = value;
+	}
+	sim_advance(COST_TC);
+}
+
+uint16_t tc_read_cc(volatile void *tc, enum tc_cc_channel_t channel)
+{
+	sim_tc_t* t = find_tc(tc);
+	return channel == TC_CCA ? t->regs->CCA : t->regs->CCB;
+}
+
+uint16_t tc_read_count(volatile void *tc)
+{
+	sim_advance(COST_TC);
+	return find_tc(tc)->regs->CNT;
+}
+
+void tc_set_cca_interrupt_callback(volatile void *tc, tc_callback_t callback)
+{
+	find_tc(tc)->callback[TC_CH_CCA] = callback;
+}
+
+void tc_set_ccb_interrupt_callback(volatile void *tc, tc_callback_t callback)
+{
+	find_tc(tc)->callback[TC_CH_CCB] = callback;
+}
+
+void tc_set_overflow_interrupt_callback(volatile void *tc, tc_callback_t callback)
+{
+	find_tc(tc)->callback[TC_CH_OVF] = callback;
+}
+
+void tc_set_cca_interrupt_level(volatile void *tc, enum TC_INT_LEVEL_enum level)
+{
+	TC_t* regs = find_tc(tc)->regs;
+	regs->INTCTRLB = (regs->INTCTRLB & ~0x03) | level;
+	sim_advance(COST_IO);
+}
+
+void tc_set_ccb_interrupt_level(volatile void *tc, enum TC_INT_LEVEL_enum level)
+{
+	TC_t* regs = find_tc(tc)->regs;
+	regs->INTCTRLB = (regs->INTCTRLB & ~0x0C) | (level << 2);
+	sim_advance(COST_IO);
+}
+
+void tc_set_overflow_interrupt_level(volatile void *tc, enum TC_INT_LEVEL_enum level)
+{
+	TC_t* regs = find_tc(tc)->regs;
+	regs->INTCTRLA = (regs->INTCTRLA & ~0x03) | level;
+	sim_advance(COST_IO);
+}
+
+// Interrupts -----------------------------------------------------------------
+
+/**
+ * Applies firmware writes to a write-one-to-clear flag register. The
+ * register is kept at the flags plus W1C_MARK, a write by the firmware
+ * drops the mark and clears the flags written.
+ */
+
+static void w1c_sync(volatile uint8_t* reg, uint8_t* flags)
+{
+	uint8_t value = *reg;
+
+	if (!(value & W1C_MARK)) {
+		*flags &= ~value;
+	}
+	*reg = *flags | W1C_MARK;
+}
+
+static void w1c_set(volatile uint8_t* reg, uint8_t* flags, uint8_t set)
+{
+	w1c_sync(reg, flags);
+	*flags |= set;
+	*reg = *flags | W1C_MARK;
+}
+
+void sim_usb_frame_flag(void)
+{
+	w1c_set(&USB.INTFLAGSACLR, &usb_flags_a, USB_SOFIF_bm);
+}
+
+void sim_usb_trncompl(void)
+{
+	w1c_set(&USB.INTFLAGSBCLR, &usb_flags_b, USB_TRNIF_bm);
+}
+
+static bool irq_pending(irq_t irq)
+{
+	switch (irq) {
+		case IRQ_USARTE0_RXC:
+			return serial_rx_full;
+		case IRQ_USB_BUSEVENT:
+			return (usb_flags_a & USB_SOFIF_bm) && (USB.INTCTRLA & USB_SOFIE_bm);
+		case IRQ_USB_TRNCOMPL:
+			return (usb_flags_b & USB_TRNIF_bm) && (USB.INTCTRLB & USB_TRNIE_bm);
+		default:
+			return tcs[irq / TC_CHANNELS].flag[irq % TC_CHANNELS];
+	}
+}
+
+static uint8_t irq_level(irq_t irq)
+{
+	switch (irq) {
+		case IRQ_USARTE0_RXC:
+			return (USARTE0.CTRLA >> 4) & 0x03;
+		case IRQ_USB_BUSEVENT:
+		case IRQ_USB_TRNCOMPL:
+			// LUFA is built with USB_OPT_BUSEVENT_PRIHIGH
+			return usb_sim_is_attached() ? LEVEL_HI : LEVEL_NONE;
+		default:
+			return tc_level(&tcs[irq / TC_CHANNELS], irq % TC_CHANNELS);
+	}
+}
+
+static void irq_run(irq_t irq)
+{
+	switch (irq) {
+		case IRQ_USARTE0_RXC:
+			USARTE0_RXC_vect();
+			break;
+		case IRQ_USB_BUSEVENT:
+			// LUFA clears the flag before calling the event
+			usb_flags_a &= ~USB_SOFIF_bm;
+			USB.INTFLAGSACLR = usb_flags_a | W1C_MARK;
+			EVENT_USB_Device_StartOfFrame();
+			break;
+		case IRQ_USB_TRNCOMPL:
+			USB_TRNCOMPL_vect();
+			break;
+		default:{
+			sim_tc_t* t = &tcs[irq / TC_CHANNELS];
+			uint8_t ch = irq % TC_CHANNELS;
+
+			// The flag is cleared as the vector is taken
+			t->flag[ch] = false;
+			if (t->callback[ch]) {
+				t->callback[ch]();
+			}
+		}
+		break;
+	}
+}
+
+/**
+ * Runs the interrupts which can pre-empt the current level, highest level
+ * first and by vector order within a level.
+ */
+
+static void dispatch(void)
+{
+	while (irq_enabled) {
+		w1c_sync(&USB.INTFLAGSACLR, &usb_flags_a);
+		w1c_sync(&USB.INTFLAGSBCLR, &usb_flags_b);
+
+		irq_t   next  = IRQ_COUNT;
+		uint8_t level = running_level;
+
+		for (irq_t irq=0;irq<IRQ_COUNT;++irq) {
+			uint8_t irq_lvl = irq_level(irq);
+			if (irq_lvl > level && (PMIC.CTRL & (0x01 << (irq_lvl - 1))) &&
+			    irq_pending(irq)) {
+				next  = irq;
+				level = irq_lvl;
+			}
+		}
+
+		if (next == IRQ_COUNT) {
+			return;
+		}
+
+		uint8_t prev_level = running_level;
+		running_level = level;
+		irq_count++;
+		irq_run(next);
+		running_level = prev_level;
+	}
+}
+
+void cpu_irq_enable(void)
+{
+	irq_enabled = true;
+	sim_advance(COST_IRQ);
+}
+
+void cpu_irq_disable(void)
+{
+	irq_enabled = false;
+}
+
+bool cpu_irq_is_enabled(void)
+{
+	return irq_enabled;
+}
+
+irqflags_t cpu_irq_save(void)
+{
+	irqflags_t flags = irq_enabled;
+	irq_enabled = false;
+	return flags;
+}
+
+void cpu_irq_restore(irqflags_t flags)
+{
+	if (flags) {
+		cpu_irq_enable();
+	}
+}
+
+// Time -----------------------------------------------------------------------
+
+/**
+ * Returns the CPU cycles until the next peripheral event, at most one USB
+ * frame.
+ */
+
+static uint64_t next_event(void)
+{
+	uint64_t next = next_frame - now;
+
+	for (uint8_t i=0;i<TC_COUNT;++i) {
+		uint64_t cycles = tc_next_event(&tcs[i]);
+		if (cycles < next) {
+			next = cycles;
+		}
+	}
+
+	if (serial_enabled && midi_in_head != midi_in_tail && serial_next_rx > now &&
+	    serial_next_rx - now < next) {
+		next = serial_next_rx - now;
+	}
+
+	if (wdt_enabled && wdt_deadline > now && wdt_deadline - now < next) {
+		next = wdt_deadline - now;
+	}
+
+	if (event_hook && event_at > now && event_at - now < next) {
+		next = event_at - now;
+	}
+
+	return next ? next : 1;
+}
+
+/**
+ * Moves a received byte into USARTE0 once per character time while the
+ * legacy MIDI port is in use.
+ */
+
+static void serial_receive(void)
+{
+	if (!serial_enabled || usb_sim_is_attached() || now < serial_next_rx) {
+		return;
+	}
+
+	uint8_t data;
+	if (sim_midi_in_pop(&data)) {
+		serial_rx_data = data;
+		serial_rx_full = true;
+		serial_next_rx = now + 10ULL * F_CPU / serial_baudrate;
+	}
+}
+
+/**
+ * Moves simulated time on, running the peripherals and delivering any
+ * interrupts that fall due on the way.
+ *
+ * \param cycles [in]	CPU cycles to advance by, 0 only delivers interrupts
+ */
+
+void sim_advance(uint32_t cycles)
+{
+	uint64_t target = now + cycles;
+
+	do {
+		uint64_t step = target - now;
+		uint64_t next = next_event();
+		if (next < step) {
+			step = next;
+		}
+
+		now += step;
+		for (uint8_t i=0;i<TC_COUNT;++i) {
+			tc_tick(&tcs[i], step);
+		}
+
+		if (now >= next_frame) {
+			next_frame += SIM_CYCLES_PER_MS;
+			if (frame_hook) {
+				frame_hook();
+			}
+			usb_sim_frame();
+			if (realtime) {
+				sync_realtime();
+			}
+		}
+
+		if (event_hook && now >= event_at) {
+			sim_event_hook_t hook = event_hook;
+			event_hook = NULL;
+			hook();
+		}
+
+		usb_sim_advance();
+		serial_receive();
+
+		if (wdt_enabled && now >= wdt_deadline) {
+			sim_reset(CHIP_RESET_CAUSE_WDT);
+		}
+
+		if (time_limit && now >= time_limit) {
+			sim_exit(SIM_EXIT_OK);
+		}
+
+		dispatch();
+
+	} while (now < target);
+}
+
+void sim_charge_us(uint32_t us)
+{
+	sim_advance(us * SIM_CYCLES_PER_US);
+}
+
+void _delay_ms(double ms)
+{
+	sim_advance((uint32_t)(ms * SIM_CYCLES_PER_MS));
+}
+
+void _delay_us(double us)
+{
+	sim_advance((uint32_t)(us * SIM_CYCLES_PER_US));
+}
+
+/**
+ * Runs a hook once simulated time reaches a given point. Only one event is
+ * held, scheduling another replaces it, so a hook that wants to run again
+ * schedules itself.
+ *
+ * \param cycles [in]	Time to run at, in CPU cycles since power up
+ * \param hook [in]		Hook to run, NULL cancels the event
+ */
+
+void sim_schedule(uint64_t cycles, sim_event_hook_t hook)
+{
+	event_at   = cycles;
+	event_hook = hook;
+}
+
+void sim_set_frame_hook(sim_frame_hook_t hook)
+{
+	frame_hook = hook;
+}
+
+// Sleep manager --------------------------------------------------------------
+
+void sleepmgr_init(void)
+{
+}
+
+void sleepmgr_lock_mode(enum sleepmgr_mode mode)
+{
+	UNUSED(mode);
+}
+
+void sleepmgr_unlock_mode(enum sleepmgr_mode mode)
+{
+	UNUSED(mode);
+}
+
+/**
+ * Enables interrupts and sleeps until one has been delivered.
+ */
+
+void sleepmgr_enter_sleep(void)
+{
+	uint32_t woken = irq_count;
+
+	irq_enabled = true;
+	sim_advance(0);
+
+	while (irq_count == woken) {
+		sim_advance(next_event());
+	}
+}
+
+// IO ports -------------------------------------------------------------------
+
+static bool quadrature_a(uint8_t phase)
+{
+	return phase == 1 || phase == 2;
+}
+
+static bool quadrature_b(uint8_t phase)
+{
+	return phase == 2 || phase == 3;
+}
+
+/**
+ * Loads the encoder chain. The firmware reads the 16 switches, active low,
+ * then channel B and channel A of each encoder, all from encoder 15 down.
+ */
+
+static void chain_load(void)
+{
+	for (uint8_t i=0;i<SIM_ENCODERS;++i) {
+		uint8_t enc = SIM_ENCODERS - 1 - i;
+		chain_bits[i] = !(enc_switch_pressed & (0x01 << enc));
+		chain_bits[16 + i*2]     = quadrature_b(enc_phase[enc]);
+		chain_bits[16 + i*2 + 1] = quadrature_a(enc_phase[enc]);
+	}
+	chain_pos = 0;
+}
+
+void ioport_init(void)
+{
+}
+
+void ioport_set_pin_dir(ioport_pin_t pin, enum ioport_direction dir)
+{
+	if (dir == IOPORT_DIR_OUTPUT) {
+		pin_output |= (1ULL << pin);
+	} else {
+		pin_output &= ~(1ULL << pin);
+	}
+}
+
+void ioport_set_pin_mode(ioport_pin_t pin, uint8_t mode)
+{
+	if ((mode & IOPORT_MODE_PULLUP) == IOPORT_MODE_PULLUP) {
+		pin_pullup |= (1ULL << pin);
+	} else {
+		pin_pullup &= ~(1ULL << pin);
+	}
+}
+
+void ioport_set_pin_level(ioport_pin_t pin, bool level)
+{
+	bool prev = pin_level & (1ULL << pin);
+
+	if (level) {
+		pin_level |= (1ULL << pin);
+	} else {
+		pin_level &= ~(1ULL << pin);
+	}
+
+	if (level && !prev) {
+		if (pin == ENC_LATCH) {
+			chain_load();
+		} else if (pin == ENC_CLK && (pin_level & (1ULL << ENC_LATCH)) &&
+		           chain_pos < sizeof(chain_bits)) {
+			chain_pos++;
+		}
+	}
+
+	sim_advance(COST_IO);
+}
+
+bool ioport_get_pin_level(ioport_pin_t pin)
+{
+	sim_advance(COST_IO);
+
+	if (pin == ENC_DATA) {
+		return chain_pos < sizeof(chain_bits) ? chain_bits[chain_pos] : false;
+	}
+
+	if (pin_output & (1ULL << pin)) {
+		return pin_level & (1ULL << pin);
+	}
+
+	if (pin_driven_low & (1ULL << pin)) {
+		return false;
+	}
+
+	return pin_pullup & (1ULL << pin);
+}
+
+void ioport_toggle_pin_level(ioport_pin_t pin)
+{
+	ioport_set_pin_level(pin, !(pin_level & (1ULL << pin)));
+}
+
+// Board inputs ---------------------------------------------------------------
+
+/**
+ * Turns an encoder by one quadrature edge, channel A leads for positive
+ * directions.
+ */
+
+void sim_encoder_step(uint8_t encoder, int8_t direction)
+{
+	if (encoder < SIM_ENCODERS) {
+		enc_phase[encoder] = (enc_phase[encoder] + (direction > 0 ? 1 : 3)) & 0x03;
+	}
+}
+
+/**
+ * Sets an encoder's channel levels as they were recorded, rather than
+ * moving it on by an edge. Levels which skip a phase are passed on as
+ * they are, as the firmware would see them from a bouncing encoder.
+ */
+
+void sim_encoder_levels(uint8_t encoder, bool a, bool b)
+{
+	static const uint8_t phase[2][2] = {{0, 3}, {1, 2}};
+
+	if (encoder < SIM_ENCODERS) {
+		enc_phase[encoder] = phase[a][b];
+	}
+}
+
+void sim_encoder_switch(uint8_t encoder, bool pressed)
+{
+	if (encoder >= SIM_ENCODERS) {
+		return;
+	}
+
+	if (pressed) {
+		enc_switch_pressed |= (0x01 << encoder);
+	} else {
+		enc_switch_pressed &= ~(0x01 << encoder);
+	}
+}
+
+/**
+ * Presses or releases side switch 0 (SW1) to 5 (SW6), a pressed switch
+ * pulls its pin low.
+ */
+
+void sim_side_switch(uint8_t sw, bool pressed)
+{
+	if (sw >= sizeof(side_switch_pins)) {
+		return;
+	}
+
+	if (pressed) {
+		pin_driven_low |= (1ULL << side_switch_pins[sw]);
+	} else {
+		pin_driven_low &= ~(1ULL << side_switch_pins[sw]);
+	}
+}
+
+// DMA ------------------------------------------------------------------------
+
+void dma_enable(void)
+{
+}
+
+void dma_disable(void)
+{
+}
+
+void dma_set_double_buffer_mode(uint8_t mode)
+{
+	UNUSED(mode);
+}
+
+void dma_channel_set_burst_length(struct dma_channel_config *config, uint8_t burst_length)
+{
+	config->ctrla = (config->ctrla & ~0x03) | burst_length;
+}
+
+void dma_channel_set_transfer_count(struct dma_channel_config *config, uint16_t count)
+{
+	config->trfcnt = count;
+}
+
+void dma_channel_set_single_shot(struct dma_channel_config *config)
+{
+	config->ctrla |= 0x04;
+}
+
+void dma_channel_set_src_dir_mode(struct dma_channel_config *config, uint8_t mode)
+{
+	config->addrctrl = (config->addrctrl & ~0x30) | mode;
+}
+
+void dma_channel_set_src_reload_mode(struct dma_channel_config *config, uint8_t mode)
+{
+	config->addrctrl = (config->addrctrl & ~0xC0) | mode;
+}
+
+void dma_channel_set_dest_dir_mode(struct dma_channel_config *config, uint8_t mode)
+{
+	config->addrctrl = (config->addrctrl & ~0x03) | mode;
+}
+
+void dma_channel_set_dest_reload_mode(struct dma_channel_config *config, uint8_t mode)
+{
+	config->addrctrl = (config->addrctrl & ~0x0C) | mode;
+}
+
+void dma_channel_set_source_address(struct dma_channel_config *config, uint16_t address)
+{
+	config->srcaddr16 = address;
+}
+
+void dma_channel_set_destination_address(struct dma_channel_config *config, uint16_t address)
+{
+	config->destaddr16 = address;
+}
+
+void dma_channel_set_trigger_source(struct dma_channel_config *config, uint8_t source)
+{
+	config->trigsrc = source;
+}
+
+void dma_channel_write_config(dma_channel_num_t num, struct dma_channel_config *config)
+{
+	UNUSED(num);
+	dma_trfcnt = config->trfcnt;
+}
+
+void dma_channel_write_source(dma_channel_num_t num, uint16_t source)
+{
+	UNUSED(num);
+	UNUSED(source);
+}
+
+/**
+ * Starts a display frame transfer, which takes as long as shifting the
+ * frame out of the SPI.
+ */
+
+void dma_channel_enable(dma_channel_num_t num)
+{
+	UNUSED(num);
+
+	if (spi_baudrate) {
+		dma_busy_until = now + (uint64_t)dma_trfcnt * 8 * F_CPU / spi_baudrate;
+	}
+}
+
+bool dma_channel_is_busy(dma_channel_num_t num)
+{
+	UNUSED(num);
+	sim_advance(COST_IO);
+	return now < dma_busy_until;
+}
+
+// USART ----------------------------------------------------------------------
+
+bool usart_init_spi(USART_t *usart, const usart_spi_options_t *opt)
+{
+	if (usart == &USARTD0) {
+		spi_baudrate = opt->baudrate;
+	}
+	return true;
+}
+
+bool usart_serial_init(USART_t *usart, const usart_serial_options_t *opt)
+{
+	if (usart == &USARTE0) {
+		serial_enabled  = true;
+		serial_baudrate = opt->baudrate;
+		serial_next_rx  = now;
+	}
+	return true;
+}
+
+/**
+ * Sends legacy MIDI, blocking for the time the bytes take on the wire.
+ */
+
+int usart_serial_write_packet(USART_t *usart, const uint8_t *data, size_t len)
+{
+	if (usart == &USARTE0 && serial_enabled) {
+		sim_midi_out(data, len);
+		sim_advance(len * 10ULL * F_CPU / serial_baudrate);
+	}
+	return 0;
+}
+
+void usart_serial_getchar(USART_t *usart, uint8_t *data)
+{
+	UNUSED(usart);
+	*data = serial_rx_data;
+	serial_rx_full = false;
+}
+
+// Host MIDI ------------------------------------------------------------------
+
+/**
+ * Queues MIDI bytes from the host for the firmware, they are received over
+ * USB once the device is configured and over the legacy port otherwise.
+ *
+ * \return	The number of bytes queued
+ */
+
+uint16_t sim_midi_in(const uint8_t* data, uint16_t length)
+{
+	uint16_t queued = 0;
+
+	while (queued < length && sim_midi_in_space()) {
+		midi_in_ring[midi_in_head % SIM_MIDI_IN_SIZE] = data[queued++];
+		midi_in_head++;
+	}
+
+	return queued;
+}
+
+uint16_t sim_midi_in_space(void)
+{
+	return SIM_MIDI_IN_SIZE - (uint16_t)(midi_in_head - midi_in_tail);
+}
+
+bool sim_midi_in_pop(uint8_t* data)
+{
+	if (midi_in_head == midi_in_tail) {
+		return false;
+	}
+
+	*data = midi_in_ring[midi_in_tail % SIM_MIDI_IN_SIZE];
+	midi_in_tail++;
+	return true;
+}
+
+void sim_midi_out(const uint8_t* data, uint16_t length)
+{
+	if (midi_out_hook && length) {
+		midi_out_hook(data, length);
+	}
+}
+
+void sim_set_midi_out_hook(sim_midi_out_hook_t hook)
+{
+	midi_out_hook = hook;
+}
+
+// Watchdog -------------------------------------------------------------------
+
+void wdt_set_timeout_period(enum wdt_timeout_period_t period)
+{
+	// 8 ms doubling to 8 s, the 1K to 8K settings are 1 s to 8 s
+	static const uint16_t period_ms[] = {8, 16, 32, 64, 125, 250, 500, 1000, 2000, 4000, 8000};
+
+	if (period < sizeof(period_ms) / sizeof(period_ms[0])) {
+		wdt_period_ms = period_ms[period];
+	}
+	wdt_deadline = now + (uint64_t)wdt_period_ms * SIM_CYCLES_PER_MS;
+}
+
+void wdt_enable(void)
+{
+	wdt_enabled = true;
+	wdt_deadline = now + (uint64_t)wdt_period_ms * SIM_CYCLES_PER_MS;
+}
+
+void wdt_disable(void)
+{
+	wdt_enabled = false;
+}
+
+void wdt_reset(void)
+{
+	wdt_deadline = now + (uint64_t)wdt_period_ms * SIM_CYCLES_PER_MS;
+}
+
+void wdt_reset_mcu(void)
+{
+	sim_reset(CHIP_RESET_CAUSE_WDT);
+}
+
+// Profiler -------------------------------------------------------------------
+
+/**
+ * Sets the CPU cycles the firmware's own code is charged each time a
+ * profiled path ends, on top of what its hardware accesses and any paths
+ * it calls are charged. All are 0 unless set, so the code takes no time.
+ *
+ * \param point [in]	Profile point, as numbered in the profiler dump
+ * \param cycles [in]	Cycles to charge
+ */
+
+void sim_set_profile_cost(uint8_t point, uint32_t cycles)
+{
+	if (point < PROFILE_POINT_COUNT) {
+		profile_cost[point] = cycles;
+	}
+}
+
+/**
+ * Stands in for profile_record() in the firmware, which the host build
+ * renames. Moves time on by the path's cost before it is recorded, so
+ * the profiler sees the cost and interrupts fall due during it.
+ */
+
+void sim_profile_record(profile_point_t point, uint16_t start)
+{
+	if (profile_cost[point]) {
+		sim_advance(profile_cost[point]);
+	}
+
+	profile_record(point, start);
+}
+
+// Reset cause ----------------------------------------------------------------
+
+reset_cause_t reset_cause_get_causes(void)
+{
+	return reset_cause;
+}
+
+void reset_cause_clear_causes(reset_cause_t causes)
+{
+	reset_cause &= ~causes;
+}
+
+// Clocks and board -----------------------------------------------------------
+
+bool XMEGACLK_StartPLL(uint8_t Source, uint32_t SourceFreq, uint32_t Frequency)
+{
+	UNUSED(Source);
+	UNUSED(SourceFreq);
+	UNUSED(Frequency);
+	return true;
+}
+
+bool XMEGACLK_SetCPUClockSource(uint8_t Source)
+{
+	UNUSED(Source);
+	return true;
+}
+
+bool XMEGACLK_StartInternalOscillator(uint8_t Source)
+{
+	UNUSED(Source);
+	return true;
+}
+
+bool XMEGACLK_StartDFLL(uint8_t Source, uint8_t Reference, uint32_t Frequency)
+{
+	UNUSED(Source);
+	UNUSED(Reference);
+	UNUSED(Frequency);
+	return true;
+}
+
+void board_init(void)
+{
+}
+
+// FIFO -----------------------------------------------------------------------
+
+int fifo_init(fifo_desc_t *fifo_desc, void *buffer, uint8_t size)
+{
+	// The size must be a power of 2, the indices run over twice the size
+	// so a full FIFO can be told from an empty one
+	if (!size || (size & (size - 1))) {
+		return -1;
+	}
+
+	fifo_desc->buffer      = buffer;
+	fifo_desc->size        = size;
+	fifo_desc->mask        = (2 * (uint16_t)size) - 1;
+	fifo_desc->read_index  = 0;
+	fifo_desc->write_index = 0;
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * hal_sim.h
+ *
+ * Created: 10/18/2026 1:20:36 PM
+ *
+ *  Simulated Twister hardware for the Linux host build. The firmware runs
+ *  unchanged on top of the host replacements of the ASF and LUFA headers,
+ *  which are implemented here against a simulated 32 MHz clock. Time only
+ *  moves when the firmware waits, sleeps or touches the hardware, every
+ *  interrupt source is advanced to that point and delivered at its PMIC
+ *  level before the call returns.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef HAL_SIM_H_
+#define HAL_SIM_H_
+
+	/*	Includes: */
+
+		#include <asf.h>
+		#include <LUFA/Drivers/USB/USB.h>
+
+	/*	Macros: */
+
+		#define SIM_CYCLES_PER_US		(F_CPU / 1000000UL)
+		#define SIM_CYCLES_PER_MS		(F_CPU / 1000UL)
+
+		// Process exit codes
+		#define SIM_EXIT_OK				0
+		#define SIM_EXIT_ERROR			1
+		#define SIM_EXIT_RESET			3
+
+		// Simulated EEPROM page write time, erase and write
+		#define SIM_EEPROM_PAGE_WRITE_US	6000
+
+		// Encoders on the input shift register chain
+		#define SIM_ENCODERS			16
+
+		// Bytes of host MIDI waiting to be delivered to the firmware
+		#define SIM_MIDI_IN_SIZE		4096
+
+		// Bytes of host USB-MIDI packets waiting, a multiple of 4
+		#define SIM_USB_PACKET_IN_SIZE	1024
+
+	/*	Types: */
+
+		// Called once per simulated USB frame, every 1 mS. It runs inside 
+		// the HAL call that moved time on so must only touch the simulated
+		// hardware, never the firmware
+		typedef void (*sim_frame_hook_t)(void);
+
+		// Called with each block of MIDI bytes the firmware sends
+		typedef void (*sim_midi_out_hook_t)(const uint8_t* data, uint16_t length);
+
+		// Called instead of exiting when the firmware resets the MCU
+		typedef void (*sim_reset_hook_t)(uint8_t cause);
+
+		// Called once at a scheduled time, with the same limits as the
+		// frame hook
+		typedef void (*sim_event_hook_t)(void);
+
+		// What a power cut is counted in, see sim_eeprom_set_power_cut()
+		typedef enum {
+			sim_nvm_bytes = 0,		// Byte erases and byte writes
+			sim_nvm_pages,			// Whole page writes
+		} sim_nvm_unit_t;
+
+		// Called with the USB-MIDI packets the firmware commits to the MIDI
+		// IN endpoint, before the host reads them
+		typedef void (*sim_usb_in_hook_t)(const uint8_t* packets, uint8_t length);
+
+	/*	Function Prototypes: */
+
+		// The firmware's main(), renamed by the host build
+		int firmware_main(void);
+
+		// Simulated time
+		uint64_t sim_get_cycles(void);
+		uint64_t sim_get_time_us(void);
+		void sim_advance(uint32_t cycles);
+		void sim_set_time_limit_ms(uint32_t ms);
+		void sim_set_realtime(bool realtime);
+		void sim_exit(int code);
+		void sim_set_profile_cost(uint8_t point, uint32_t cycles);
+
+		// Board inputs
+		void sim_encoder_step(uint8_t encoder, int8_t direction);
+		void sim_encoder_levels(uint8_t encoder, bool a, bool b);
+		void sim_encoder_switch(uint8_t encoder, bool pressed);
+		void sim_side_switch(uint8_t sw, bool pressed);
+
+		// Host MIDI
+		uint16_t sim_midi_in(const uint8_t* data, uint16_t length);
+		uint16_t sim_midi_in_space(void);
+		void sim_midi_out(const uint8_t* data, uint16_t length);
+
+		// Hooks and start up
+		void sim_set_frame_hook(sim_frame_hook_t hook);
+		void sim_set_midi_out_hook(sim_midi_out_hook_t hook);
+		void sim_set_reset_hook(sim_reset_hook_t hook);
+		void sim_schedule(uint64_t cycles, sim_event_hook_t hook);
+		void sim_set_reset_cause(reset_cause_t cause);
+		void sim_reset(reset_cause_t cause);
+
+		// EEPROM image, nvm_sim.c
+		bool sim_eeprom_open(const char* path);
+		void sim_eeprom_close(void);
+		uint8_t* sim_eeprom_data(void);
+		uint32_t sim_eeprom_count(sim_nvm_unit_t unit);
+		void sim_eeprom_set_power_cut(sim_nvm_unit_t unit, uint32_t count, sim_event_hook_t hook);
+		uint32_t sim_eeprom_page_wear(uint8_t page);
+
+		// USB device, usb_sim.c
+		void usb_sim_set_attach_ms(uint32_t ms);
+		void usb_sim_set_in_hook(sim_usb_in_hook_t hook);
+		void usb_sim_set_host_read_hook(sim_usb_in_hook_t hook);
+		void usb_sim_set_in_held(bool held);
+		uint16_t usb_sim_packet_in(const uint8_t* packets, uint16_t length);
+		uint16_t usb_sim_packet_in_space(void);
+		void usb_sim_advance(void);
+		void usb_sim_frame(void);
+		bool usb_sim_is_attached(void);
+
+		// Used by usb_sim.c and nvm_sim.c
+		void sim_charge_us(uint32_t us);
+		bool sim_midi_in_pop(uint8_t* data);
+		void sim_usb_frame_flag(void);
+		void sim_usb_trncompl(void);
+
+#endif /* HAL_SIM_H_ */
@@ -0,0 +1,278 @@
+/*
+ * midi_bridge.c
+ *
+ * Created: 10/18/2026 9:20:41 PM
+ *
+ *  Virtual MIDI ports for twister_sim, see midi_bridge.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "midi_bridge.h"
+#include "hal_sim.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if TWISTER_ALSA
+	#include <alsa/asoundlib.h>
+#endif
+
+// Longest message taken from the sequencer in one event, the firmware's
+// SysEx are all shorter
+#define BRIDGE_EVENT_SIZE	256
+
+#define PACKET_SIZE			4
+
+typedef enum {
+	bridge_none = 0,
+	bridge_alsa,
+	bridge_fifo,
+} bridge_t;
+
+static bridge_t bridge;
+
+// Pipe bridge
+static int  fifo_in_fd  = -1;
+static int  fifo_out_fd = -1;
+static char fifo_in_path[256];
+static char fifo_out_path[256];
+
+// Bytes of a packet read from 'in' so far
+static uint8_t fifo_packet[PACKET_SIZE];
+static uint8_t fifo_packet_length;
+
+#if TWISTER_ALSA
+
+static snd_seq_t*        seq;
+static int               seq_port;
+static snd_midi_event_t* seq_encoder;
+static snd_midi_event_t* seq_decoder;
+
+/**
+ * Sends the firmware's MIDI to whatever is connected to the port.
+ */
+
+static void alsa_midi_out(const uint8_t* data, uint16_t length)
+{
+	for (uint16_t i=0;i<length;++i) {
+		snd_seq_event_t ev;
+		snd_seq_ev_clear(&ev);
+
+		if (snd_midi_event_encode_byte(seq_encoder, data[i], &ev) == 1) {
+			snd_seq_ev_set_source(&ev, seq_port);
+			snd_seq_ev_set_subs(&ev);
+			snd_seq_ev_set_direct(&ev);
+			snd_seq_event_output_direct(seq, &ev);
+		}
+	}
+}
+
+static void alsa_poll(void)
+{
+	// Events stay queued in the sequencer until the firmware has room
+	while (sim_midi_in_space() >= BRIDGE_EVENT_SIZE) {
+		snd_seq_event_t* ev;
+		int result = snd_seq_event_input(seq, &ev);
+
+		if (result == -ENOSPC) {
+			fprintf(stderr, "sim: ALSA input overrun\n");
+			continue;
+		}
+		if (result < 0) {
+			return;
+		}
+
+		uint8_t buffer[BRIDGE_EVENT_SIZE];
+		long length = snd_midi_event_decode(seq_decoder, buffer, sizeof(buffer), ev);
+		if (length > 0) {
+			sim_midi_in(buffer, length);
+		}
+	}
+}
+
+bool midi_bridge_open_alsa(const char* name)
+{
+	if (snd_seq_open(&seq, "default", SND_SEQ_OPEN_DUPLEX, SND_SEQ_NONBLOCK) < 0) {
+		fprintf(stderr, "sim: cannot open the ALSA sequencer\n");
+		return false;
+	}
+
+	snd_seq_set_client_name(seq, name);
+	seq_port = snd_seq_create_simple_port(seq, name,
+	                                      SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ |
+	                                      SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+	                                      SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+
+	if (seq_port < 0 || snd_midi_event_new(BRIDGE_EVENT_SIZE, &seq_encoder) < 0 ||
+	    snd_midi_event_new(BRIDGE_EVENT_SIZE, &seq_decoder) < 0) {
+		fprintf(stderr, "sim: cannot create the ALSA port\n");
+		midi_bridge_close();
+		return false;
+	}
+
+	// Every message is decoded whole, the firmware's parser is happier
+	// without running status
+	snd_midi_event_no_status(seq_decoder, 1);
+
+	bridge = bridge_alsa;
+	sim_set_midi_out_hook(alsa_midi_out);
+
+	fprintf(stderr, "sim: MIDI on ALSA port %d:%d\n", snd_seq_client_id(seq), seq_port);
+	return true;
+}
+
+#else
+
+bool midi_bridge_open_alsa(const char* name)
+{
+	(void)name;
+	fprintf(stderr, "sim: built without ALSA, use --fifo or --pty\n");
+	return false;
+}
+
+#endif
+
+/**
+ * Sends the packets the host read to 'out', whole packets only.
+ */
+
+static void fifo_packets_out(const uint8_t* packets, uint8_t length)
+{
+	if (!length) {
+		return;
+	}
+
+	// Pipe writes this small either go whole or not at all
+	if (write(fifo_out_fd, packets, length) < 0 && errno != EAGAIN) {
+		perror(fifo_out_path);
+	}
+}
+
+static void fifo_poll(void)
+{
+	uint8_t buffer[256];
+
+	while (usb_sim_packet_in_space() >= sizeof(buffer)) {
+		ssize_t length = read(fifo_in_fd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			return;
+		}
+
+		// Packets may be split between reads
+		for (ssize_t i=0;i<length;++i) {
+			fifo_packet[fifo_packet_length++] = buffer[i];
+			if (fifo_packet_length == PACKET_SIZE) {
+				usb_sim_packet_in(fifo_packet, PACKET_SIZE);
+				fifo_packet_length = 0;
+			}
+		}
+	}
+}
+
+static int open_fifo(const char* path, int flags)
+{
+	if (mkfifo(path, 0666) < 0 && errno != EEXIST) {
+		perror(path);
+		return -1;
+	}
+
+	int fd = open(path, flags | O_NONBLOCK);
+	if (fd < 0) {
+		perror(path);
+	}
+	return fd;
+}
+
+bool midi_bridge_open_fifo(const char* dir)
+{
+	if (mkdir(dir, 0777) < 0 && errno != EEXIST) {
+		perror(dir);
+		return false;
+	}
+
+	snprintf(fifo_in_path, sizeof(fifo_in_path), "%s/in", dir);
+	snprintf(fifo_out_path, sizeof(fifo_out_path), "%s/out", dir);
+
+	// Both ends are held open for reading and writing, so neither waits
+	// for the other side nor sees it go away
+	fifo_in_fd  = open_fifo(fifo_in_path, O_RDWR);
+	fifo_out_fd = open_fifo(fifo_out_path, O_RDWR);
+
+	if (fifo_in_fd < 0 || fifo_out_fd < 0) {
+		midi_bridge_close();
+		return false;
+	}
+
+	bridge = bridge_fifo;
+	usb_sim_set_host_read_hook(fifo_packets_out);
+
+	fprintf(stderr, "sim: USB-MIDI on %s and %s\n", fifo_in_path, fifo_out_path);
+	return true;
+}
+
+void midi_bridge_poll(void)
+{
+	switch (bridge) {
+		#if TWISTER_ALSA
+		case bridge_alsa:
+			alsa_poll();
+			break;
+		#endif
+		case bridge_fifo:
+			fifo_poll();
+			break;
+		default:
+			break;
+	}
+}
+
+void midi_bridge_close(void)
+{
+	#if TWISTER_ALSA
+	if (seq_encoder) {
+		snd_midi_event_free(seq_encoder);
+		seq_encoder = NULL;
+	}
+	if (seq_decoder) {
+		snd_midi_event_free(seq_decoder);
+		seq_decoder = NULL;
+	}
+	if (seq) {
+		snd_seq_close(seq);
+		seq = NULL;
+	}
+	#endif
+
+	if (fifo_in_fd >= 0) {
+		close(fifo_in_fd);
+		fifo_in_fd = -1;
+	}
+	if (fifo_out_fd >= 0) {
+		close(fifo_out_fd);
+		fifo_out_fd = -1;
+	}
+
+	if (bridge == bridge_alsa) {
+		sim_set_midi_out_hook(NULL);
+	} else if (bridge == bridge_fifo) {
+		usb_sim_set_host_read_hook(NULL);
+	}
+	bridge = bridge_none;
+}
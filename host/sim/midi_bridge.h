@@ -0,0 +1,59 @@
+/*
+ * midi_bridge.h
+ *
+ * Created: 10/18/2026 9:14:03 PM
+ *
+ *  Virtual MIDI ports for twister_sim, so a DAW or any other MIDI software
+ *  can use the simulated Twister as if it were plugged in.
+ *
+ *  The ALSA sequencer bridge creates a client and a duplex port named
+ *  after the device, which other software connects to as to a USB port.
+ *  MIDI goes through the sequencer as events, so it is the MIDI byte
+ *  stream of the device rather than its USB-MIDI packets.
+ *
+ *  The pipe bridge makes two FIFOs in a directory. 'out' carries the
+ *  USB-MIDI event packets the host reads from the MIDI IN endpoint, four
+ *  bytes each exactly as MIDI_Device_SendEventPacket() built them, and
+ *  packets written to 'in' are handed to the firmware unchanged for
+ *  MIDI_Device_ReceiveEventPacket(). Packets are dropped while nothing
+ *  empties 'out'. USB-MIDI needs the device enumerated, so the pipes are
+ *  idle with --legacy.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef MIDI_BRIDGE_H_
+#define MIDI_BRIDGE_H_
+
+	/*	Includes: */
+
+		#include <stdbool.h>
+		#include <stdint.h>
+
+	/*	Function Prototypes: */
+
+		// Only in builds with ALSA, otherwise it fails with a message
+		bool midi_bridge_open_alsa(const char* name);
+
+		// Makes DIR/in and DIR/out, DIR is created if missing
+		bool midi_bridge_open_fifo(const char* dir);
+
+		// Moves host MIDI to the firmware, once per frame
+		void midi_bridge_poll(void);
+
+		void midi_bridge_close(void);
+
+#endif /* MIDI_BRIDGE_H_ */
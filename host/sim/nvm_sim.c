@@ -0,0 +1,285 @@
+/*
+ * nvm_sim.c
+ *
+ * Created: 10/18/2026 1:52:08 PM
+ *
+ *  The simulated EEPROM. The 2 kB image is kept in RAM and written through
+ *  to a file after every page write so settings survive between runs, a
+ *  new file starts out erased. A page write keeps the NVM controller busy
+ *  for SIM_EEPROM_PAGE_WRITE_US and the next EEPROM access waits for it,
+ *  the same as the ASF driver.
+ *
+ *  As on the XMEGA only the bytes loaded into the page buffer are erased
+ *  and written. A page write is modelled as the erase of each loaded byte
+ *  in turn, then the write of each, so power can be cut after any one of
+ *  those byte operations or after any whole page, see
+ *  sim_eeprom_set_power_cut(). The page buffer is lost with the power.
+ *  Every page write counts against the wear of its page.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static uint8_t eeprom[EEPROM_SIZE];
+
+// The NVM page buffer and which of its bytes have been loaded
+static uint8_t  page_buffer[EEPROM_PAGE_SIZE];
+static uint32_t page_loaded;
+
+static uint64_t busy_until;
+static int      eeprom_fd = -1;
+
+// Byte erases and writes, and page writes, since start up
+static uint32_t nvm_count[2];
+
+// Power is cut once the count of the given unit reaches cut_at
+static sim_nvm_unit_t   cut_unit;
+static uint32_t         cut_at;
+static sim_event_hook_t cut_hook;
+
+// Page erase and write cycles
+static uint32_t page_wear[EEPROM_SIZE / EEPROM_PAGE_SIZE];
+
+/**
+ * Opens the EEPROM image file, creating an erased one if it does not
+ * exist. Without a file the EEPROM starts erased and is lost on exit.
+ *
+ * \param path [in]	Image file name, NULL for none
+ *
+ * \return	false if the file could not be opened
+ */
+
+bool sim_eeprom_open(const char* path)
+{
+	memset(eeprom, 0xFF, sizeof(eeprom));
+
+	if (!path) {
+		return true;
+	}
+
+	eeprom_fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (eeprom_fd < 0) {
+		perror(path);
+		return false;
+	}
+
+	ssize_t length = pread(eeprom_fd, eeprom, sizeof(eeprom), 0);
+	if (length < 0) {
+		perror(path);
+		return false;
+	}
+
+	// A short or new file is padded out with erased bytes
+	if (length < (ssize_t)sizeof(eeprom)) {
+		memset(&eeprom[length], 0xFF, sizeof(eeprom) - length);
+		if (pwrite(eeprom_fd, eeprom, sizeof(eeprom), 0) != (ssize_t)sizeof(eeprom)) {
+			perror(path);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void sim_eeprom_close(void)
+{
+	if (eeprom_fd >= 0) {
+		close(eeprom_fd);
+		eeprom_fd = -1;
+	}
+}
+
+uint8_t* sim_eeprom_data(void)
+{
+	return eeprom;
+}
+
+uint32_t sim_eeprom_count(sim_nvm_unit_t unit)
+{
+	return nvm_count[unit];
+}
+
+/**
+ * Arms a power cut. Power goes once the byte operations or page writes
+ * since start up reach count, the page being written is left as far as it
+ * got and the image file updated, then the hook is called. The hook must
+ * not return to the firmware, if it does the process exits.
+ *
+ * \param unit [in]	Whether count is of byte operations or page writes
+ * \param count [in]	Count to cut the power at, 0 disarms
+ * \param hook [in]	Called once the power is cut
+ */
+
+void sim_eeprom_set_power_cut(sim_nvm_unit_t unit, uint32_t count, sim_event_hook_t hook)
+{
+	cut_unit = unit;
+	cut_at   = count;
+	cut_hook = hook;
+}
+
+uint32_t sim_eeprom_page_wear(uint8_t page)
+{
+	return page < sizeof(page_wear) / sizeof(page_wear[0]) ? page_wear[page] : 0;
+}
+
+/**
+ * Waits for a page write in progress to finish.
+ */
+
+static void wait_until_ready(void)
+{
+	uint64_t now = sim_get_cycles();
+
+	if (busy_until > now) {
+		sim_advance(busy_until - now);
+	}
+}
+
+static void write_through(uint16_t base)
+{
+	if (eeprom_fd >= 0 &&
+	    pwrite(eeprom_fd, &eeprom[base], EEPROM_PAGE_SIZE, base) != EEPROM_PAGE_SIZE) {
+		perror("sim: eeprom");
+	}
+}
+
+/**
+ * Cuts the power, the page buffer goes with it.
+ */
+
+static void power_cut(uint16_t base)
+{
+	write_through(base);
+
+	page_loaded = 0;
+	memset(page_buffer, 0xFF, sizeof(page_buffer));
+	cut_at = 0;
+
+	if (cut_hook) {
+		cut_hook();
+	}
+
+	fprintf(stderr, "sim: power cut at %llu ms\n", (unsigned long long)(sim_get_time_us() / 1000));
+	sim_exit(SIM_EXIT_RESET);
+}
+
+/**
+ * Erases then writes the loaded bytes of the page buffer to a page, one
+ * byte at a time so a power cut can land between any two, then writes the
+ * page through to the image file.
+ */
+
+static void write_page(uint8_t page_addr)
+{
+	uint16_t base = (uint16_t)page_addr * EEPROM_PAGE_SIZE;
+
+	if (base >= EEPROM_SIZE) {
+		return;
+	}
+
+	page_wear[page_addr]++;
+
+	for (uint8_t pass=0;pass<2;++pass) {
+		for (uint8_t i=0;i<EEPROM_PAGE_SIZE;++i) {
+			if (!(page_loaded & (1UL << i))) {
+				continue;
+			}
+
+			eeprom[base + i] = pass ? page_buffer[i] : 0xFF;
+
+			if (++nvm_count[sim_nvm_bytes] == cut_at && cut_unit == sim_nvm_bytes) {
+				power_cut(base);
+			}
+		}
+	}
+
+	page_loaded = 0;
+	memset(page_buffer, 0xFF, sizeof(page_buffer));
+
+	write_through(base);
+
+	if (++nvm_count[sim_nvm_pages] == cut_at && cut_unit == sim_nvm_pages) {
+		power_cut(base);
+	}
+
+	busy_until = sim_get_cycles() + (uint64_t)SIM_EEPROM_PAGE_WRITE_US * SIM_CYCLES_PER_US;
+}
+
+uint8_t nvm_eeprom_read_byte(eeprom_addr_t addr)
+{
+	wait_until_ready();
+	return eeprom[addr % EEPROM_SIZE];
+}
+
+void nvm_eeprom_read_buffer(eeprom_addr_t address, void *buf, uint16_t len)
+{
+	wait_until_ready();
+
+	for (uint16_t i=0;i<len;++i) {
+		((uint8_t*)buf)[i] = eeprom[(address + i) % EEPROM_SIZE];
+	}
+}
+
+void nvm_eeprom_write_byte(eeprom_addr_t address, uint8_t value)
+{
+	wait_until_ready();
+
+	page_buffer[address % EEPROM_PAGE_SIZE] = value;
+	page_loaded = 1UL << (address % EEPROM_PAGE_SIZE);
+
+	write_page(address / EEPROM_PAGE_SIZE);
+}
+
+void nvm_eeprom_erase_and_write_buffer(eeprom_addr_t address, const void *buf, uint16_t len)
+{
+	const uint8_t* data = buf;
+
+	while (len) {
+		wait_until_ready();
+
+		uint8_t offset = address % EEPROM_PAGE_SIZE;
+		page_loaded = 0;
+
+		do {
+			page_buffer[offset] = *data++;
+			page_loaded |= 1UL << offset;
+			++offset;
+			++address;
+			--len;
+		} while (len && offset < EEPROM_PAGE_SIZE);
+
+		write_page((address - 1) / EEPROM_PAGE_SIZE);
+	}
+}
+
+void nvm_eeprom_load_page_to_buffer(const uint8_t *values)
+{
+	wait_until_ready();
+
+	memcpy(page_buffer, values, EEPROM_PAGE_SIZE);
+	page_loaded = 0xFFFFFFFFUL;
+}
+
+void nvm_eeprom_atomic_write_page(uint8_t page_addr)
+{
+	wait_until_ready();
+	write_page(page_addr);
+}
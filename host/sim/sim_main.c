@@ -0,0 +1,268 @@
+/*
+ * sim_main.c
+ *
+ * Created: 10/18/2026 2:31:19 PM
+ *
+ *  Command line front end of the host simulator. It connects the host MIDI
+ *  stream to stdin/stdout, a pseudo-terminal or a virtual MIDI port, opens
+ *  the EEPROM image and runs the firmware, optionally with a terminal view
+ *  of the device.
+ *
+ *  twister_sim [options]
+ *    -e, --eeprom FILE   EEPROM image, created erased if missing
+ *    -t, --time MS       stop after MS milliseconds of simulated time
+ *    -r, --realtime      hold simulated time to the host clock
+ *    -p, --pty           use a pseudo-terminal for MIDI, its name is
+ *                        printed to stderr
+ *    -a, --attach MS     enumerate over USB after MS milliseconds
+ *    -l, --legacy        never enumerate, use the legacy MIDI port
+ *    -s, --alsa NAME     be an ALSA sequencer port named NAME
+ *    -f, --fifo DIR      USB-MIDI packets on the FIFOs DIR/in and DIR/out
+ *    -u, --tui           show the encoders on the terminal, MIDI must
+ *                        then go to a pseudo-terminal or virtual port
+ *
+ *  With a DAW, run in real time:
+ *
+ *    twister_sim --eeprom twister.eep --realtime --alsa "Midi Fighter Twister" --tui
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#define _GNU_SOURCE
+
+#include "hal_sim.h"
+#include "midi_bridge.h"
+#include "tui.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+static int midi_in_fd  = STDIN_FILENO;
+static int midi_out_fd = STDOUT_FILENO;
+
+// Held open so the pseudo-terminal stays up while no client is attached
+static int pty_slave_fd = -1;
+
+/**
+ * Reads what the host MIDI stream has ready, once per frame.
+ */
+
+static void poll_midi_in(void)
+{
+	uint8_t buffer[256];
+
+	if (midi_in_fd < 0) {
+		return;
+	}
+
+	uint16_t space = sim_midi_in_space();
+	if (space > sizeof(buffer)) {
+		space = sizeof(buffer);
+	}
+
+	if (!space) {
+		return;
+	}
+
+	ssize_t length = read(midi_in_fd, buffer, space);
+	if (length > 0) {
+		sim_midi_in(buffer, length);
+	} else if (length == 0 && midi_in_fd == STDIN_FILENO) {
+		// End of the input file, the firmware keeps running
+		midi_in_fd = -1;
+	}
+}
+
+static void on_frame(void)
+{
+	poll_midi_in();
+	midi_bridge_poll();
+	tui_frame();
+}
+
+/**
+ * Writes MIDI from the firmware to the host stream, dropping it if the
+ * stream is not being read.
+ */
+
+static void write_midi_out(const uint8_t* data, uint16_t length)
+{
+	while (length) {
+		ssize_t written = write(midi_out_fd, data, length);
+		if (written <= 0) {
+			return;
+		}
+		data += written;
+		length -= written;
+	}
+}
+
+static bool open_pty(void)
+{
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (master < 0 || grantpt(master) || unlockpt(master)) {
+		perror("sim: pty");
+		return false;
+	}
+
+	const char* name = ptsname(master);
+	pty_slave_fd = open(name, O_RDWR | O_NOCTTY);
+	if (pty_slave_fd < 0) {
+		perror(name);
+		return false;
+	}
+
+	// MIDI is binary, no line discipline
+	struct termios tio;
+	tcgetattr(pty_slave_fd, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(pty_slave_fd, TCSANOW, &tio);
+
+	fcntl(master, F_SETFL, O_NONBLOCK);
+	midi_in_fd  = master;
+	midi_out_fd = master;
+
+	fprintf(stderr, "sim: MIDI on %s\n", name);
+	return true;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options]\n"
+	        "  -e, --eeprom FILE   EEPROM image, created erased if missing\n"
+	        "  -t, --time MS       stop after MS milliseconds of simulated time\n"
+	        "  -r, --realtime      hold simulated time to the host clock\n"
+	        "  -p, --pty           use a pseudo-terminal for MIDI\n"
+	        "  -a, --attach MS     enumerate over USB after MS milliseconds\n"
+	        "  -l, --legacy        never enumerate, use the legacy MIDI port\n"
+	        "  -s, --alsa NAME     be an ALSA sequencer port named NAME\n"
+	        "  -f, --fifo DIR      USB-MIDI packets on the FIFOs DIR/in and DIR/out\n"
+	        "  -u, --tui           show the encoders on the terminal\n",
+	        name);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option options[] = {
+		{"eeprom",   required_argument, NULL, 'e'},
+		{"time",     required_argument, NULL, 't'},
+		{"realtime", no_argument,       NULL, 'r'},
+		{"pty",      no_argument,       NULL, 'p'},
+		{"attach",   required_argument, NULL, 'a'},
+		{"legacy",   no_argument,       NULL, 'l'},
+		{"alsa",     required_argument, NULL, 's'},
+		{"fifo",     required_argument, NULL, 'f'},
+		{"tui",      no_argument,       NULL, 'u'},
+		{"help",     no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	const char* eeprom_path = NULL;
+	uint32_t run_ms = 0;
+	bool use_realtime = false;
+	bool use_pty = false;
+	const char* alsa_name = NULL;
+	const char* fifo_dir = NULL;
+	bool use_tui = false;
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "e:t:rpa:ls:f:uh", options, NULL)) != -1) {
+		switch (opt) {
+			case 'e':
+				eeprom_path = optarg;
+				break;
+			case 't':
+				run_ms = strtoul(optarg, NULL, 0);
+				break;
+			case 'r':
+				use_realtime = true;
+				break;
+			case 'p':
+				use_pty = true;
+				break;
+			case 'a':
+				usb_sim_set_attach_ms(strtoul(optarg, NULL, 0));
+				break;
+			case 'l':
+				usb_sim_set_attach_ms(0);
+				break;
+			case 's':
+				alsa_name = optarg;
+				break;
+			case 'f':
+				fifo_dir = optarg;
+				break;
+			case 'u':
+				use_tui = true;
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? SIM_EXIT_OK : SIM_EXIT_ERROR;
+		}
+	}
+
+	// The MIDI goes one way only, and the terminal view needs the terminal
+	if (use_pty + !!alsa_name + !!fifo_dir > 1 ||
+	    (use_tui && !use_pty && !alsa_name && !fifo_dir)) {
+		usage(argv[0]);
+		return SIM_EXIT_ERROR;
+	}
+
+	if (!sim_eeprom_open(eeprom_path)) {
+		return SIM_EXIT_ERROR;
+	}
+
+	if (alsa_name || fifo_dir) {
+		if (alsa_name ? !midi_bridge_open_alsa(alsa_name) : !midi_bridge_open_fifo(fifo_dir)) {
+			return SIM_EXIT_ERROR;
+		}
+		midi_in_fd  = -1;
+		midi_out_fd = -1;
+	} else if (use_pty) {
+		if (!open_pty()) {
+			return SIM_EXIT_ERROR;
+		}
+	} else {
+		fcntl(midi_in_fd, F_SETFL, fcntl(midi_in_fd, F_GETFL) | O_NONBLOCK);
+	}
+
+	if (use_tui && !tui_open()) {
+		return SIM_EXIT_ERROR;
+	}
+
+	// A reader going away only stops the MIDI output
+	signal(SIGPIPE, SIG_IGN);
+
+	sim_set_frame_hook(on_frame);
+	if (midi_out_fd >= 0) {
+		sim_set_midi_out_hook(write_midi_out);
+	}
+	sim_set_time_limit_ms(run_ms);
+	sim_set_realtime(use_realtime);
+
+	firmware_main();
+
+	sim_exit(SIM_EXIT_OK);
+	return SIM_EXIT_OK;
+}
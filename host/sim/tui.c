@@ -0,0 +1,318 @@
+/*
+ * tui.c
+ *
+ * Created: 10/18/2026 9:45:12 PM
+ *
+ *  Terminal view of the simulated Twister, see tui.h.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "tui.h"
+#include "hal_sim.h"
+#include "display_driver.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Host time between redraws
+#define TUI_REDRAW_MS		50
+
+#define TUI_COLUMNS			4
+#define INDICATOR_LEDS		11
+
+// Bits of an encoder's first byte in each frame, its top 3 bits hold
+// indicator LEDs 9 to 11 and the second byte LEDs 1 to 8, from the top bit
+// down. All are active low
+#define LED_DETENT_BLUE		0x01
+#define LED_DETENT_RED		0x02
+#define LED_BLUE			0x04
+#define LED_RED				0x08
+#define LED_GREEN			0x10
+
+typedef struct {
+	uint8_t indicator[INDICATOR_LEDS];
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	uint8_t detent_red;
+	uint8_t detent_blue;
+} encoder_leds_t;
+
+static bool            tui_is_open;
+static struct termios  saved_tio;
+static uint64_t        last_draw_ms;
+static volatile bool   stop;
+
+static uint8_t selected;
+static bool    pressed[SIM_ENCODERS];
+
+// Quadrature edges still to step, one per frame
+static int16_t pending_edges[SIM_ENCODERS];
+
+// Partial escape sequence from the keyboard
+static uint8_t escape;
+
+static uint64_t host_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	stop = true;
+}
+
+/**
+ * Share of the frames an LED is lit for, 0 to 255.
+ */
+
+static uint8_t duty(uint8_t frames)
+{
+	return (uint16_t)frames * 255 / NUM_OF_FRAMES;
+}
+
+/**
+ * Works out an encoder's LED levels from the frame buffer, each LED is lit
+ * for the share of the frames its bit is low in.
+ */
+
+static void decode_encoder(const uint8_t* buffer, uint8_t encoder, encoder_leds_t* leds)
+{
+	uint8_t indicator[INDICATOR_LEDS] = {0};
+	uint8_t red = 0, green = 0, blue = 0, detent_red = 0, detent_blue = 0;
+
+	const uint8_t* ptr = buffer + (15 - encoder) * 2;
+
+	for (uint8_t f=0;f<NUM_OF_FRAMES;++f) {
+		uint8_t low  = ~ptr[0];
+		uint8_t high = ~ptr[1];
+
+		red         += !!(low & LED_RED);
+		green       += !!(low & LED_GREEN);
+		blue        += !!(low & LED_BLUE);
+		detent_red  += !!(low & LED_DETENT_RED);
+		detent_blue += !!(low & LED_DETENT_BLUE);
+
+		for (uint8_t i=0;i<8;++i) {
+			indicator[i] += !!(high & (0x80 >> i));
+		}
+		for (uint8_t i=0;i<3;++i) {
+			indicator[8 + i] += !!(low & (0x80 >> i));
+		}
+
+		ptr += DMA_FRAME_SIZE;
+	}
+
+	for (uint8_t i=0;i<INDICATOR_LEDS;++i) {
+		leds->indicator[i] = duty(indicator[i]);
+	}
+	leds->red         = duty(red);
+	leds->green       = duty(green);
+	leds->blue        = duty(blue);
+	leds->detent_red  = duty(detent_red);
+	leds->detent_blue = duty(detent_blue);
+}
+
+/**
+ * Draws the encoders four to a row, the picked one marked.
+ */
+
+static void draw(void)
+{
+	// The buffer is only read, as the DMA reads it
+	const uint8_t* buffer = get_display_frame_buffer();
+
+	static char screen[16384];
+	size_t length = 0;
+
+	#define EMIT(...) length += snprintf(screen + length, sizeof(screen) - length, __VA_ARGS__)
+
+	EMIT("\x1b[H");
+
+	for (uint8_t row=0;row<SIM_ENCODERS / TUI_COLUMNS;++row) {
+		encoder_leds_t leds[TUI_COLUMNS];
+		for (uint8_t col=0;col<TUI_COLUMNS;++col) {
+			decode_encoder(buffer, row * TUI_COLUMNS + col, &leds[col]);
+		}
+
+		// The indicator ring
+		for (uint8_t col=0;col<TUI_COLUMNS;++col) {
+			uint8_t encoder = row * TUI_COLUMNS + col;
+			EMIT("%s", encoder == selected ? "\x1b[1m>\x1b[0m" : " ");
+			for (uint8_t i=0;i<INDICATOR_LEDS;++i) {
+				uint8_t level = leds[col].indicator[i];
+				uint8_t shade = 40 + level * 215 / 255;
+				EMIT("\x1b[38;2;%u;%u;%um%s", shade, shade, shade, level ? "●" : "·");
+			}
+			EMIT("\x1b[0m%s   ", encoder == selected ? "\x1b[1m<\x1b[0m" : " ");
+		}
+		EMIT("\x1b[K\r\n");
+
+		// The RGB segment and the detent LED
+		for (uint8_t col=0;col<TUI_COLUMNS;++col) {
+			uint8_t encoder = row * TUI_COLUMNS + col;
+			const encoder_leds_t* l = &leds[col];
+			EMIT("  \x1b[38;2;%u;%u;%um█████", l->red, l->green, l->blue);
+			EMIT(" \x1b[38;2;%u;0;%um%s", l->detent_red, l->detent_blue,
+			     (l->detent_red || l->detent_blue) ? "◆" : " ");
+			EMIT("\x1b[0m %c%-2u     ", pressed[encoder] ? '*' : ' ', encoder + 1);
+		}
+		EMIT("\x1b[K\r\n\x1b[K\r\n");
+	}
+
+	EMIT("%7.2f s   arrows pick, + - turn, space press, q quit\x1b[K", sim_get_time_us() / 1e6);
+
+	#undef EMIT
+
+	if (length >= sizeof(screen)) {
+		length = sizeof(screen) - 1;
+	}
+	fwrite(screen, 1, length, stdout);
+	fflush(stdout);
+}
+
+static void move_selection(int8_t rows, int8_t cols)
+{
+	uint8_t row = (selected / TUI_COLUMNS + rows + TUI_COLUMNS) % TUI_COLUMNS;
+	uint8_t col = (selected % TUI_COLUMNS + cols + TUI_COLUMNS) % TUI_COLUMNS;
+	selected = row * TUI_COLUMNS + col;
+}
+
+static void handle_key(uint8_t key)
+{
+	// Arrow keys arrive as ESC [ A to D
+	if (escape == 1) {
+		escape = key == '[' ? 2 : 0;
+		return;
+	}
+	if (escape == 2) {
+		escape = 0;
+		switch (key) {
+			case 'A': move_selection(-1, 0); break;
+			case 'B': move_selection(1, 0);  break;
+			case 'C': move_selection(0, 1);  break;
+			case 'D': move_selection(0, -1); break;
+		}
+		return;
+	}
+
+	switch (key) {
+		case 0x1b:
+			escape = 1;
+			break;
+		case 'k': move_selection(-1, 0); break;
+		case 'j': move_selection(1, 0);  break;
+		case 'l': move_selection(0, 1);  break;
+		case 'h': move_selection(0, -1); break;
+		case '+':
+		case '=':
+			pending_edges[selected] += 4;
+			break;
+		case '-':
+		case '_':
+			pending_edges[selected] -= 4;
+			break;
+		case ' ':
+			pressed[selected] = !pressed[selected];
+			sim_encoder_switch(selected, pressed[selected]);
+			break;
+		case 'q':
+			stop = true;
+			break;
+	}
+}
+
+bool tui_open(void)
+{
+	if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+		fprintf(stderr, "sim: the terminal view needs a terminal\n");
+		return false;
+	}
+
+	struct termios tio;
+	tcgetattr(STDIN_FILENO, &saved_tio);
+	tio = saved_tio;
+	tio.c_lflag &= ~(ICANON | ECHO);
+	tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+	fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+
+	tui_is_open = true;
+	atexit(tui_close);
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	// Clear the screen and hide the cursor
+	fputs("\x1b[2J\x1b[?25l", stdout);
+	fflush(stdout);
+	return true;
+}
+
+void tui_frame(void)
+{
+	if (!tui_is_open) {
+		return;
+	}
+
+	uint8_t keys[16];
+	ssize_t count = read(STDIN_FILENO, keys, sizeof(keys));
+	for (ssize_t i=0;i<count;++i) {
+		handle_key(keys[i]);
+	}
+
+	if (stop) {
+		sim_exit(SIM_EXIT_OK);
+	}
+
+	for (uint8_t i=0;i<SIM_ENCODERS;++i) {
+		if (pending_edges[i] > 0) {
+			sim_encoder_step(i, 1);
+			pending_edges[i]--;
+		} else if (pending_edges[i] < 0) {
+			sim_encoder_step(i, -1);
+			pending_edges[i]++;
+		}
+	}
+
+	uint64_t now = host_ms();
+	if (now - last_draw_ms >= TUI_REDRAW_MS) {
+		last_draw_ms = now;
+		draw();
+	}
+}
+
+void tui_close(void)
+{
+	if (!tui_is_open) {
+		return;
+	}
+	tui_is_open = false;
+
+	tcsetattr(STDIN_FILENO, TCSANOW, &saved_tio);
+	fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) & ~O_NONBLOCK);
+
+	// Show the cursor again below the view
+	fputs("\x1b[0m\x1b[?25h\r\n", stdout);
+	fflush(stdout);
+}
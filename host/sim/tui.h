@@ -0,0 +1,49 @@
+/*
+ * tui.h
+ *
+ * Created: 10/18/2026 9:38:56 PM
+ *
+ *  Terminal view of the simulated Twister for twister_sim. The 16 encoders
+ *  are drawn as on the device, each with its 11 indicator LEDs, the RGB
+ *  segment and the detent LED, decoded from the display frame buffer as
+ *  the LED drivers would show it. The keyboard turns and presses them.
+ *
+ *    arrows, hjkl    pick an encoder
+ *    + or -          turn it one detent up or down
+ *    space           press or release its switch
+ *    q               quit
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef TUI_H_
+#define TUI_H_
+
+	/*	Includes: */
+
+		#include <stdbool.h>
+
+	/*	Function Prototypes: */
+
+		// Takes over the terminal on stdin and stdout
+		bool tui_open(void);
+
+		// Reads the keyboard and redraws when due, once per frame
+		void tui_frame(void);
+
+		void tui_close(void);
+
+#endif /* TUI_H_ */
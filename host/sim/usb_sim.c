@@ -0,0 +1,476 @@
+/*
+ * usb_sim.c
+ *
+ * Created: 10/18/2026 2:07:45 PM
+ *
+ *  The simulated USB device controller and host. The host enumerates the
+ *  device a set time after power up by leaving a SETUP on the control
+ *  endpoint for USB_USBTask() to pick up, then starts a frame every 1 mS.
+ *  It reads the MIDI IN endpoint as soon as the firmware hands it over and
+ *  fills the MIDI OUT endpoint with the host MIDI stream, converting
+ *  between MIDI bytes and USB-MIDI event packets on cable 0. A host which
+ *  speaks USB-MIDI itself may take and give the packets as they are.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+#include "Descriptors.h"
+
+#include <stdio.h>
+
+// Enumeration is done by the time a real host has reset and addressed us
+#define USB_SIM_DEFAULT_ATTACH_MS	50
+
+typedef struct {
+	USB_EP_t regs;
+	uint8_t  data[MIDI_STREAM_EPSIZE];
+	uint8_t  length;
+	uint8_t  position;
+	bool     full;		// OUT holds host data, IN is waiting for the host
+} sim_endpoint_t;
+
+#define ENDPOINT_COUNT	3
+
+static sim_endpoint_t endpoints[ENDPOINT_COUNT];
+static uint8_t        selected_address;
+
+static uint32_t attach_ms = USB_SIM_DEFAULT_ATTACH_MS;
+static sim_usb_in_hook_t in_hook;
+static sim_usb_in_hook_t host_read_hook;
+static bool     in_held;
+static bool     attached;
+static bool     setup_pending;
+
+// Host MIDI byte stream to USB-MIDI packet parser
+static uint8_t parser_status;
+static uint8_t parser_data[3];
+static uint8_t parser_count;
+static bool    parser_sysex;
+
+// USB-MIDI packets from the host, sent ahead of the byte stream
+static uint8_t  packet_in_ring[SIM_USB_PACKET_IN_SIZE];
+static uint16_t packet_in_head;
+static uint16_t packet_in_tail;
+
+// Bytes carried by each USB-MIDI code index number
+static const uint8_t cin_length[16] = {0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1};
+
+volatile uint8_t USB_DeviceState;
+volatile USB_EP_t* USB_Endpoint_SelectedHandle;
+
+/**
+ * Sets when the host enumerates the device.
+ *
+ * \param ms [in]	Time after power up, 0 to leave the device unplugged so
+ *					the firmware falls back to legacy MIDI
+ */
+
+void usb_sim_set_attach_ms(uint32_t ms)
+{
+	attach_ms = ms;
+}
+
+void usb_sim_set_in_hook(sim_usb_in_hook_t hook)
+{
+	in_hook = hook;
+}
+
+/**
+ * Takes the packets the host reads from the MIDI IN endpoint as they are,
+ * instead of sending them to the host MIDI stream as bytes.
+ */
+
+void usb_sim_set_host_read_hook(sim_usb_in_hook_t hook)
+{
+	host_read_hook = hook;
+}
+
+/**
+ * Stops the host reading the MIDI IN endpoint, as a host with the port
+ * open and nothing reading it does. What the firmware has handed over
+ * stays in the endpoint until the host reads again.
+ */
+
+void usb_sim_set_in_held(bool held)
+{
+	in_held = held;
+}
+
+/**
+ * Queues USB-MIDI packets for the host to send on the MIDI OUT endpoint.
+ *
+ * \return The bytes queued, whole packets only
+ */
+
+uint16_t usb_sim_packet_in(const uint8_t* packets, uint16_t length)
+{
+	uint16_t queued = 0;
+
+	while (queued + 4 <= length && usb_sim_packet_in_space() >= 4) {
+		for (uint8_t i=0;i<4;++i) {
+			packet_in_ring[packet_in_head % SIM_USB_PACKET_IN_SIZE] = packets[queued++];
+			packet_in_head++;
+		}
+	}
+
+	return queued;
+}
+
+uint16_t usb_sim_packet_in_space(void)
+{
+	return SIM_USB_PACKET_IN_SIZE - (uint16_t)(packet_in_head - packet_in_tail);
+}
+
+bool usb_sim_is_attached(void)
+{
+	return attached;
+}
+
+static sim_endpoint_t* endpoint(uint8_t address)
+{
+	return &endpoints[(address & 0x0F) % ENDPOINT_COUNT];
+}
+
+// Byte stream conversion -----------------------------------------------------
+
+static void make_packet(MIDI_EventPacket_t* packet, uint8_t cin, const uint8_t* data, uint8_t length)
+{
+	packet->Event = cin;
+	packet->Data1 = length > 0 ? data[0] : 0;
+	packet->Data2 = length > 1 ? data[1] : 0;
+	packet->Data3 = length > 2 ? data[2] : 0;
+}
+
+/**
+ * Feeds one host MIDI byte to the parser.
+ *
+ * \return	true if it completed a packet
+ */
+
+static bool parse_byte(uint8_t byte, MIDI_EventPacket_t* packet)
+{
+	// Real time messages go straight through, even inside SysEx
+	if (byte >= 0xF8) {
+		make_packet(packet, 0x0F, &byte, 1);
+		return true;
+	}
+
+	if (byte == 0xF0) {
+		parser_sysex = true;
+		parser_status = 0;
+		parser_data[0] = byte;
+		parser_count = 1;
+		return false;
+	}
+
+	if (byte == 0xF7) {
+		if (!parser_sysex) {
+			return false;
+		}
+		parser_data[parser_count++] = byte;
+		make_packet(packet, 0x04 + parser_count, parser_data, parser_count);
+		parser_sysex = false;
+		parser_count = 0;
+		return true;
+	}
+
+	if (byte & 0x80) {
+		parser_sysex = false;
+		parser_count = 0;
+
+		if (byte == 0xF6) {
+			parser_status = 0;
+			make_packet(packet, 0x05, &byte, 1);
+			return true;
+		}
+
+		// Undefined system common messages are dropped
+		parser_status = (byte == 0xF4 || byte == 0xF5) ? 0 : byte;
+		return false;
+	}
+
+	if (parser_sysex) {
+		parser_data[parser_count++] = byte;
+		if (parser_count == 3) {
+			make_packet(packet, 0x04, parser_data, 3);
+			parser_count = 0;
+			return true;
+		}
+		return false;
+	}
+
+	if (!parser_status) {
+		return false;
+	}
+
+	// Running status
+	if (!parser_count) {
+		parser_data[parser_count++] = parser_status;
+	}
+	parser_data[parser_count++] = byte;
+
+	uint8_t needed;
+	if (parser_status == 0xF2 || (parser_status < 0xF0 && (parser_status & 0xE0) != 0xC0)) {
+		needed = 3;
+	} else {
+		needed = 2;
+	}
+
+	if (parser_count < needed) {
+		return false;
+	}
+
+	uint8_t cin = parser_status < 0xF0 ? parser_status >> 4 : needed;
+	make_packet(packet, cin, parser_data, needed);
+	parser_count = 0;
+
+	// System common messages do not set a running status
+	if (parser_status >= 0xF0) {
+		parser_status = 0;
+	}
+
+	return true;
+}
+
+/**
+ * Sends the packets the firmware has written to the host MIDI stream.
+ */
+
+static void send_packets(const uint8_t* data, uint8_t length)
+{
+	if (host_read_hook) {
+		host_read_hook(data, length);
+		return;
+	}
+
+	uint8_t bytes[MIDI_STREAM_EPSIZE];
+	uint8_t count = 0;
+
+	for (uint8_t i=0;i + 4 <= length;i += 4) {
+		uint8_t size = cin_length[data[i] & 0x0F];
+		memcpy(&bytes[count], &data[i + 1], size);
+		count += size;
+	}
+
+	sim_midi_out(bytes, count);
+}
+
+// Host -----------------------------------------------------------------------
+
+/**
+ * Starts each USB frame, attaching the device when its time comes.
+ */
+
+void usb_sim_frame(void)
+{
+	if (!attached && attach_ms && sim_get_time_us() >= attach_ms * 1000ULL &&
+	    USB_DeviceState == DEVICE_STATE_Powered) {
+		attached = true;
+		setup_pending = true;
+		USB_DeviceState = DEVICE_STATE_Default;
+	}
+
+	if (attached) {
+		sim_usb_frame_flag();
+	}
+}
+
+/**
+ * Moves MIDI between the host and the endpoints once configured.
+ */
+
+void usb_sim_advance(void)
+{
+	if (!attached || USB_DeviceState != DEVICE_STATE_Configured) {
+		return;
+	}
+
+	// A held host sends no IN tokens, so the endpoint is neither read nor NAKed
+	sim_endpoint_t* in = endpoint(MIDI_STREAM_IN_EPADDR);
+	if (!in_held) {
+		if (in->full) {
+			send_packets(in->data, in->length);
+			in->full = false;
+			in->length = 0;
+			in->position = 0;
+			in->regs.STATUS |= USB_EP_TRNCOMPL0_bm;
+		} else if (!in->position) {
+			in->regs.STATUS |= USB_EP_BUSNACK0_bm;
+		}
+	}
+
+	sim_endpoint_t* out = endpoint(MIDI_STREAM_OUT_EPADDR);
+	if (!out->full) {
+		MIDI_EventPacket_t packet;
+		uint8_t data;
+
+		while (out->length + sizeof(packet) <= MIDI_STREAM_EPSIZE && packet_in_head != packet_in_tail) {
+			for (uint8_t i=0;i<sizeof(packet);++i) {
+				out->data[out->length++] = packet_in_ring[packet_in_tail % SIM_USB_PACKET_IN_SIZE];
+				packet_in_tail++;
+			}
+		}
+
+		while (out->length + sizeof(packet) <= MIDI_STREAM_EPSIZE && sim_midi_in_pop(&data)) {
+			if (parse_byte(data, &packet)) {
+				memcpy(&out->data[out->length], &packet, sizeof(packet));
+				out->length += sizeof(packet);
+			}
+		}
+
+		if (out->length) {
+			out->full = true;
+			out->position = 0;
+			out->regs.STATUS |= USB_EP_TRNCOMPL0_bm;
+			if (!(out->regs.CTRL & USB_EP_INTDSBL_bm)) {
+				sim_usb_trncompl();
+			}
+		}
+	}
+}
+
+// LUFA device ----------------------------------------------------------------
+
+void USB_Init(void)
+{
+	memset(endpoints, 0x00, sizeof(endpoints));
+	endpoint(MIDI_STREAM_OUT_EPADDR)->regs.CTRL = USB_EP_INTDSBL_bm;
+
+	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+
+	attached = false;
+	setup_pending = false;
+	USB_DeviceState = DEVICE_STATE_Powered;
+}
+
+void USB_Disable(void)
+{
+	attached = false;
+	setup_pending = false;
+	USB.INTCTRLA = 0;
+	USB.INTCTRLB = 0;
+	USB_DeviceState = DEVICE_STATE_Unattached;
+}
+
+/**
+ * Handles the SET_CONFIGURATION left by the host, which LUFA does from
+ * the main loop since INTERRUPT_CONTROL_ENDPOINT is not set.
+ */
+
+void USB_USBTask(void)
+{
+	if (!attached || !setup_pending) {
+		return;
+	}
+
+	setup_pending = false;
+
+	uint8_t prev_endpoint = Endpoint_GetCurrentEndpoint();
+	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+	EVENT_USB_Device_ControlRequest();
+	USB_DeviceState = DEVICE_STATE_Configured;
+	EVENT_USB_Device_ConfigurationChanged();
+	Endpoint_SelectEndpoint(prev_endpoint);
+}
+
+void USB_Device_EnableSOFEvents(void)
+{
+	USB.INTCTRLA |= USB_SOFIE_bm;
+}
+
+uint8_t Endpoint_GetCurrentEndpoint(void)
+{
+	return selected_address;
+}
+
+void Endpoint_SelectEndpoint(const uint8_t Address)
+{
+	selected_address = Address;
+	USB_Endpoint_SelectedHandle = &endpoint(Address)->regs;
+}
+
+bool Endpoint_IsSETUPReceived(void)
+{
+	return (selected_address & 0x0F) == ENDPOINT_CONTROLEP && setup_pending;
+}
+
+bool Endpoint_IsOUTReceived(void)
+{
+	return !(selected_address & ENDPOINT_DIR_IN) && endpoint(selected_address)->full;
+}
+
+void Endpoint_ClearIN(void)
+{
+	sim_endpoint_t* ep = endpoint(selected_address);
+
+	ep->length = ep->position;
+	ep->full = true;
+	ep->regs.STATUS &= ~(USB_EP_TRNCOMPL0_bm | USB_EP_BUSNACK0_bm);
+
+	if (in_hook && ep == endpoint(MIDI_STREAM_IN_EPADDR)) {
+		in_hook(ep->data, ep->length);
+	}
+}
+
+void Endpoint_ClearOUT(void)
+{
+	sim_endpoint_t* ep = endpoint(selected_address);
+
+	ep->full = false;
+	ep->length = 0;
+	ep->position = 0;
+	ep->regs.STATUS &= ~USB_EP_TRNCOMPL0_bm;
+}
+
+uint8_t Endpoint_Read_8(void)
+{
+	sim_endpoint_t* ep = endpoint(selected_address);
+
+	return ep->position < ep->length ? ep->data[ep->position++] : 0;
+}
+
+void Endpoint_Write_8(const uint8_t Data)
+{
+	sim_endpoint_t* ep = endpoint(selected_address);
+
+	if (ep->position < MIDI_STREAM_EPSIZE) {
+		ep->data[ep->position++] = Data;
+	}
+}
+
+uint16_t Endpoint_BytesInEndpoint(void)
+{
+	sim_endpoint_t* ep = endpoint(selected_address);
+
+	if (selected_address & ENDPOINT_DIR_IN) {
+		return ep->position;
+	}
+	return ep->length - ep->position;
+}
+
+// LUFA MIDI class ------------------------------------------------------------
+
+bool MIDI_Device_ConfigureEndpoints(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo)
+{
+	UNUSED(MIDIInterfaceInfo);
+	return true;
+}
+
+void MIDI_Device_ProcessControlRequest(USB_ClassInfo_MIDI_Device_t* const MIDIInterfaceInfo)
+{
+	UNUSED(MIDIInterfaceInfo);
+}
@@ -0,0 +1,272 @@
+/*
+ * stress.c
+ *
+ * Created: 10/18/2026 11:24:10 AM
+ *
+ *  Checks the hand over of encoder movement from the scan interrupt to the
+ *  main loop. encoder_scan() runs from a POSIX interval timer signal, which
+ *  interrupts the reading side at any instruction just as the timer
+ *  compare interrupt does on the XMEGA, while the main thread reads the
+ *  encoders with get_encoder_value() and get_encoder_total() as fast as it
+ *  can.
+ *
+ *  Each interrupt moves every encoder by one quadrature edge, which the
+ *  scan counts as a step, the even encoders clockwise and the odd ones counter clockwise,
+ *  so the totals only ever move one way. A total that moves further than
+ *  the scans since the last read allow was torn, and once the interrupts
+ *  stop the values read must add up to the movement made. Every so often
+ *  the reader stalls until more steps have built up than an int8_t holds,
+ *  so the clamped reads are covered too.
+ *
+ *  The period is raised to a few times what a scan takes on this host, so
+ *  the reader keeps running between interrupts as the XMEGA's main loop
+ *  does. A reader held off for 32768 steps would lose them to the 16 bit
+ *  counts, which is not the hand over under test.
+ *
+ *  twister_stress [options]
+ *    -n, --scans N         interrupts to run, default 100000
+ *    -i, --interval-us US  shortest interrupt period, default 20
+ *
+ *  The exit status is 1 if any count was lost or torn.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "hal_sim.h"
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "input.h"
+
+#define ENCODERS			16
+
+// Reads between the stalls, and the scans waited for in each, enough for
+// more steps than one read returns
+#define STALL_EVERY			1000
+#define STALL_SCANS			300
+
+// Scans timed for the period, and the share of it one may take
+#define TIMED_SCANS			1000
+#define SCAN_SHARE			4
+
+typedef struct {
+	uint32_t scans;
+	uint32_t interval_us;
+} stress_options_t;
+
+static stress_options_t options = {
+	.scans       = 100000,
+	.interval_us = 20,
+};
+
+// Written only by the interrupt
+static volatile uint32_t scans;
+
+static int8_t direction(uint8_t encoder)
+{
+	return (encoder & 0x01) ? -1 : 1;
+}
+
+/**
+ * The scan interrupt, with the encoders moved on by an edge first.
+ */
+
+static void scan_interrupt(int sig)
+{
+	(void)sig;
+
+	for (uint8_t i=0;i<ENCODERS;++i) {
+		sim_encoder_step(i, direction(i));
+	}
+	encoder_scan();
+	scans++;
+}
+
+/**
+ * Times the scan interrupt, with the encoders moving, and returns the
+ * period which leaves the reader most of the time. The steps made are
+ * read out with the rest of what the scan saw first.
+ */
+
+static uint32_t scan_period_us(uint32_t shortest_us)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i=0;i<TIMED_SCANS;++i) {
+		scan_interrupt(0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	scans = 0;
+
+	uint64_t elapsed_ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+	uint32_t period_us  = elapsed_ns * SCAN_SHARE / TIMED_SCANS / 1000 + 1;
+
+	return period_us > shortest_us ? period_us : shortest_us;
+}
+
+static void set_interrupts(uint32_t interval_us)
+{
+	struct itimerval timer = {
+		.it_interval = {0, interval_us},
+		.it_value    = {0, interval_us},
+	};
+	setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+/**
+ * Stops the interrupts and waits out one which may already be running.
+ */
+
+static void stop_interrupts(void)
+{
+	sigset_t block;
+	sigemptyset(&block);
+	sigaddset(&block, SIGALRM);
+
+	set_interrupts(0);
+	sigprocmask(SIG_BLOCK, &block, NULL);
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+	        "usage: %s [options]\n"
+	        "  -n, --scans N         interrupts to run, default 100000\n"
+	        "  -i, --interval-us US  shortest interrupt period, default 20\n",
+	        name);
+}
+
+int main(int argc, char* argv[])
+{
+	static const struct option long_options[] = {
+		{"scans",       required_argument, NULL, 'n'},
+		{"interval-us", required_argument, NULL, 'i'},
+		{"help",        no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "n:i:h", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'n':
+				options.scans = strtoul(optarg, NULL, 0);
+				break;
+			case 'i':
+				options.interval_us = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				usage(argv[0]);
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!options.interval_us) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	// A first scan takes in the resting pin states, what it saw since
+	// power on is read out of the way
+	encoder_scan();
+	uint32_t interval_us = scan_period_us(options.interval_us);
+
+	uint16_t start_total[ENCODERS];
+	uint16_t last_total[ENCODERS];
+	uint32_t last_scans[ENCODERS];
+	int32_t  read_steps[ENCODERS] = {0};
+
+	for (uint8_t i=0;i<ENCODERS;++i) {
+		while (get_encoder_value(i)) {
+		}
+		start_total[i] = last_total[i] = get_encoder_total(i);
+		last_scans[i] = 0;
+	}
+
+	struct sigaction action = {.sa_handler = scan_interrupt};
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGALRM, &action, NULL);
+	set_interrupts(interval_us);
+
+	uint32_t torn = 0;
+	uint32_t clamped = 0;
+	uint32_t reads = 0;
+
+	while (scans < options.scans) {
+		for (uint8_t i=0;i<ENCODERS;++i) {
+			// The scans since the last read of this encoder, and one
+			// which may have been part way through it
+			uint32_t scans_before = last_scans[i];
+			uint32_t scans_after  = scans;
+			uint16_t total = get_encoder_total(i);
+			int8_t   value = get_encoder_value(i);
+
+			uint16_t moved = direction(i) > 0 ? total - last_total[i] : last_total[i] - total;
+			uint32_t most  = scans - scans_before + 1;
+
+			if (moved > most) {
+				if (torn++ < 10) {
+					printf("encoder %u: total moved %u steps in %u scans\n", i, moved,
+					       scans_after - scans_before);
+				}
+			}
+
+			clamped += value == INT8_MAX || value == INT8_MIN;
+			read_steps[i] += value;
+			last_total[i] = total;
+			last_scans[i] = scans_after;
+		}
+
+		// Let the movement build up past what one read returns
+		if (++reads % STALL_EVERY == 0) {
+			uint32_t until = scans + STALL_SCANS;
+			while (scans < until && scans < options.scans) {
+			}
+		}
+	}
+
+	stop_interrupts();
+
+	uint32_t lost = 0;
+
+	for (uint8_t i=0;i<ENCODERS;++i) {
+		int8_t value;
+		while ((value = get_encoder_value(i))) {
+			read_steps[i] += value;
+		}
+
+		int32_t made  = direction(i) * (int32_t)scans;
+		int16_t total = (int16_t)(get_encoder_total(i) - start_total[i]);
+
+		// The total wraps at 16 bits, the values read do not
+		if (read_steps[i] != made || total != (int16_t)made) {
+			printf("encoder %u: moved %d steps, read %d, total moved %d\n", i, made,
+			       read_steps[i], total);
+			lost++;
+		}
+	}
+
+	printf("%u scans %u uS apart, %u reads, %u clamped, %u encoders lost steps, %u torn totals\n",
+	       scans, interval_us, reads * ENCODERS, clamped, lost, torn);
+
+	return (lost || torn) ? 1 : 0;
+}
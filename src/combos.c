@@ -0,0 +1,373 @@
+/*
+ * combos.c
+ *
+ * Created: 10/18/2026 3:26:52 PM
+ *
+ *  Multi-switch combos. A small table maps masks of encoder and side 
+ *  switches to actions, each entry is matched with a single mask compare
+ *  against the de-bounced switch state. Once a combo fires the switches
+ *  it is made of are suppressed until released, so their own up and down
+ *  actions are not carried out as well.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <combos.h>
+#include <config.h>
+#include <self_test.h>
+#include <sequencer_display.h>
+#include <scheduler.h>
+
+/**********
+Combos SysEx protocol:
+
+    0xf0 0x0 0x1 0x79 0x6 OP CMD-SPECIFIC 0xf7
+	
+	Switch masks are sent as four 7 bit bytes, least significant first. 
+	Bits 0 - 15 are encoder switches 1 - 16, bits 16 - 21 side switches 1 - 6.
+	
+	OP 0x0 - Read the combo table
+		Request:
+			0xf0 0x0 0x1 0x79 0x6 0x0 0xf7
+		Response, one message per table entry:
+			0xf0 0x0 0x1 0x79 0x6 0x0 INDEX MASK ACTION 0xf7
+			
+	OP 0x1 - Write a combo table entry, the table is saved to EEPROM
+		Request:
+			0xf0 0x0 0x1 0x79 0x6 0x1 INDEX MASK ACTION 0xf7
+				An ACTION of 0 clears the entry. A table left with no entries
+				is taken as lost, the defaults load at the next start up
+				
+	OP 0x2 - Restore the default combo table
+		Request:
+			0xf0 0x0 0x1 0x79 0x6 0x2 0xf7
+
+**********/
+
+#define COMBO_OP_READ    0x00
+#define COMBO_OP_WRITE   0x01
+#define COMBO_OP_RESET   0x02
+
+// Holds the combo table
+static combo_t combo_table[COMBO_MAX];
+
+// Combos which are currently held, bit 0 = combo_table[0]
+static uint8_t combo_active;
+
+// Set when the table has changed and is waiting to be saved
+static bool combos_dirty;
+
+// The combos which were hard coded before the table existed
+static const combo_t default_combos[] = {
+	{0x00120000, COMBO_SEQUENCER},   // Both middle side switches
+	{0x00009009, COMBO_BOOTLOADER},  // Four corner encoders
+	{0x0000F000, COMBO_SELF_TEST},   // Bottom row of encoders
+	{0x0000000F, COMBO_HEALTH_TEST}, // Top row of encoders
+};
+
+static void load_default_combos(void);
+static bool combo_runs_live(uint8_t idx);
+static void sync_combo_active(void);
+static void do_combo_action(uint8_t idx, bool pressed);
+
+/**
+ * Loads the combo table from EEPROM. An erased or invalid page (such as
+ * on the first start after a firmware update) loads the default table, as
+ * does a page of empty entries, which would otherwise take the boot loader
+ * combo away.
+ */
+
+void combos_init(void)
+{
+	uint8_t page_buffer[EEPROM_PAGE_SIZE];
+	
+	nvm_eeprom_read_buffer(COMBO_EE_START_PAGE * EEPROM_PAGE_SIZE, page_buffer, EEPROM_PAGE_SIZE);
+	
+	uint8_t* buffer_ptr = page_buffer;
+	bool any = false;
+	
+	for (uint8_t i=0;i<COMBO_MAX;++i) {
+		uint32_t mask = (uint32_t)buffer_ptr[0] 
+		              | ((uint32_t)buffer_ptr[1] << 8)
+					  | ((uint32_t)buffer_ptr[2] << 16);
+		
+		if (!set_combo(i, mask, buffer_ptr[3])) {
+			any = false;
+			break;
+		}
+		any |= combo_table[i].action != COMBO_NONE;
+		buffer_ptr += COMBO_EE_SIZE;
+	}
+	
+	if (!any) {
+		load_default_combos();
+	}
+	
+	combo_active = 0;
+	combos_dirty = false;
+}
+
+void combos_factory_reset(void)
+{
+	load_default_combos();
+	save_combos();
+}
+
+static void load_default_combos(void)
+{
+	memset(combo_table, 0x00, sizeof(combo_table));
+	
+	for (uint8_t i=0;i<sizeof(default_combos)/sizeof(combo_t);++i) {
+		combo_table[i] = default_combos[i];
+	}
+}
+
+/**
+ * Sets a combo table entry in RAM, save_combos() must be called to keep it.
+ *
+ * \param idx [in]		Table entry to set
+ *
+ * \param mask [in]		Switches in the combo, encoders in bits 0 - 15 and
+ *						side switches in bits 16 - 21
+ *
+ * \param action [in]	combo_action_t to carry out, COMBO_NONE clears the entry
+ *
+ * \return true if the entry was valid and has been set
+ */
+
+bool set_combo(uint8_t idx, uint32_t mask, uint8_t action)
+{
+	if (idx >= COMBO_MAX || action >= COMBO_ACTION_COUNT || (mask & ~COMBO_MASK_VALID)) {
+		return false;
+	}
+	
+	// An empty mask would always match
+	if (mask == 0) {
+		action = COMBO_NONE;
+	}
+	
+	combo_table[idx].mask   = mask;
+	combo_table[idx].action = action;
+	
+	return true;
+}
+
+const combo_t* get_combo(uint8_t idx)
+{
+	return &combo_table[idx % COMBO_MAX];
+}
+
+void save_combos(void)
+{
+	uint8_t page_buffer[EEPROM_PAGE_SIZE];
+	uint8_t* buffer_ptr = page_buffer;
+	
+	memset(page_buffer, 0x00, sizeof(page_buffer));
+	
+	for (uint8_t i=0;i<COMBO_MAX;++i) {
+		*buffer_ptr++ = combo_table[i].mask & 0xFF;
+		*buffer_ptr++ = (combo_table[i].mask >> 8) & 0xFF;
+		*buffer_ptr++ = (combo_table[i].mask >> 16) & 0xFF;
+		*buffer_ptr++ = combo_table[i].action;
+	}
+	
+	cpu_irq_disable();
+	nvm_eeprom_load_page_to_buffer(page_buffer);
+	nvm_eeprom_atomic_write_page(COMBO_EE_START_PAGE);
+	cpu_irq_enable();
+}
+
+/**
+ * Checks for start up combos, these must match the switch state exactly
+ * while the device is powered on.
+ */
+
+void check_boot_combos(void)
+{
+	uint32_t state = ((uint32_t)update_side_switch_state() << COMBO_FIRST_SIDE_SWITCH) 
+					| update_encoder_switch_state();
+	
+	for (uint8_t i=0;i<COMBO_MAX;++i) {
+		if (combo_table[i].action == COMBO_NONE || combo_table[i].mask != state) {
+			continue;
+		}
+		
+		if (combo_table[i].action == COMBO_BOOTLOADER) {
+			Jump_To_Bootloader();
+		} else if (combo_table[i].action == COMBO_SELF_TEST) {
+			// Force factory test
+			eeprom_write(EE_SELF_TEST_FLAG, 0xFF);
+			check_self_test();
+		} else if (combo_table[i].action == COMBO_HEALTH_TEST) {
+			encoder_health_test();
+		}
+	}
+	
+	// Switches held through start up should not fire a combo
+	sync_combo_active();
+}
+
+/**
+ * Start up only combos are left alone once running, they would hide the
+ * release of switches which have already sent their press, such as a row
+ * of note switches held together.
+ */
+
+static bool combo_runs_live(uint8_t idx)
+{
+	return combo_table[idx].action == COMBO_SEQUENCER ||
+	       combo_table[idx].action == COMBO_CC_HOLD;
+}
+
+/**
+ * Marks the combos which match the current switch state as active without 
+ * carrying out their actions, so they only fire once pressed again.
+ */
+
+static void sync_combo_active(void)
+{
+	uint32_t state = ((uint32_t)get_side_switch_state() << COMBO_FIRST_SIDE_SWITCH) 
+					| get_enc_switch_state();
+	uint8_t bit = 0x01;
+	
+	combo_active = 0;
+	
+	for (uint8_t i=0;i<COMBO_MAX;++i) {
+		uint32_t mask = combo_table[i].mask;
+		
+		if ((state & mask) == mask && combo_runs_live(i)) {
+			combo_active |= bit;
+		}
+		bit <<= 1;
+	}
+}
+
+/**
+ * Matches the combo table against the switch state. This must be called 
+ * after the switch states are updated and before any switch actions are 
+ * processed, so that the edges of the combo switches can be suppressed.
+ */
+
+void process_combos(void)
+{
+	uint32_t state = ((uint32_t)get_side_switch_state() << COMBO_FIRST_SIDE_SWITCH) 
+					| get_enc_switch_state();
+	uint8_t bit = 0x01;
+	
+	for (uint8_t i=0;i<COMBO_MAX;++i) {
+		uint32_t mask = combo_table[i].mask;
+		
+		if ((state & mask) == mask && combo_runs_live(i)) {
+			if (!(combo_active & bit)) {
+				combo_active |= bit;
+				suppress_switches(mask & 0xFFFF, mask >> COMBO_FIRST_SIDE_SWITCH);
+				do_combo_action(i, true);
+			}
+		} else if (combo_active & bit) {
+			combo_active &= ~bit;
+			do_combo_action(i, false);
+		}
+		bit <<= 1;
+	}
+}
+
+static void do_combo_action(uint8_t idx, bool pressed)
+{
+	switch (combo_table[idx].action) {
+		case COMBO_SEQUENCER:{
+			if (pressed) {
+				set_op_mode(sequencer);
+				init_seq_display();
+			}
+		} break;
+		case COMBO_CC_HOLD:{
+			midi_stream_raw_cc(midi_system_channel, COMBO_OFFSET + idx, pressed ? 127 : 0);
+		} break;
+		default:
+			// Start up only combos do nothing once running
+		break;
+	}
+}
+
+/**
+ * Saves the combo table if it has been changed over SysEx, run by the main
+ * loop EEPROM task so the slow page write is kept out of the MIDI handler.
+ */
+
+void commit_combos(void)
+{
+	if (combos_dirty) {
+		combos_dirty = false;
+		save_combos();
+	}
+}
+
+static void send_combo(uint8_t idx)
+{
+	uint32_t mask = combo_table[idx].mask;
+	
+	uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+						 SYSEX_COMMAND_COMBOS,
+						 COMBO_OP_READ,
+						 idx,
+						 mask & 0x7F,
+						 (mask >> 7) & 0x7F,
+						 (mask >> 14) & 0x7F,
+						 (mask >> 21) & 0x7F,
+						 combo_table[idx].action,
+						 0xf7};
+	
+	midi_stream_sysex(sizeof(payload), payload);
+	wdt_reset();
+}
+
+void sysExCmdCombos(uint8_t length, uint8_t* buffer)
+{
+	if (length < 2) return;
+	
+	switch (buffer[0]) {
+		case COMBO_OP_READ:{
+			for (uint8_t i=0;i<COMBO_MAX;++i) {
+				send_combo(i);
+			}
+		}
+		break;
+		case COMBO_OP_WRITE:{
+			if (length < 8) return;
+			
+			uint32_t mask = (uint32_t)buffer[2]
+						  | ((uint32_t)buffer[3] << 7)
+						  | ((uint32_t)buffer[4] << 14)
+						  | ((uint32_t)buffer[5] << 21);
+			
+			if (set_combo(buffer[1], mask, buffer[6])) {
+				combos_dirty = true;
+				scheduler_set_ready(TASK_EEPROM);
+				sync_combo_active();
+			}
+		}
+		break;
+		case COMBO_OP_RESET:{
+			load_default_combos();
+			combos_dirty = true;
+			scheduler_set_ready(TASK_EEPROM);
+			sync_combo_active();
+		}
+		break;
+		default:
+		break;
+	}
+}
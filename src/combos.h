@@ -0,0 +1,75 @@
+/*
+ * combos.h
+ *
+ * Created: 10/18/2026 3:26:52 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef COMBOS_H_
+#define COMBOS_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		#include <input.h>
+		
+	/*	Macros: */
+	
+		// Number of entries in the combo table, the whole table fits
+		// in one EEPROM page
+		#define COMBO_MAX                  8
+		#define COMBO_EE_SIZE              4
+		
+		// Combo masks hold the 16 encoder switches followed by the 
+		// 6 side switches
+		#define COMBO_FIRST_SIDE_SWITCH    16
+		#define COMBO_MASK_VALID           0x003FFFFF
+
+	/*	Types: */
+	
+		typedef enum combo_action {
+			COMBO_NONE,			 // Entry is not used
+			COMBO_SEQUENCER,	 // Enter sequencer mode
+			COMBO_BOOTLOADER,	 // Jump to the boot loader, start up only
+			COMBO_SELF_TEST,	 // Run the factory self test, start up only
+			COMBO_CC_HOLD,		 // CC COMBO_OFFSET + index, 127 while held
+			COMBO_HEALTH_TEST,	 // Run the encoder health test, start up only
+			COMBO_ACTION_COUNT,
+		} combo_action_t;
+		
+		// A combo fires when every switch in its mask is closed
+		typedef struct {
+			uint32_t mask;
+			uint8_t  action;
+		} combo_t;
+
+	/* Function Prototypes: */
+	
+		void combos_init(void);
+		void combos_factory_reset(void);
+		
+		bool set_combo(uint8_t idx, uint32_t mask, uint8_t action);
+		const combo_t* get_combo(uint8_t idx);
+		void save_combos(void);
+		void commit_combos(void);
+		
+		void check_boot_combos(void);
+		void process_combos(void);
+		
+		void sysExCmdCombos(uint8_t length, uint8_t* buffer);
+
+#endif /* COMBOS_H_ */
@@ -37,12 +37,20 @@ void global_tv_table_decode(global_tvtable_t* table, uint8_t* buffer, uint8_t si
 {
     uint8_t idx = 0;
     uint8_t tag;
-    while (idx < size - 1) {
+    // Only whole pairs before the closing 0xF7, which must not be taken
+    // as the value of a trailing tag
+    while (idx + 2 < size) {
         tag = buffer[idx++];
+		// Values are 7 bit, anything else is a corrupt message
+		if (buffer[idx] > 0x7F) {
+			++idx;
+			continue;
+		}
 		// Hack to avoid messy utility changes
         if (tag < GLOBAL_TAG_LOW_UPPER) {
             table->bytes[tag] = buffer[idx];
-        } else if (tag > GLOBAL_TAG_HIGH_LOWER){
+        } else if (tag > GLOBAL_TAG_HIGH_LOWER &&
+		           tag - ENCODER_RESV_RANGE - 1 < GLOBAL_TABLE_SIZE){
 			table->bytes[tag-ENCODER_RESV_RANGE - 1] = buffer[idx];
 		}
         ++idx;
@@ -72,6 +80,18 @@ void sysExCmdPushConfig (uint8_t length, uint8_t* buffer)
 	eeprom_write(EE_SUPER_KNOB_END, config.superEnd);	
 	eeprom_write(EE_RGB_BRIGHTNESS, config.rgb_brightness);
 	eeprom_write(EE_IND_BRIGHTNESS, config.ind_brightness);
+	eeprom_write(EE_GESTURE_DOUBLE_TAP, config.gestureDoubleTap);
+	eeprom_write(EE_GESTURE_LONG_PRESS, config.gestureLongPress);
+	eeprom_write(EE_GESTURE_TURN_STEPS, config.gestureTurnSteps);
+	eeprom_write(EE_GESTURE_MIDI, config.gestureMidi);
+	eeprom_write(EE_FINE_ADJUST_SHIFT, config.fineShift);
+	eeprom_write(EE_SIDE_REPEAT_DELAY, config.sideRepeatDelay);
+	eeprom_write(EE_SIDE_REPEAT_RATE, config.sideRepeatRate);
+	eeprom_write(EE_GESTURE_CHANNEL, config.gestureChannel - 1);
+	
+	for (uint8_t i=0;i<sizeof(config.gestureMap);++i) {
+		eeprom_write(EE_GESTURE_MAP + i, config.gestureMap[i]);
+	}
 
 	setting_confirmation_animation(0x00FF00);
 		
@@ -93,6 +113,7 @@ void send_config_data (void)
 	cpu_irq_disable();
 	
 	side_sw_settings_t* side_cfg = get_side_switch_config();
+	gesture_settings_t* gesture_cfg = get_gesture_config();
 	
 	cpu_irq_enable();
 	
@@ -111,6 +132,22 @@ void send_config_data (void)
 								9 , global_super_knob_end,
 								31, global_rgb_brightness,
 								32, global_ind_brightness,
+								33, gesture_cfg->double_tap_time,
+								34, gesture_cfg->long_press_time,
+								35, gesture_cfg->turn_steps,
+								36, gesture_cfg->send_midi,
+								37, get_fine_adjust_shift(),
+								38, side_cfg->repeat_delay,
+								39, side_cfg->repeat_rate,
+								40, gesture_cfg->channel + 1,
+								41, gesture_cfg->action[GESTURE_TAP],
+								42, gesture_cfg->number[GESTURE_TAP],
+								43, gesture_cfg->action[GESTURE_DOUBLE_TAP],
+								44, gesture_cfg->number[GESTURE_DOUBLE_TAP],
+								45, gesture_cfg->action[GESTURE_LONG_PRESS],
+								46, gesture_cfg->number[GESTURE_LONG_PRESS],
+								47, gesture_cfg->action[GESTURE_HOLD_TURN],
+								48, gesture_cfg->number[GESTURE_HOLD_TURN],
                                 0xf7};
 								
     midi_stream_sysex(sizeof(payload), payload);
@@ -159,10 +196,7 @@ void sysExCmdSystem (uint8_t length, uint8_t* buffer)
 			_delay_ms(2000);
 			
 			// Force a Reset
-			wdt_set_timeout_period(WDT_TIMEOUT_PERIOD_16CLK);
-			wdt_enable();
-			
-			while(true){};
+			watchdog_force_reset();
         }
         break;
     default:
@@ -200,6 +234,8 @@ This implementation is hard coded to support only a subset of the protocol:
 
 		0x1   Bank 1 Encoder 1 Configuration Data
 		0x2   Bank 1 Encoder 2 Configuration Data .. and so on 
+		0x41  Shift Page 1 Encoder 1 Configuration Data, after the 4 banks
+		0x51  Shift Page 2 Encoder 1 Configuration Data .. up to 0x60
 		
 NOTE: Binary data must either avoid setting the MSB, or encode octets as packed septets, as MIDI will interpret octets with the MSB set as special SysEx commands.
 
@@ -215,6 +251,7 @@ void sysExCmdBulkXfer(uint8_t length, uint8_t* buffer) // Process/ParseSysexMess
         if (command == 0) { // PUSH (Change/Update Settings)
             if (length > 5) {
                 if (sysex_tag == 0x0) return; // Extended tags not supported
+                if (sysex_tag > (NUM_LAYERS*16)) return; // Banks then shift pages
                 uint8_t part = *buffer++; // Transfers may consist of multiple parts
                 if (part == 0) return; // Invalid part number
                 uint8_t total = *buffer++;
@@ -260,7 +297,7 @@ void sysExCmdBulkXfer(uint8_t length, uint8_t* buffer) // Process/ParseSysexMess
 			uint8_t encoder = 0;
 			
 			// If the sysex tag is invalid reply with an empty message
-			if (sysex_tag > 0 || sysex_tag <= ((NUM_BANKS*16))) {
+			if (sysex_tag > 0 && sysex_tag <= ((NUM_LAYERS*16))) {
 				bank = (sysex_tag-1) / 16;
 				encoder = (sysex_tag-1) % 16;
 			}
@@ -294,7 +331,7 @@ void sysExCmdBulkXfer(uint8_t length, uint8_t* buffer) // Process/ParseSysexMess
 			uint8_t bytes_remaining = sizeof(config_data);
 			//uint8_t cfg_total = bytes_remaining/2;
 			// If the syex_tag was out of scope reply with no data
-			if (sysex_tag < 1 || sysex_tag > (NUM_BANKS*16)) {bytes_remaining = 0;}
+			if (sysex_tag < 1 || sysex_tag > (NUM_LAYERS*16)) {bytes_remaining = 0;}
 			// Total number of parts in transfer
 			uint8_t total = (bytes_remaining / 24)+1;
 			uint8_t index=0;
@@ -322,7 +359,6 @@ void sysExCmdBulkXfer(uint8_t length, uint8_t* buffer) // Process/ParseSysexMess
                 
 				// Send the message
 				midi_stream_sysex(11 + size, payload);
-				MIDI_Device_Flush(g_midi_interface_info);
 				// Reset the watchdog timer to avoid a reset while processing the sysex.
 				wdt_reset();
 			}
@@ -338,6 +374,10 @@ void config_init(void)
     sysex_install(SYSEX_COMMAND_PULL_CONF, sysExCmdPullConfig);
     sysex_install(SYSEX_COMMAND_SYSTEM,    sysExCmdSystem);
     sysex_install(SYSEX_COMMAND_BULK_XFER, sysExCmdBulkXfer);
+    sysex_install(SYSEX_COMMAND_DIAGNOSTICS, sysExCmdDiagnostics);
+    sysex_install(SYSEX_COMMAND_COMBOS,    sysExCmdCombos);
+    sysex_install(SYSEX_COMMAND_SIDE_LAYERS, sysExCmdSideLayers);
+    sysex_install(SYSEX_COMMAND_MACROS,    sysExCmdMacros);
 	
 	// If our EEPROM layout has changed, reset everything.
 	if (eeprom_read(EE_EEPROM_VERSION) != EEPROM_LAYOUT) {
@@ -352,6 +392,12 @@ void load_config(void)
 	// Load system settings
 	midi_system_channel = eeprom_read(EE_MIDI_CHANNEL);
 	
+	// A setting whose write was cut short by a power loss reads back
+	// erased, out of range values fall back to the default
+	if (midi_system_channel > 0x0F) {
+		midi_system_channel = DEF_MIDI_CHANNEL;
+	}
+	
 	// Load side button settings
 	side_sw_settings_t side_sw_cfg;
 	
@@ -363,13 +409,104 @@ void load_config(void)
 	side_sw_cfg.sw_action[4]   = eeprom_read(EE_SIDE_SW_5_FUNC);
 	side_sw_cfg.sw_action[5]   = eeprom_read(EE_SIDE_SW_6_FUNC);
 	
+	const side_sw_action_t side_sw_defaults[6] = {DEF_SIDE_SW_1_FUNC, DEF_SIDE_SW_2_FUNC, DEF_SIDE_SW_3_FUNC,
+	                                              DEF_SIDE_SW_4_FUNC, DEF_SIDE_SW_5_FUNC, DEF_SIDE_SW_6_FUNC};
+	
+	for (uint8_t i=0;i<6;++i) {
+		if (side_sw_cfg.sw_action[i] >= SIDE_SW_ACTION_COUNT) {
+			side_sw_cfg.sw_action[i] = side_sw_defaults[i];
+		}
+	}
+	
+	// Auto-repeat was added without a layout change, out of range values
+	// fall back to the default
+	side_sw_cfg.repeat_delay   = eeprom_read(EE_SIDE_REPEAT_DELAY);
+	side_sw_cfg.repeat_rate    = eeprom_read(EE_SIDE_REPEAT_RATE);
+	
+	if (side_sw_cfg.repeat_delay == 0 || side_sw_cfg.repeat_delay > 0x7F) {
+		side_sw_cfg.repeat_delay = DEF_SIDE_REPEAT_DELAY;
+	}
+	if (side_sw_cfg.repeat_rate == 0 || side_sw_cfg.repeat_rate > 0x7F) {
+		side_sw_cfg.repeat_rate = DEF_SIDE_REPEAT_RATE;
+	}
+	
 	global_super_knob_start	   = eeprom_read(EE_SUPER_KNOB_START);
 	global_super_knob_end      = eeprom_read(EE_SUPER_KNOB_END);
 	global_rgb_brightness      = eeprom_read(EE_RGB_BRIGHTNESS);
 	global_ind_brightness      = eeprom_read(EE_IND_BRIGHTNESS);
 	
+	if (global_super_knob_start > 0x7F) {
+		global_super_knob_start = DEF_SUPER_START_VALUE;
+	}
+	if (global_super_knob_end > 0x7F) {
+		global_super_knob_end = DEF_SUPER_END_VALUE;
+	}
+	
+	// The brightness settings index the 128 entry brightness map
+	if (global_rgb_brightness > 0x7F) {
+		global_rgb_brightness = DEF_RGB_BRIGHTNESS;
+	}
+	if (global_ind_brightness > 0x7F) {
+		global_ind_brightness = DEF_IND_BRIGHTNESS;
+	}
+	
 	side_switch_config(&side_sw_cfg);
 	
+	// Load gesture settings, these were added without an EEPROM layout
+	// change and may be pushed as 0 by older utilities so anything out
+	// of range falls back to the default
+	gesture_settings_t gesture_cfg;
+	
+	gesture_cfg.double_tap_time = eeprom_read(EE_GESTURE_DOUBLE_TAP);
+	gesture_cfg.long_press_time = eeprom_read(EE_GESTURE_LONG_PRESS);
+	gesture_cfg.turn_steps      = eeprom_read(EE_GESTURE_TURN_STEPS);
+	gesture_cfg.send_midi       = eeprom_read(EE_GESTURE_MIDI) == 1;
+	
+	if (gesture_cfg.double_tap_time == 0 || gesture_cfg.double_tap_time > 0x7F) {
+		gesture_cfg.double_tap_time = DEF_GESTURE_DOUBLE_TAP;
+	}
+	if (gesture_cfg.long_press_time == 0 || gesture_cfg.long_press_time > 0x7F) {
+		gesture_cfg.long_press_time = DEF_GESTURE_LONG_PRESS;
+	}
+	if (gesture_cfg.turn_steps == 0 || gesture_cfg.turn_steps > 0x7F) {
+		gesture_cfg.turn_steps = DEF_GESTURE_TURN_STEPS;
+	}
+	
+	gesture_cfg.channel = eeprom_read(EE_GESTURE_CHANNEL);
+	
+	if (gesture_cfg.channel > 0x0F) {
+		gesture_cfg.channel = DEF_GESTURE_CHANNEL;
+	}
+	
+	// Each gesture from tap on has an action and a number
+	gesture_cfg.action[GESTURE_NONE] = GESTURE_ACTION_NONE;
+	gesture_cfg.number[GESTURE_NONE] = 0;
+	
+	for (uint8_t i=GESTURE_TAP;i<GESTURE_COUNT;++i) {
+		uint16_t address = EE_GESTURE_MAP + 2 * (i - GESTURE_TAP);
+		
+		gesture_cfg.action[i] = eeprom_read(address);
+		gesture_cfg.number[i] = eeprom_read(address + 1);
+		
+		if (gesture_cfg.action[i] >= GESTURE_ACTION_COUNT) {
+			gesture_cfg.action[i] = DEF_GESTURE_ACTION;
+		}
+		if (gesture_cfg.number[i] > 0x7F) {
+			gesture_cfg.number[i] = DEF_GESTURE_NUMBER;
+		}
+	}
+	
+	gesture_config(&gesture_cfg);
+	
+	// Load the fine adjust setting, also added without a layout change
+	uint8_t fine_shift = eeprom_read(EE_FINE_ADJUST_SHIFT);
+	
+	if (fine_shift == 0 || fine_shift > FINE_ADJUST_SHIFT_MAX) {
+		fine_shift = DEF_FINE_ADJUST_SHIFT;
+	}
+	
+	set_fine_adjust_shift(fine_shift);
+	
 	cpu_irq_enable();
 }
 
@@ -399,8 +536,39 @@ void config_factory_reset(void)
 	eeprom_write(EE_RGB_BRIGHTNESS, DEF_RGB_BRIGHTNESS);
 	eeprom_write(EE_IND_BRIGHTNESS, DEF_IND_BRIGHTNESS);
 	
+	// Gesture Settings
+	
+	eeprom_write(EE_GESTURE_DOUBLE_TAP, DEF_GESTURE_DOUBLE_TAP);
+	eeprom_write(EE_GESTURE_LONG_PRESS, DEF_GESTURE_LONG_PRESS);
+	eeprom_write(EE_GESTURE_TURN_STEPS, DEF_GESTURE_TURN_STEPS);
+	eeprom_write(EE_GESTURE_MIDI, DEF_GESTURE_MIDI);
+	eeprom_write(EE_GESTURE_CHANNEL, DEF_GESTURE_CHANNEL);
+	
+	for (uint8_t i=0;i<8;i+=2) {
+		eeprom_write(EE_GESTURE_MAP + i, DEF_GESTURE_ACTION);
+		eeprom_write(EE_GESTURE_MAP + i + 1, DEF_GESTURE_NUMBER);
+	}
+	
+	// Fine Adjust Settings
+	
+	eeprom_write(EE_FINE_ADJUST_SHIFT, DEF_FINE_ADJUST_SHIFT);
+	
+	// Side Switch Auto-Repeat Settings
+	
+	eeprom_write(EE_SIDE_REPEAT_DELAY, DEF_SIDE_REPEAT_DELAY);
+	eeprom_write(EE_SIDE_REPEAT_RATE, DEF_SIDE_REPEAT_RATE);
+	
 	cpu_irq_enable();
 	
+	// Combo Settings
+	combos_factory_reset();
+	
+	// Side Switch Layers
+	side_switch_layers_factory_reset();
+	
+	// Macros
+	macros_factory_reset();
+	
 	// Encoder Settings
 	factory_reset_encoder_config();
 }
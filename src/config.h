@@ -34,6 +34,11 @@
 		// Include all objects which require config
 		#include "side_switch.h"
 		#include "encoders.h"
+		#include "gestures.h"
+		#include "diagnostics.h"
+		#include "combos.h"
+		#include "macros.h"
+		#include "watchdog.h"
 	
 	/*	Macros: */
 	
@@ -43,10 +48,14 @@
 		#define SYSEX_COMMAND_PULL_CONF    0x2
 		#define SYSEX_COMMAND_SYSTEM       0x3
 		#define SYSEX_COMMAND_BULK_XFER    0x4
+		#define SYSEX_COMMAND_DIAGNOSTICS  0x5
+		#define SYSEX_COMMAND_COMBOS       0x6
+		#define SYSEX_COMMAND_SIDE_LAYERS  0x7
+		#define SYSEX_COMMAND_MACROS       0x8
 		
 	/* Typedefs: */
 		
-		#define GLOBAL_TABLE_SIZE 12
+		#define GLOBAL_TABLE_SIZE 28
 		// The global table holds the Twister global settings
 		typedef union {
 			struct {
@@ -63,6 +72,15 @@
 				uint8_t superEnd;
 				uint8_t rgb_brightness;
 				uint8_t ind_brightness;
+				uint8_t gestureDoubleTap;
+				uint8_t gestureLongPress;
+				uint8_t gestureTurnSteps;
+				uint8_t gestureMidi;
+				uint8_t fineShift;
+				uint8_t sideRepeatDelay;
+				uint8_t sideRepeatRate;
+				uint8_t gestureChannel;		// 1 - 16, 0 when not sent
+				uint8_t gestureMap[8];		// Action and number, tap to hold and turn
 			};
 			uint8_t bytes[GLOBAL_TABLE_SIZE];
 		} global_tvtable_t;	
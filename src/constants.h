@@ -67,6 +67,8 @@
 //#define DEF_MIDI_CHANNEL		3 // TWISTER DEFAULT SETTINGS Channel for changing banks
 //#define ENCODER_SHIFTED_CHANNEL 4 // Defined elsewhere
 #define SWITCH_ANIMATION_CHANNEL  5
+#define GESTURE_CHANNEL           6
+#define COMBO_OFFSET             32
 
 // Debug & Test Harness Definitions ---------------------------------------
 
@@ -101,6 +103,15 @@
 #define EE_SUPER_KNOB_END			0x000B  //Super Knob Secondary CC start point
 #define EE_RGB_BRIGHTNESS			0x000C  //Global brightness setting for RGB
 #define EE_IND_BRIGHTNESS           0x000D  //Gobal brightness setting for indicators
+#define EE_GESTURE_DOUBLE_TAP		0x000E  //Gesture double tap time
+#define EE_GESTURE_LONG_PRESS		0x000F  //Gesture long press time
+#define EE_GESTURE_TURN_STEPS		0x0010  //Gesture hold and turn steps
+#define EE_GESTURE_MIDI				0x0011  //Gesture MIDI output enable
+#define EE_FINE_ADJUST_SHIFT		0x0012  //Fine adjust step reduction
+#define EE_SIDE_REPEAT_DELAY		0x0013  //Side switch auto-repeat delay
+#define EE_SIDE_REPEAT_RATE			0x0014  //Side switch auto-repeat rate
+#define EE_GESTURE_CHANNEL			0x0015  //Gesture MIDI channel
+#define EE_GESTURE_MAP				0x0016  //Gesture action and number, tap to hold and turn (8 bytes)
 
 #define EE_ENC_SETTING_START		0x0020  //Start of encoder settings
 #define EE_HAS_DETENT_OFFSET		0x0000  //Has Detent setting offset			    //
@@ -118,9 +129,15 @@
 #define EE_INACTIVE_COLOR_OFFSET	0x0003  //Inactive Color offset
 
 #define ENC_EE_SIZE 8
+#define SHIFT_EE_UNSAVED 0x0C	//Unused bits of the 7th byte, set while a shift page encoder is erased
 
 #define DEV_SETTINGS_START_PAGE      0
 #define ENC_SETTINGS_START_PAGE		 1
+#define COMBO_EE_START_PAGE		17
+#define SIDE_LAYER_EE_START_PAGE	18	//Two banks per page
+#define MACRO_EE_START_PAGE		20	//One page per macro
+#define SHIFT_LAYER_EE_START_PAGE	24	//Encoder settings for the shift pages
+#define SHIFT_LAYER_EE_LAST_PAGE	63	//The last row of shift page 2, after the sequencer
 #define SEQ_EEPROM_START_PAGE		31
 
 // Defaults -------------------------------------------------------------------
@@ -141,6 +158,22 @@
 #define DEF_RGB_BRIGHTNESS	    127
 #define DEF_IND_BRIGHTNESS	    127
 
+// Gestures
+#define DEF_GESTURE_DOUBLE_TAP  25		// x 10 mS
+#define DEF_GESTURE_LONG_PRESS  50		// x 10 mS
+#define DEF_GESTURE_TURN_STEPS   2
+#define DEF_GESTURE_MIDI	    false
+#define DEF_GESTURE_CHANNEL     GESTURE_CHANNEL
+#define DEF_GESTURE_ACTION      GESTURE_ACTION_DEFAULT
+#define DEF_GESTURE_NUMBER      0
+
+// Fine Adjust
+#define DEF_FINE_ADJUST_SHIFT    2		// 1/4 step
+
+// Side Switch Auto-Repeat
+#define DEF_SIDE_REPEAT_DELAY   50		// x 10 mS
+#define DEF_SIDE_REPEAT_RATE    15		// x 10 mS
+
 //Encoder
 #define DEF_ENC_DETENT          false
 #define DEF_ENC_MOVEMENT        DIRECT
@@ -174,6 +207,10 @@
 //~ #define DEF_ACTIVE_COLOR_BANK4		88
 //~ #define DEF_INACTIVE_COLOR_BANK4      0
 
+// Shift Pages
+#define DEF_SHIFT_ACTIVE_COLOR		DEF_ACTIVE_COLOR
+#define DEF_SHIFT_INACTIVE_COLOR	0
+
 #define DEF_DETENT_COLOR        63
 #define DEF_INDICATOR_TYPE      BLENDED_BAR
 #define DEF_IS_SUPER_KNOB       false
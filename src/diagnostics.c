@@ -0,0 +1,375 @@
+/*
+ * diagnostics.c
+ *
+ * Created: 10/18/2026 2:40:07 PM
+ *
+ *  Handles the diagnostics SysEx command which lets a host read back 
+ *  internal state that is otherwise only visible on a debugger.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <diagnostics.h>
+#include <config.h>
+
+/**********
+Diagnostics SysEx protocol:
+
+    0xf0 0x0 0x1 0x79 0x5 SUB CMD-SPECIFIC 0xf7
+	
+	All 16 bit values are sent as three 7 bit bytes, least significant first.
+	
+	SUB 0x1 - Raw input capture
+		Request:
+			0xf0 0x0 0x1 0x79 0x5 0x1 OP 0xf7
+				OP:		0 Dump, 1 Clear
+		Dump response, one message per sample oldest first:
+			0xf0 0x0 0x1 0x79 0x5 0x1 0x0 INDEX TOTAL TICKS ENC_SW CHA CHB SIDE_SW 0xf7
+				INDEX:  Sample number (0 based)
+				TOTAL:  Number of samples held, when 0 no sample data follows
+				TICKS:	32 uS timer ticks since the previous sample (16 bit)
+				ENC_SW:	Encoder switches, set if closed (16 bit)
+				CHA:	Encoder channel A levels (16 bit)
+				CHB:	Encoder channel B levels (16 bit)
+				SIDE_SW:Side switches, set if closed
+				
+		Capturing is paused while the dump is sent.
+		
+	SUB 0x2 - Encoder health
+		Request:
+			0xf0 0x0 0x1 0x79 0x5 0x2 OP 0xf7
+				OP:		0 Dump, 1 Clear
+		Dump response, one message per encoder:
+			0xf0 0x0 0x1 0x79 0x5 0x2 0x0 ENCODER EDGES_A EDGES_B ILLEGAL REVERSALS AGE_A AGE_B 0xf7
+				ENCODER:	Encoder number (0 based)
+				EDGES_A:	Edges seen on channel A (16 bit)
+				EDGES_B:	Edges seen on channel B (16 bit)
+				ILLEGAL:	Scans where both channels changed at once (16 bit)
+				REVERSALS:	Direction changes within ENCODER_REVERSAL_MS (16 bit)
+				AGE_A:		mS since the last channel A edge, saturates (16 bit)
+				AGE_B:		mS since the last channel B edge, saturates (16 bit)
+		
+		Counters saturate at 0xFFFF and are zeroed by Clear.
+		
+	SUB 0x3 - Profiler
+		Request:
+			0xf0 0x0 0x1 0x79 0x5 0x3 OP 0xf7
+				OP:		0 Dump, 1 Clear
+		Dump response, one message per profile point:
+			0xf0 0x0 0x1 0x79 0x5 0x3 0x0 POINT COUNT MAX HIST0 .. HIST15 0xf7
+				POINT:	0 Main loop pass, 1-5 Scheduler tasks in priority 
+						order, 6 encoder_scan(), 7 display_frame_timer(), 
+						8 do_task(), 9 process_encoder_input(), 
+						10 process_midi_packet(), 11 process_element_midi()
+				COUNT:	Samples recorded (16 bit)
+				MAX:	Longest duration in 2 uS ticks, or in CPU cycles when 
+						built with PROFILE_CLOCK_DIV 1 (16 bit)
+				HISTn:	Samples from 2^(n-1) up to 2^n ticks, HIST0 holds 
+						those under one tick and HIST15 everything from 
+						2^14 ticks (16 bit each)
+		
+		Counts saturate at 0xFFFF and are zeroed by Clear. When the firmware
+		is built without ENABLE_PROFILER every value reads 0.
+		
+	SUB 0x4 - CPU load
+		Request:
+			0xf0 0x0 0x1 0x79 0x5 0x4 OP 0xf7
+				OP:		0 Read
+		Response:
+			0xf0 0x0 0x1 0x79 0x5 0x4 0x0 IDLE ISR_LOAD 0xf7
+				IDLE:		Percentage of the last second the main loop spent 
+							asleep waiting for work
+				ISR_LOAD:	Share of CPU time spent in encoder_scan(), per mille 
+							(16 bit)
+		
+	SUB 0x5 - Last reset
+		Request:
+			0xf0 0x0 0x1 0x79 0x5 0x5 OP 0xf7
+				OP:		0 Read
+		Response:
+			0xf0 0x0 0x1 0x79 0x5 0x5 0x0 CAUSE REQUESTED HEARTBEATS WDT_RESETS UPTIME 0xf7
+				CAUSE:		XMEGA RST.STATUS flags of the last reset, 0x1 power on, 
+							0x2 external, 0x4 brown out, 0x8 watchdog, 0x10 debugger,
+							0x20 software, 0x40 spike
+				REQUESTED:	1 if the firmware forced the reset itself
+				HEARTBEATS:	Heartbeats seen after the watchdog was last fed, a 
+							missing bit shows the subsystem which stalled. 0x1 input
+							scan, 0x2 display frames, 0x4 USB frames, 0x8 main loop
+				WDT_RESETS:	Unrequested watchdog resets since power on (16 bit)
+				UPTIME:		mS from start up until the watchdog was last fed 
+							(32 bit as five 7 bit bytes, least significant first)
+				
+		After a power on reset the record is all zero.
+		
+	SUB 0x6 - USB MIDI rings
+		Request:
+			0xf0 0x0 0x1 0x79 0x5 0x6 OP 0xf7
+				OP:		0 Read
+		Response:
+			0xf0 0x0 0x1 0x79 0x5 0x6 0x0 RX TX DROPPED RX_MAX TX_MAX FRAME 0xf7
+				RX:			Packets received from the host (16 bit)
+				TX:			Packets sent to the host (16 bit)
+				DROPPED:	Packets dropped on a full transmit ring (16 bit)
+				RX_MAX:		Highest receive ring fill level, in packets
+				TX_MAX:		Highest transmit ring fill level, in packets
+				FRAME:		USB frames since the device was configured, one per 
+							mS, wraps at 0xFFFF (16 bit)
+				
+		Counts saturate at 0xFFFF and restart each time the host configures
+		the device.
+
+**********/
+
+static uint8_t* pack_u16(uint8_t* dst, uint16_t value)
+{
+	*dst++ = value & 0x7F;
+	*dst++ = (value >> 7) & 0x7F;
+	*dst++ = (value >> 14) & 0x03;
+	return dst;
+}
+
+static uint8_t* pack_u32(uint8_t* dst, uint32_t value)
+{
+	for (uint8_t i=0;i<5;++i) {
+		*dst++ = value & 0x7F;
+		value >>= 7;
+	}
+	return dst;
+}
+
+static void send_input_capture(void)
+{
+	enable_input_capture(false);
+	
+	uint8_t total = get_input_capture_count();
+	uint8_t idx = 0;
+	
+	do {
+		uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+							 SYSEX_COMMAND_DIAGNOSTICS,
+							 DIAG_INPUT_CAPTURE,
+							 DIAG_CAPTURE_DUMP,
+							 idx,
+							 total,
+							 0,0,0, 0,0,0, 0,0,0, 0,0,0, 0,
+							 0xf7};
+		uint8_t length = 10; // Header and terminator only
+		
+		input_sample_t sample;
+		if (get_input_capture_sample(idx, &sample)) {
+			uint8_t* ptr = &payload[9];
+			ptr = pack_u16(ptr, sample.ticks);
+			ptr = pack_u16(ptr, sample.enc_switch);
+			ptr = pack_u16(ptr, sample.cha);
+			ptr = pack_u16(ptr, sample.chb);
+			*ptr++ = sample.side_switch & 0x7F;
+			*ptr = 0xf7;
+			length = sizeof(payload);
+		} else {
+			payload[9] = 0xf7;
+		}
+		
+		midi_stream_sysex(length, payload);
+		// Reset the watchdog timer to avoid a reset while sending the dump.
+		wdt_reset();
+		
+	} while (++idx < total);
+	
+	enable_input_capture(true);
+}
+
+static uint16_t edge_age(uint32_t now, uint32_t last_edge)
+{
+	uint32_t age = now - last_edge;
+	return age > 0xFFFF ? 0xFFFF : (uint16_t)age;
+}
+
+static void send_encoder_health(void)
+{
+	uint32_t now = get_ms_timer();
+	
+	for (uint8_t i=0;i<16;++i) {
+		encoder_health_t health;
+		get_encoder_health(i, &health);
+		
+		uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+							 SYSEX_COMMAND_DIAGNOSTICS,
+							 DIAG_ENCODER_HEALTH,
+							 DIAG_HEALTH_DUMP,
+							 i,
+							 0,0,0, 0,0,0, 0,0,0, 0,0,0, 0,0,0, 0,0,0,
+							 0xf7};
+		
+		uint8_t* ptr = &payload[8];
+		ptr = pack_u16(ptr, health.edges_a);
+		ptr = pack_u16(ptr, health.edges_b);
+		ptr = pack_u16(ptr, health.illegal);
+		ptr = pack_u16(ptr, health.reversals);
+		ptr = pack_u16(ptr, edge_age(now, health.last_edge_a));
+		pack_u16(ptr, edge_age(now, health.last_edge_b));
+		
+		midi_stream_sysex(sizeof(payload), payload);
+		wdt_reset();
+	}
+}
+
+static void send_profile(void)
+{
+	for (uint8_t i=0;i<PROFILE_POINT_COUNT;++i) {
+		profile_stats_t stats;
+		get_profile_stats(i, &stats);
+		
+		uint8_t payload[9 + 3*(2 + PROFILE_BUCKETS)] = {
+							 0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+							 SYSEX_COMMAND_DIAGNOSTICS,
+							 DIAG_PROFILER,
+							 DIAG_PROFILER_DUMP,
+							 i};
+		
+		uint8_t* ptr = &payload[8];
+		ptr = pack_u16(ptr, stats.count);
+		ptr = pack_u16(ptr, stats.max);
+		for (uint8_t b=0;b<PROFILE_BUCKETS;++b) {
+			ptr = pack_u16(ptr, stats.hist[b]);
+		}
+		*ptr = 0xf7;
+		
+		midi_stream_sysex(sizeof(payload), payload);
+		wdt_reset();
+	}
+}
+
+static void send_load(void)
+{
+	// The scan updates the load from its interrupt
+	irqflags_t flags = cpu_irq_save();
+	uint16_t isr_load = get_input_diagnostics()->isr_load;
+	cpu_irq_restore(flags);
+	
+	uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+						 SYSEX_COMMAND_DIAGNOSTICS,
+						 DIAG_LOAD,
+						 DIAG_LOAD_READ,
+						 scheduler_get_idle_percent(),
+						 0,0,0,
+						 0xf7};
+	
+	pack_u16(&payload[8], isr_load);
+	
+	midi_stream_sysex(sizeof(payload), payload);
+	wdt_reset();
+}
+
+static void send_last_reset(void)
+{
+	reset_record_t rec;
+	get_last_reset_record(&rec);
+	
+	uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+						 SYSEX_COMMAND_DIAGNOSTICS,
+						 DIAG_RESET,
+						 DIAG_RESET_READ,
+						 get_last_reset_cause() & 0x7F,
+						 rec.requested ? 1 : 0,
+						 rec.heartbeats & 0x7F,
+						 0,0,0, 0,0,0,0,0,
+						 0xf7};
+	
+	uint8_t* ptr = &payload[10];
+	ptr = pack_u16(ptr, get_watchdog_reset_count());
+	pack_u32(ptr, rec.uptime_ms);
+	
+	midi_stream_sysex(sizeof(payload), payload);
+	wdt_reset();
+}
+
+static void send_usb_midi(void)
+{
+	usb_midi_stats_t stats;
+	get_usb_midi_stats(&stats);
+	
+	uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+						 SYSEX_COMMAND_DIAGNOSTICS,
+						 DIAG_USB_MIDI,
+						 DIAG_USB_MIDI_READ,
+						 0,0,0, 0,0,0, 0,0,0,
+						 0, 0,
+						 0,0,0,
+						 0xf7};
+	
+	uint8_t* ptr = &payload[7];
+	ptr = pack_u16(ptr, stats.rx_packets);
+	ptr = pack_u16(ptr, stats.tx_packets);
+	ptr = pack_u16(ptr, stats.tx_dropped);
+	*ptr++ = stats.rx_max_used & 0x7F;
+	*ptr++ = stats.tx_max_used & 0x7F;
+	pack_u16(ptr, get_usb_frame_count());
+	
+	midi_stream_sysex(sizeof(payload), payload);
+	wdt_reset();
+}
+
+void sysExCmdDiagnostics(uint8_t length, uint8_t* buffer)
+{
+	if (length < 2) return;
+	
+	switch (buffer[0]) {
+		case DIAG_INPUT_CAPTURE:{
+			if (buffer[1] == DIAG_CAPTURE_DUMP) {
+				send_input_capture();
+			} else if (buffer[1] == DIAG_CAPTURE_CLEAR) {
+				clear_input_capture();
+			}
+		}
+		break;
+		case DIAG_ENCODER_HEALTH:{
+			if (buffer[1] == DIAG_HEALTH_DUMP) {
+				send_encoder_health();
+			} else if (buffer[1] == DIAG_HEALTH_CLEAR) {
+				clear_encoder_health();
+			}
+		}
+		break;
+		case DIAG_PROFILER:{
+			if (buffer[1] == DIAG_PROFILER_DUMP) {
+				send_profile();
+			} else if (buffer[1] == DIAG_PROFILER_CLEAR) {
+				clear_profile_stats();
+			}
+		}
+		break;
+		case DIAG_LOAD:{
+			if (buffer[1] == DIAG_LOAD_READ) {
+				send_load();
+			}
+		}
+		break;
+		case DIAG_RESET:{
+			if (buffer[1] == DIAG_RESET_READ) {
+				send_last_reset();
+			}
+		}
+		break;
+		case DIAG_USB_MIDI:{
+			if (buffer[1] == DIAG_USB_MIDI_READ) {
+				send_usb_midi();
+			}
+		}
+		break;
+		default:
+		break;
+	}
+}
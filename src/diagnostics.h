@@ -0,0 +1,70 @@
+/*
+ * diagnostics.h
+ *
+ * Created: 10/18/2026 2:40:07 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef DIAGNOSTICS_H_
+#define DIAGNOSTICS_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		#include <input.h>
+		#include <profiler.h>
+		#include <scheduler.h>
+		#include <watchdog.h>
+		#include <usb_midi.h>
+		
+	/*	Macros: */
+	
+		// Diagnostics SysEx sub commands, the byte following
+		// SYSEX_COMMAND_DIAGNOSTICS
+		#define DIAG_INPUT_CAPTURE		0x01
+		#define DIAG_ENCODER_HEALTH		0x02
+		#define DIAG_PROFILER			0x03
+		#define DIAG_LOAD				0x04
+		#define DIAG_RESET				0x05
+		#define DIAG_USB_MIDI			0x06
+		
+		// DIAG_INPUT_CAPTURE operations
+		#define DIAG_CAPTURE_DUMP		0x00
+		#define DIAG_CAPTURE_CLEAR		0x01
+		
+		// DIAG_ENCODER_HEALTH operations
+		#define DIAG_HEALTH_DUMP		0x00
+		#define DIAG_HEALTH_CLEAR		0x01
+		
+		// DIAG_PROFILER operations
+		#define DIAG_PROFILER_DUMP		0x00
+		#define DIAG_PROFILER_CLEAR		0x01
+		
+		// DIAG_LOAD operations
+		#define DIAG_LOAD_READ			0x00
+		
+		// DIAG_RESET operations
+		#define DIAG_RESET_READ			0x00
+		
+		// DIAG_USB_MIDI operations
+		#define DIAG_USB_MIDI_READ		0x00
+
+	/* Function Prototypes: */
+	
+		void sysExCmdDiagnostics(uint8_t length, uint8_t* buffer);
+
+#endif /* DIAGNOSTICS_H_ */
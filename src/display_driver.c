@@ -28,6 +28,8 @@
 **/
 
 #include <display_driver.h>
+#include <profiler.h>
+#include <watchdog.h>
 
 /* Variables: */
 static uint8_t display_frame_buffer[DMA_BUFFER_SIZE]; 
@@ -211,6 +213,16 @@ void clear_display_buffer(void){
 	memset(&display_frame_buffer, 0xFF, sizeof(display_frame_buffer));
 }
 
+/**
+ * Returns the frame buffer the DMA shifts out to the LED drivers, 
+ * NUM_OF_FRAMES frames of DMA_FRAME_SIZE bytes with the LEDs active low. 
+ * For tools which show the display, the DMA source address is only 16 bits
+ */
+
+const uint8_t* get_display_frame_buffer(void){
+	return display_frame_buffer;
+}
+
 
 /**
  * Display Animation Timer interrupt callback function. This is triggered about 
@@ -238,6 +250,8 @@ void display_animation_timer(void)
 
 static void display_frame_timer(void)
 {
+	uint16_t profile_start = profile_timestamp();
+	
 	// Increment the timer compare value
 	tc_write_cc(&TCC0, TC_CCA, DISPLAY_FRAME_TIMER_PERIOD + tc_read_count(&TCC0));
 	// Latch last frame to display driver shift register Outputs
@@ -267,6 +281,10 @@ static void display_frame_timer(void)
 			tick = 0;
 		}
 	}
+	
+	heartbeat(HEARTBEAT_DISPLAY);
+	
+	profile_record(PROFILE_ISR_DISPLAY_FRAME, profile_start);
 }
 
 /**
@@ -703,7 +721,7 @@ void run_encoder_animation(uint8_t encoder, uint8_t bank, uint8_t animation, uin
 	} else if ((animation > 56) && (animation < 65)) {
 		// Read Directly from RAM
 		uint8_t banked_encoder_id = encoder + bank*PHYSICAL_ENCODERS;
-		uint8_t level = (uint8_t)(pulse_animation(animation - 55));
+		uint8_t level = (uint8_t)(pulse_animation(animation - 56));
 		set_encoder_indicator_level(encoder, indicator_value_buffer[bank][encoder], encoder_settings[banked_encoder_id].has_detent,
 		encoder_settings[banked_encoder_id].indicator_display_type,
 		encoder_settings[banked_encoder_id].detent_color, level);
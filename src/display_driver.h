@@ -87,6 +87,8 @@
 	
 	void clear_display_buffer(void);
 	
+	const uint8_t* get_display_frame_buffer(void);
+	
 	void build_rgb(uint8_t encoder, uint32_t color, uint8_t level);
 	
 	int build_indicator_pattern(indicator_bit_mask_t *result, uint8_t position, uint16_t type, 
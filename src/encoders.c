@@ -32,39 +32,33 @@
 
 
 #include <encoders.h>
+#include <profiler.h>
 
 // Locals
-uint8_t indicator_value_buffer[NUM_BANKS][16];	 // Holds the 7 bit indicator value
+uint8_t indicator_value_buffer[NUM_LAYERS][16];	 // Holds the 7 bit indicator value
 
-uint8_t switch_color_buffer[NUM_BANKS][16];      // Holds the switch color setting 
+uint8_t switch_color_buffer[NUM_LAYERS][16];      // Holds the switch color setting 
 
-uint8_t switch_animation_buffer[NUM_BANKS][16];  // Holds the switch animation setting
-uint8_t encoder_animation_buffer[NUM_BANKS][16];  // Holds the encoder animation setting
+uint8_t switch_animation_buffer[NUM_LAYERS][16];  // Holds the switch animation setting
+uint8_t encoder_animation_buffer[NUM_LAYERS][16];  // Holds the encoder animation setting
 
-uint16_t enc_switch_midi_state[NUM_BANKS][16];	 // Holds the switch states
+uint16_t enc_switch_midi_state[NUM_LAYERS][16];	 // Holds the switch states
 
-uint16_t enc_switch_toggle_state[NUM_BANKS];	 // 16-Encoders Per Bank/ 1-bit per Encoder
+uint16_t enc_switch_toggle_state[NUM_LAYERS];	 // 16-Encoders Per Bank/ 1-bit per Encoder
 							// toggle state is not tied directly 
 							// to the MIDI state we use this to track.
 												 
-uint16_t switch_color_overide[NUM_BANKS];		 // Bit field to track if color override
+uint16_t switch_color_overide[NUM_LAYERS];		 // Bit field to track if color override
 												 // was received for switch color
 												 
-uint16_t enc_indicator_overide[NUM_BANKS];       // Bit field to track if indicator override
+uint16_t enc_indicator_overide[NUM_LAYERS];       // Bit field to track if indicator override
 												 // was received for indicator
 												 
-											
-// Shift Mode Variables
-
-uint16_t shift_mode_switch_state[2];			// Bit field to track the switch state for											    
-uint16_t shift_mode_midi_override[2];		    // Bit field to track the midi state for the
-												// two shift pages
-
 // - this is necessary because some parameters are shared between 'shifted' and 'non-shifted' encoders.
 
 int8_t encoder_detent_counter[PHYSICAL_ENCODERS]; // !review: could be expanded to VIRTUAL_ENCODERS, but should not be necessary
 //~ input_map_t input_map[BANKED_ENCODERS]; // !Summer2016Update: Removed in favor of expanding encoder_settings
-int16_t  raw_encoder_value[VIRTUAL_ENCODERS]; // !Summer2016Update: Expanded to store values for all banks and shifted encoders
+int16_t  raw_encoder_value[VIRTUAL_ENCODERS + SHIFT_PAGES*PHYSICAL_ENCODERS]; // !Summer2016Update: Expanded to store values for all banks and shifted encoders
 // - indexed by Virtual Encoder ID
 // --- 0-15: Encoders Bank 1 (Unshifted)
 // --- 16-31: Encoders Bank 2 (Unshifted)
@@ -74,12 +68,24 @@ int16_t  raw_encoder_value[VIRTUAL_ENCODERS]; // !Summer2016Update: Expanded to
 // --- 80-95: Encoders Bank 2 (Shifted)
 // --- 96-111: Encoders Bank 3 (Shifted)
 // --- 112-127: Encoders Bank 4 (Shifted)
+// --- 128-143: Shift Page 1
+// --- 144-159: Shift Page 2
 
 static int8_t encoder_bank = 0;
+// The layer the encoders are working on, the current bank or a shift page
+// while one is held. Layers index encoder_settings and the state buffers
+static uint8_t encoder_layer = 0;
 static int8_t g_detent_size;
 static int8_t g_dead_zone_size;
+// Fine adjust divides encoder steps by 2^g_fine_shift
+static uint8_t g_fine_shift = DEF_FINE_ADJUST_SHIFT;
+// The part of a fine adjust step not yet applied, signed as the movement.
+// The relative path counts encoder steps and the absolute path raw value
+// units, so each has its own
+static int16_t fine_relative_remainder[PHYSICAL_ENCODERS];
+static int16_t fine_absolute_remainder[PHYSICAL_ENCODERS];
 //static encoder_config_t encoder_settings[PHYSICAL_ENCODERS];
-encoder_config_t encoder_settings[BANKED_ENCODERS];
+encoder_config_t encoder_settings[LAYER_ENCODERS];
 //static encoder_config_t encoder_settings_transfer_buffer[1];
 
 
@@ -100,11 +106,21 @@ void transfer_encoder_values_to_other_banks(uint8_t current_bank);
 bool animation_is_encoder_indicator(uint8_t animation_value);
 bool animation_is_switch_rgb(uint8_t animation_value);
 bool animation_buffer_conflict_exists(uint8_t encoder_bank, uint8_t encoder);
+// - Shift Pages
+static uint8_t encoder_config_page(uint8_t layer, uint8_t encoder);
+static void get_shift_page_default_config(uint8_t layer, uint8_t encoder, encoder_config_t *cfg_ptr);
+static void compress_encoder_config(encoder_config_t *cfg_ptr, uint8_t *buffer);
+static void set_encoder_layer(uint8_t layer);
+static void clear_fine_adjust(uint8_t encoder);
 /** 
  *  Initializes all encoder buffers and EEPROM settings
 **/
 
 uint8_t get_virtual_encoder_id (uint8_t encoder_bank, uint8_t encoder_id){
+	// Shift pages have their own values after all the banked encoders
+	if (encoder_bank >= NUM_BANKS) {
+		return VIRTUAL_ENCODERS + (encoder_bank - NUM_BANKS)*PHYSICAL_ENCODERS + encoder_id;
+	}
 	uint8_t virtual_encoder_id = encoder_id;
 	//uint8_t bank = 0;
 	//uint8_t shifted = encoder_is_in_shift_state(encoder_bank, i);
@@ -186,7 +202,7 @@ void encoders_init(void)
 	// Read in all the encoder settings for all banks
 	// - in to the encoder_settings RAM Table
 	//for(uint8_t i=0;i<16;++i){
-	for(uint8_t i=0;i<BANKED_ENCODERS;++i){
+	for(uint8_t i=0;i<LAYER_ENCODERS;++i){
 		uint8_t this_bank = i/16;
 		uint8_t this_phys_encoder = i%16;
 		get_encoder_config(this_bank, this_phys_encoder, &encoder_settings[i]);
@@ -207,10 +223,17 @@ void encoders_init(void)
 		}
 	}
 	
+	// The shift pages may hold defaults rather than EEPROM settings
+	for (uint8_t i = NUM_BANKS; i<NUM_LAYERS;++i){
+		for(uint8_t j=0;j<16;++j){
+			switch_color_buffer[i][j] = encoder_settings[i*16 + j].inactive_color;
+		}
+	}
+	
 	// Initialize raw encoder values for Bank 1
 	
 	// Initialize Per-Bank related variables
-	for (uint8_t i = 0; i<NUM_BANKS;++i){ 
+	for (uint8_t i = 0; i<NUM_LAYERS;++i){ 
 		// !Summer2016Update: Moved this encoder_value init, so it initializes ALL values.
 		enc_switch_toggle_state[i] = 0x0000;
 	}	 
@@ -218,6 +241,7 @@ void encoders_init(void)
 	// Initialize Per-Physical Encoder related variables
 	for (uint8_t i = 0; i<PHYSICAL_ENCODERS;++i){ 
 		encoder_detent_counter[i] = 0;
+		clear_fine_adjust(i);
 		enc_switch_toggle_state[encoder_bank] = 0;
 	}
 
@@ -232,6 +256,13 @@ void encoders_init(void)
 		}
 	}
 	
+	// Initialize the shift page encoders, which have no 'shifted encoder'
+	for (uint8_t i = BANKED_ENCODERS; i<LAYER_ENCODERS;++i){
+		uint8_t virtual_encoder_id = get_virtual_encoder_id(i/16, i%16);
+		raw_encoder_value[virtual_encoder_id] = encoder_settings[i].has_detent ? 6300 : 0;
+		indicator_value_buffer[i/16][i%16] = raw_encoder_value[virtual_encoder_id] / 100;
+	}
+	
 	// Initialize MIDI input map for all encoders	
 	// !Summer2016Update mark: sync_input_map_to_output_map 
 	// - (added and then removed in favor of expanding encoder_settings)
@@ -244,6 +275,54 @@ void encoders_init(void)
 	g_dead_zone_size = 2;	
 }
 
+/**
+ * Sets how far encoder steps are reduced while fine adjust is held, steps
+ * are divided by 2^shift.
+ *
+ * \param shift [in]	1 - FINE_ADJUST_SHIFT_MAX
+ */
+void set_fine_adjust_shift(uint8_t shift)
+{
+	if (shift > FINE_ADJUST_SHIFT_MAX) {
+		shift = FINE_ADJUST_SHIFT_MAX;
+	}
+	g_fine_shift = shift;
+}
+
+uint8_t get_fine_adjust_shift(void)
+{
+	return g_fine_shift;
+}
+
+/**
+ * Adds a change to a fine adjust remainder and takes out the whole reduced
+ * steps. The magnitude is shifted, so the steps round toward zero without a
+ * division: a change must reach 2^g_fine_shift in either direction before
+ * anything is sent and a single tick of jitter sends nothing.
+ *
+ * \param remainder [in,out]	The encoder's remainder for the path
+ * \param change [in]			The unreduced change
+ * \return						The reduced change
+ */
+static int16_t take_fine_adjust_steps(int16_t* remainder, int16_t change)
+{
+	int16_t total = *remainder + change;
+	bool negative = total < 0;
+	uint16_t magnitude = negative ? -total : total;
+	
+	int16_t steps = magnitude >> g_fine_shift;
+	int16_t kept = magnitude & ((1 << g_fine_shift) - 1);
+	
+	*remainder = negative ? -kept : kept;
+	return negative ? -steps : steps;
+}
+
+static void clear_fine_adjust(uint8_t encoder)
+{
+	fine_relative_remainder[encoder] = 0;
+	fine_absolute_remainder[encoder] = 0;
+}
+
 /**
  *	Reads the configuration data for a given encoder and writes it to the table
  *  specified by cfg_ptr. See header file for a map of the EEPROM layout for 
@@ -258,7 +337,7 @@ void encoders_init(void)
 
 void get_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_ptr)
 {
-	uint16_t addr = (ENC_SETTINGS_START_PAGE * 32) + (bank * 128) + (encoder * 8);
+	uint16_t addr = (encoder_config_page(bank, encoder) * 32) + ((encoder % 4) * 8);
 	
 	uint8_t buffer[8];
 	
@@ -267,6 +346,13 @@ void get_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_ptr
 	nvm_eeprom_read_buffer(addr, buffer, 8);
 	cpu_irq_enable();
 	
+	// Shift page encoders which have never been saved keep the fixed
+	// mapping the shift pages have always had
+	if ((bank >= NUM_BANKS) && (buffer[6] & SHIFT_EE_UNSAVED)) {
+		get_shift_page_default_config(bank, encoder, cfg_ptr);
+		return;
+	}
+	
 	// Expand compressed settings
 	cfg_ptr->switch_action_type		= buffer[0] & 0x0F;
 	cfg_ptr->switch_midi_type		= 0;//(buffer[0] >> 1) & 0x01;
@@ -283,6 +369,90 @@ void get_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_ptr
 	cfg_ptr->encoder_midi_channel   = (buffer[6] >> 4) & 0x0F;
 	cfg_ptr->encoder_midi_number	= buffer[7] & 0x7F;
 	cfg_ptr->is_super_knob          = (buffer[7] >> 7) & 0x01;
+	
+	// A page whose write was cut short by a power loss reads back partly
+	// erased, out of range settings fall back to their defaults
+	if (cfg_ptr->switch_action_type > ENC_SHIFT_TOGGLE) {
+		cfg_ptr->switch_action_type = DEF_SW_ACTION;
+	}
+	if (cfg_ptr->active_color > 0x7F) {
+		cfg_ptr->active_color = DEF_ACTIVE_COLOR;
+	}
+	if (cfg_ptr->inactive_color > 0x7F) {
+		cfg_ptr->inactive_color = DEF_INACTIVE_COLOR;
+	}
+	if (cfg_ptr->movement > EMULATION) {
+		cfg_ptr->movement = DEF_ENC_MOVEMENT;
+	}
+	if (cfg_ptr->encoder_midi_type > SEND_REL_ENC) {
+		cfg_ptr->encoder_midi_type = DEF_ENC_MIDI_TYPE;
+	}
+}
+
+/**
+ * Returns the EEPROM page holding the settings of an encoder. Each page holds
+ * a row of four encoders, the banks are stored first. Shift page rows use the
+ * pages after the side switch layers and macros, the last row goes in the
+ * page after the sequencer.
+ * 
+ * \param layer [in]	The bank, or NUM_BANKS + the shift page
+ *
+ * \param encoder [in]	The index of the encoder
+ */
+static uint8_t encoder_config_page(uint8_t layer, uint8_t encoder)
+{
+	if (layer < NUM_BANKS) {
+		return ENC_SETTINGS_START_PAGE + (4 * layer) + (encoder / 4);
+	}
+	
+	uint8_t page = SHIFT_LAYER_EE_START_PAGE + (4 * (layer - NUM_BANKS)) + (encoder / 4);
+	if (page >= SEQ_EEPROM_START_PAGE) {
+		page = SHIFT_LAYER_EE_LAST_PAGE;
+	}
+	return page;
+}
+
+/**
+ * Fills in the default settings of a shift page encoder, its switch sends the
+ * notes the shift pages have always sent and its encoder sends a CC of the
+ * same number, both in the system channel.
+ */
+static void get_shift_page_default_config(uint8_t layer, uint8_t encoder, encoder_config_t *cfg_ptr)
+{
+	uint8_t number = SHIFT_OFFSET + ((layer - NUM_BANKS) * 16) + encoder;
+	
+	cfg_ptr->switch_action_type		= NOTE_HOLD;
+	cfg_ptr->switch_midi_type		= 0;
+	cfg_ptr->switch_midi_channel	= midi_system_channel;
+	cfg_ptr->switch_midi_number		= number;
+	cfg_ptr->active_color			= DEF_SHIFT_ACTIVE_COLOR;
+	cfg_ptr->inactive_color			= DEF_SHIFT_INACTIVE_COLOR;
+	cfg_ptr->detent_color			= DEF_DETENT_COLOR;
+	cfg_ptr->has_detent				= false;
+	cfg_ptr->indicator_display_type = BAR;
+	cfg_ptr->movement				= DEF_ENC_MOVEMENT;
+	cfg_ptr->encoder_shift_midi_channel = midi_system_channel;
+	cfg_ptr->encoder_midi_type		= SEND_CC;
+	cfg_ptr->encoder_midi_channel   = midi_system_channel;
+	cfg_ptr->encoder_midi_number	= number;
+	cfg_ptr->is_super_knob          = false;
+}
+
+/**
+ * Packs a full set of encoder settings into its 8 EEPROM bytes, the reverse
+ * of get_encoder_config()
+ */
+static void compress_encoder_config(encoder_config_t *cfg_ptr, uint8_t *buffer)
+{
+	buffer[0] = (cfg_ptr->switch_action_type & 0x0F) | (0xF0 & (cfg_ptr->switch_midi_channel << 4));
+	buffer[1] = cfg_ptr->switch_midi_number & 0x7F;
+	buffer[2] = cfg_ptr->active_color;
+	buffer[3] = cfg_ptr->inactive_color;
+	buffer[4] = (0x80 & (cfg_ptr->has_detent << 7)) | (0x7F & cfg_ptr->detent_color);
+	buffer[5] = (0x03 & cfg_ptr->indicator_display_type) | (0x0C & (cfg_ptr->movement << 2)) |
+				(0xF0 & (cfg_ptr->encoder_shift_midi_channel << 4));
+	buffer[6] = (0x03 & cfg_ptr->encoder_midi_type) | (0xF0 & (cfg_ptr->encoder_midi_channel << 4));
+	buffer[7] = (0x7F & cfg_ptr->encoder_midi_number) | (0x80 & (cfg_ptr->is_super_knob << 7));
 }
 
 // !review: this may not be correct
@@ -310,21 +480,25 @@ void get_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_ptr
  */
 void save_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_ptr)
 {	
-	// Record the new setting to RAM first
-	uint8_t virtual_encoder_id = get_virtual_encoder_id (bank, encoder);
-	encoder_settings[virtual_encoder_id] = *cfg_ptr; // !review: might be '&' instead of *
-	
 	// Create a tempory page_buffer;
 	uint8_t page_buffer[EEPROM_PAGE_SIZE];
 	
 	// Each page contains setting for four encoders, so to avoid overwriting the
 	// data for the other 3 encoders we have to read in their setting first.
-	uint16_t page_address = (ENC_SETTINGS_START_PAGE * 32) + (bank * 128) + ((encoder/4)*32);
-	nvm_eeprom_read_buffer(page_address, page_buffer, EEPROM_PAGE_SIZE);
+	uint8_t page_index = encoder_config_page(bank, encoder);
+	nvm_eeprom_read_buffer(page_index * 32, page_buffer, EEPROM_PAGE_SIZE);
 	
 	uint8_t* buffer_ptr = page_buffer;
 	buffer_ptr += (8 * (encoder % 4));
 	
+	// A shift page encoder saved for the first time starts from its
+	// defaults, so any setting not being updated keeps its default
+	if ((bank >= NUM_BANKS) && (buffer_ptr[6] & SHIFT_EE_UNSAVED)) {
+		encoder_config_t shift_default;
+		get_shift_page_default_config(bank, encoder, &shift_default);
+		compress_encoder_config(&shift_default, buffer_ptr);
+	}
+	
 	// Switch Action, Switch MIDI type & Switch MIDI channel are saved
 	// in the first byte
 	if (cfg_ptr->switch_action_type < 0x80){
@@ -390,7 +564,8 @@ void save_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_pt
 		*buffer_ptr &= ~0xF0;
 		*buffer_ptr |= (0xF0 & ((cfg_ptr->encoder_midi_channel - 1) << 4));
 	}
-	buffer_ptr++;	// 2-bits Open 0xC0
+	*buffer_ptr &= ~SHIFT_EE_UNSAVED;
+	buffer_ptr++;	// Full, 0x0C marks shift page encoders never saved
 	
 	// Encoder MIDI number & is super knob flag are saved in the 8th byte
 	if (cfg_ptr->encoder_midi_number < 0x80){
@@ -403,13 +578,17 @@ void save_encoder_config(uint8_t bank, uint8_t encoder, encoder_config_t *cfg_pt
 	}
 	buffer_ptr++;  // Full
 	
-	uint8_t page_index = ENC_SETTINGS_START_PAGE + (4 * bank) + (encoder / 4);
-	
 	// Save the updated page buffer back to EEPROM
 	cpu_irq_disable();
 	nvm_eeprom_load_page_to_buffer(page_buffer);
 	nvm_eeprom_atomic_write_page(page_index);
 	cpu_irq_enable();
+	
+	// Then reload the RAM table from what was saved, settings which were not
+	// updated keep their old value
+	if (bank < NUM_LAYERS) {
+		get_encoder_config(bank, encoder, &encoder_settings[bank*PHYSICAL_ENCODERS + encoder]);
+	}
 
 	// !Summer2016Update: Match the newly changed input_map to match the output_map saved in eeprom
 	// - removed in favor of expanding encoder_map
@@ -533,6 +712,15 @@ void factory_reset_encoder_config(void)
 		}
 		page_index++;
 	}
+	
+	// The shift pages are erased, so they return to their fixed defaults
+	memset(&page_buffer, 0xFF, EEPROM_PAGE_SIZE);
+	for(uint8_t i=0;i<4*SHIFT_PAGES;++i){
+		cpu_irq_disable();
+		nvm_eeprom_load_page_to_buffer(page_buffer);
+		nvm_eeprom_atomic_write_page(encoder_config_page(NUM_BANKS + i/4, (i%4)*4));
+		cpu_irq_enable();
+	}
 }
 
 //void adjust_
@@ -541,16 +729,20 @@ void factory_reset_encoder_config(void)
  * Contains the main encoder task, this checks encoder hardware for change
  * then translates this change into a MIDI value based on the encoders
  * settings, if the MIDI value changes then the updated value is sent
- * and saved into the MIDI state buffer.
+ * and saved into the MIDI state buffer. The encoder switch state must already 
+ * have been updated this loop, see update_encoder_switch_state().
  */                                                                
 void   process_encoder_input(void)
 {
+	uint16_t profile_start = profile_timestamp();
 	
 	int16_t new_value;
 	uint16_t bit = 0x0001;
 	uint8_t virtual_encoder_id, banked_encoder_id;
-	// Update the current encoder switch states
-	update_encoder_switch_state();
+	
+	// Fine adjust is applied to every encoder while a fine adjust side
+	// switch is held, or to a single encoder while its own switch is held
+	bool fine_adjust_all = side_switch_fine_adjust_held();
 	
 	for (uint8_t i=0;i<16;i++) {
 		
@@ -558,11 +750,15 @@ void   process_encoder_input(void)
 		new_value = get_encoder_value(i);  // !review: int8 return is being assigned to int16	
 		
 		// Get Virtual Encoder ID (for Value storage)
-		virtual_encoder_id = get_virtual_encoder_id(encoder_bank, i);
-		banked_encoder_id = virtual_encoder_id & BANKED_ENCODER_MASK;
+		virtual_encoder_id = get_virtual_encoder_id(encoder_layer, i);
+		banked_encoder_id = encoder_layer*PHYSICAL_ENCODERS + i;
 				
 		if (new_value) {
 			
+			bool fine_adjust = fine_adjust_all ||
+							   (encoder_settings[banked_encoder_id].switch_action_type == ENC_FINE_ADJUST &&
+							    get_enc_switch_state() & bit);
+			
 			if ((encoder_settings[banked_encoder_id].has_detent) && 
 			     encoder_is_in_detent(raw_encoder_value[virtual_encoder_id])) {	
 					
@@ -576,7 +772,7 @@ void   process_encoder_input(void)
 					raw_encoder_value[virtual_encoder_id] = 6200;
 				}
 				
-			} else if (encoder_is_in_deadzone(raw_encoder_value[virtual_encoder_id]) && (!(encoder_settings[banked_encoder_id].encoder_midi_type == SEND_REL_ENC))) { // && (!encoder_is_in_shift_state(encoder_bank, i))) { // !error: allows overflow for shifted encoders
+			} else if (encoder_is_in_deadzone(raw_encoder_value[virtual_encoder_id]) && (!(encoder_settings[banked_encoder_id].encoder_midi_type == SEND_REL_ENC))) { // && (!encoder_is_in_shift_state(encoder_layer, i))) { // !error: allows overflow for shifted encoders
 				// The encoder is in a end zone, only change the encoder value
 				//   once we have moved out of the dead zone. 
 				
@@ -605,19 +801,9 @@ void   process_encoder_input(void)
 					// Calculate Output Value 
 					// new_value will be 1 or -1 if it gets here(though technically it could hold values higher)
 					uint8_t output_value;// = 64 + new_value;	// Relative: Bin Offset
-					if (encoder_settings[banked_encoder_id].switch_action_type == ENC_FINE_ADJUST &&
-					    get_enc_switch_state() & bit) { // !Summer2016Update: Relative Encoder Fine Adjustment Added
-						static int16_t relative_fine_value[PHYSICAL_ENCODERS] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};  // Counter
-						relative_fine_value[i] += new_value;
-						output_value = 64;
-						while (relative_fine_value[i] >= 4)  { // Adjust for Clockwise Output -> 4=ENC_REL_FINE_LIMIT
-							relative_fine_value[i] -= 4;
-							output_value++;
-						}
-						while (relative_fine_value[i] <= -4)  { // Adjust for CounterClockwise Output -> 4=ENC_REL_FINE_LIMIT
-							relative_fine_value[i] += 4;
-							output_value--;
-						}
+					if (fine_adjust) { // !Summer2016Update: Relative Encoder Fine Adjustment Added
+						// Only whole steps are sent, the remainder is kept for the next movement
+						output_value = 64 + take_fine_adjust_steps(&fine_relative_remainder[i], new_value);
 					}
 					else {	// Case: Normal 
 						output_value = 64 + new_value;	// Relative: Bin Offset
@@ -625,7 +811,7 @@ void   process_encoder_input(void)
 
 					//uint8_t output_value = (uint8_t)(new_value) & 0x7F;	// Relative: Two's Complement
 					uint8_t midi_channel;
-					if (!encoder_is_in_shift_state(encoder_bank, i)){ // !Summer2016Update Shifted Encoders Midi Channel
+					if (!encoder_is_in_shift_state(encoder_layer, i)){ // !Summer2016Update Shifted Encoders Midi Channel
 						midi_channel = encoder_settings[banked_encoder_id].encoder_midi_channel;
 					} else{
 						midi_channel = encoder_settings[banked_encoder_id].encoder_shift_midi_channel;
@@ -646,8 +832,9 @@ void   process_encoder_input(void)
 					
 					// The encoder is not current in any detent or end zone
 				
-					/* If the switch action is fine adjust we change the raw
-					   value by 25 per enc step, otherwise we change by 100
+					/* If fine adjust is held we change the raw value by 
+					   100 / 2^g_fine_shift per enc step (25 by default), 
+					   otherwise we change by 100
 					   per step for the direct movement type and 178 for the 
 					   emulation movement type. The emulation movement type
 					   gives the full CC range over 270 degrees so the encoder
@@ -655,10 +842,10 @@ void   process_encoder_input(void)
 					 
 					int16_t scaled_value;
 					 
-					if (encoder_settings[banked_encoder_id].switch_action_type == ENC_FINE_ADJUST &&
-					    get_enc_switch_state() & bit) {
-						// Fine adjust sensitivity, 1 pulse = 1/4 a CC step	
-						scaled_value = new_value*25; 
+					if (fine_adjust) {
+						// Fine adjust sensitivity, 1 pulse = 1/2^g_fine_shift a CC step. 
+						// The raw change is accumulated and shifted down so no movement is lost
+						scaled_value = take_fine_adjust_steps(&fine_absolute_remainder[i], new_value*100);
 						
 					} else if(encoder_settings[banked_encoder_id].movement == DIRECT) {
 							// Standard sensitivity, 1 pulse = 1 CC step
@@ -670,7 +857,7 @@ void   process_encoder_input(void)
 						   //scaled_value = new_value*200;   
 					}
 			
-					if (encoder_is_in_shift_state(encoder_bank, i)){  // !Summer2016Update: encoder_is_in_shift_state
+					if (encoder_is_in_shift_state(encoder_layer, i)){  // !Summer2016Update: encoder_is_in_shift_state
 						// !review: should be able to merge this if-else, since shift is now dealt with
 						// - in get_virtual_encoder_id, only send_indicator_midi will differ (via a boolean declaration
 						// !Summer2016Update: Shifted Encoders MIDI Channel/ Encoder Value Expansion
@@ -680,7 +867,7 @@ void   process_encoder_input(void)
 						uint8_t control_change_value = scale_encoder_value(raw_encoder_value[virtual_encoder_id]);
 						//send_element_midi(SWITCH, i, control_change_value, true);
 						send_encoder_midi(banked_encoder_id, control_change_value, true, true); // !Summer2016Update: Shifted Encoders now always output as Encoders
-						indicator_value_buffer[encoder_bank][i]=control_change_value;
+						indicator_value_buffer[encoder_layer][i]=control_change_value;
 						
 					} else {
 						// !Summer2016Update: Shifted Encoders MIDI Channel/ Encoder Value Expansion
@@ -690,8 +877,8 @@ void   process_encoder_input(void)
 						uint8_t control_change_value = scale_encoder_value(raw_encoder_value[virtual_encoder_id]);
 						//send_element_midi(ENCODER, i, control_change_value, true);
 						send_encoder_midi(banked_encoder_id, control_change_value, true, false);
-						//if(!(bit & enc_indicator_overide[encoder_bank])) {
-							indicator_value_buffer[encoder_bank][i]=control_change_value;
+						//if(!(bit & enc_indicator_overide[encoder_layer])) {
+							indicator_value_buffer[encoder_layer][i]=control_change_value;
 						//}	
 					}	
 				}
@@ -707,16 +894,16 @@ void   process_encoder_input(void)
 				case NOTE_TOGGLE:{
 					if(bit & get_enc_switch_down()) {
 						// Toggle the MIDI state
-						enc_switch_midi_state[encoder_bank][i] = enc_switch_midi_state[encoder_bank][i] ? 
+						enc_switch_midi_state[encoder_layer][i] = enc_switch_midi_state[encoder_layer][i] ? 
 																 0 : 127;
 						// Update the display
-						if (!color_overide_active(encoder_bank,i)) {
-							switch_color_buffer[encoder_bank][i] = enc_switch_midi_state[encoder_bank][i] ?
+						if (!color_overide_active(encoder_layer,i)) {
+							switch_color_buffer[encoder_layer][i] = enc_switch_midi_state[encoder_layer][i] ?
 							encoder_settings[banked_encoder_id].active_color : encoder_settings[banked_encoder_id].inactive_color;
 						}
 						// And send any MIDI
-						send_element_midi(SWITCH, banked_encoder_id, enc_switch_midi_state[encoder_bank][i],
-						enc_switch_midi_state[encoder_bank][i]);
+						send_element_midi(SWITCH, banked_encoder_id, enc_switch_midi_state[encoder_layer][i],
+						enc_switch_midi_state[encoder_layer][i]);
 					}
 				}
 				break;
@@ -726,18 +913,18 @@ void   process_encoder_input(void)
 				// cascade to the next case ... NO BREAK ON PURPOSE
 				case NOTE_HOLD:{
 					if (bit & get_enc_switch_down()) {
-						enc_switch_midi_state[encoder_bank][i] = 127;
+						enc_switch_midi_state[encoder_layer][i] = 127;
 					} else {
-						enc_switch_midi_state[encoder_bank][i] = 0;
+						enc_switch_midi_state[encoder_layer][i] = 0;
 					}
 					// Update the display
-					if (!color_overide_active(encoder_bank,i)) {
-						switch_color_buffer[encoder_bank][i] = enc_switch_midi_state[encoder_bank][i] ?
+					if (!color_overide_active(encoder_layer,i)) {
+						switch_color_buffer[encoder_layer][i] = enc_switch_midi_state[encoder_layer][i] ?
 						encoder_settings[banked_encoder_id].active_color : encoder_settings[banked_encoder_id].inactive_color;
 					}
 					// And send any MIDI
-					send_element_midi(SWITCH, banked_encoder_id, enc_switch_midi_state[encoder_bank][i],
-					enc_switch_midi_state[encoder_bank][i]);
+					send_element_midi(SWITCH, banked_encoder_id, enc_switch_midi_state[encoder_layer][i],
+					enc_switch_midi_state[encoder_layer][i]);
 				}
 				break;
 				
@@ -759,7 +946,7 @@ void   process_encoder_input(void)
 					// Send the updated encoder value
 					encoder_detent_counter[i] = 0;
 					send_element_midi(ENCODER, banked_encoder_id, control_change_value, true);  // Last Encoder call to 'send_element_midi', all others upgraded to 'send_encoder_midi'
-					indicator_value_buffer[encoder_bank][i]=control_change_value;
+					indicator_value_buffer[encoder_layer][i]=control_change_value;
 					// Then send the switch action
 					if (bit & get_enc_switch_down()) {						
 						send_element_midi(SWITCH, banked_encoder_id , 127, true);
@@ -771,13 +958,13 @@ void   process_encoder_input(void)
 				case ENC_SHIFT_HOLD:{
 					if (bit & get_enc_switch_down()){
 						// Update the display with the active color
-						if (!color_overide_active(encoder_bank,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
-							switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].active_color;
+						if (!color_overide_active(encoder_layer,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
+							switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].active_color;
 						}
-						//switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].active_color;
+						//switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].active_color;
 						
 						// Update the indicator display with the shift value
-						indicator_value_buffer[encoder_bank][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
+						indicator_value_buffer[encoder_layer][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
 						// Send a Note On
 						//midi_stream_raw_note(encoder_settings[banked_encoder_id].switch_midi_channel, // Update 20160622 - send according to switch settings
 						midi_stream_raw_cc(encoder_settings[banked_encoder_id].switch_midi_channel, // Update 20160622 - send according to switch settings
@@ -789,13 +976,13 @@ void   process_encoder_input(void)
 						
 					} else if (bit & get_enc_switch_up()) {
 						// Update the display the inactive color
-						if (!color_overide_active(encoder_bank,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
-							switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].inactive_color;
+						if (!color_overide_active(encoder_layer,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
+							switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].inactive_color;
 						}
-						//switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].inactive_color;
+						//switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].inactive_color;
 						
 						// Update the indicator display with the base encoder value
-						indicator_value_buffer[encoder_bank][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
+						indicator_value_buffer[encoder_layer][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
 						// Send a Note Off
 						//midi_stream_raw_note(encoder_settings[banked_encoder_id].switch_midi_channel, // Update 20160622 - send according to switch settings
 						midi_stream_raw_cc(encoder_settings[banked_encoder_id].switch_midi_channel, // Update 20160622 - send according to switch settings
@@ -811,19 +998,19 @@ void   process_encoder_input(void)
 				case ENC_SHIFT_TOGGLE:{
 					if (bit & get_enc_switch_down()){
 						// Toggle state
-						enc_switch_toggle_state[encoder_bank] ^= bit;
-						virtual_encoder_id = get_virtual_encoder_id(encoder_bank, i); // !Summer2016Update Re-Read virtual_encoder_id
+						enc_switch_toggle_state[encoder_layer] ^= bit;
+						virtual_encoder_id = get_virtual_encoder_id(encoder_layer, i); // !Summer2016Update Re-Read virtual_encoder_id
 														// - now that toggle_state has been updated
 						// - this case is change indicator display before change value access to back to the 'non-shifted encoder'		
-						if (bit & enc_switch_toggle_state[encoder_bank]){
+						if (bit & enc_switch_toggle_state[encoder_layer]){
 							// Update the display the active color
-							if (!color_overide_active(encoder_bank,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
-								switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].active_color;
+							if (!color_overide_active(encoder_layer,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
+								switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].active_color;
 							}
-							//switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].active_color;
+							//switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].active_color;
 
 							// Update the indicator display with the shift value
-							indicator_value_buffer[encoder_bank][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
+							indicator_value_buffer[encoder_layer][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
 							
 							// Send a CC
 							// !Summer2016Update: Encoder Shift Switches now output CCs on Switch Channel like other special function switches
@@ -835,13 +1022,13 @@ void   process_encoder_input(void)
 							
 						} else {
 							// Update the display the inactive color
-							if (!color_overide_active(encoder_bank,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
-								switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].inactive_color;
+							if (!color_overide_active(encoder_layer,i)) { // 20160622 - Allow midi feedback override of RGB Indicator.
+								switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].inactive_color;
 							}
-							//switch_color_buffer[encoder_bank][i] = encoder_settings[banked_encoder_id].inactive_color;
+							//switch_color_buffer[encoder_layer][i] = encoder_settings[banked_encoder_id].inactive_color;
 							
 							// Update the indicator display with the base encoder value
-							indicator_value_buffer[encoder_bank][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
+							indicator_value_buffer[encoder_layer][i]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100);
 							
 							// Send a CC
 							// !Summer2016Update: Encoder Shift Switches now output CCs on Switch Channel like other special function switches
@@ -859,62 +1046,10 @@ void   process_encoder_input(void)
 		}
 		bit <<=1;
 	}
-}
-
-/**
- * Shift mode is an alternate operation mode which is accessed by the side buttons
- * In shift mode the encoders do not do anything, only the switches have effect.
- * All 11 position LEDs are turned on and the RGB set to white if active.  
- * 
- * \param page [in]	0, 1 Which shift page is being accessed
- */
-void run_shift_mode(uint8_t page){
-	
-	static uint8_t idx = 0x00;
-	
-	// First we check the encoder switch states and send any MIDI
-	update_encoder_switch_state();
-	uint16_t bit = 0x01;
 	
-	//uint16_t sw_down = get_enc_switch_down();
-	
-	for(uint8_t i=0;i<16;++i){
-		if (bit & get_enc_switch_down()) {
-			// Switch was just pressed
-			midi_stream_raw_note(midi_system_channel, SHIFT_OFFSET + (i+(page*16)) , true, 127);
-			// Set state if override is not active
-			if(!(shift_mode_midi_override[page] & bit)){
-				shift_mode_switch_state[page] |= bit;
-			}
-			
-		} else if (bit & get_enc_switch_up()) {
-			// Switch was just released
-			//send_element_midi(SHIFT, i+(page*16), 0, false);
-			midi_stream_raw_note(midi_system_channel, SHIFT_OFFSET + (i+(page*16)), false, 0);
-			// Clear state if override is not active
-			if(!(shift_mode_midi_override[page] & bit)){
-				shift_mode_switch_state[page] &= ~bit;
-			}
-		}
-		bit <<=1;
-	}
-		
-	// The we update the display.
-	if (shift_mode_switch_state[page] & (0x01<<idx)){
-		// Set the LEDs on
-		set_encoder_rgb(idx, 0);
-		set_encoder_indicator(idx,127, false, BAR, 0);
-	} else {
-		set_encoder_rgb(idx, 0);
-		set_encoder_indicator(idx,0, false, BAR, 0);
-	}
-	
-	// Increment the encoder index for next time
-	idx += 1;
-	if(idx > 15){idx = 0;}
+	profile_record(PROFILE_ENCODER_INPUT, profile_start);
 }
 
-
 void send_encoder_midi(uint8_t banked_encoder_idx, uint8_t value, bool state, bool shifted)
 {
 	uint8_t midi_channel = shifted ? encoder_settings[banked_encoder_idx].encoder_shift_midi_channel: encoder_settings[banked_encoder_idx].encoder_midi_channel;
@@ -934,8 +1069,6 @@ void send_encoder_midi(uint8_t banked_encoder_idx, uint8_t value, bool state, bo
 			// Clamp to 127
 			secondary_value = secondary_value > 127 ? 127 : secondary_value;
 
-			MIDI_Device_Flush(g_midi_interface_info);
-					
 			//midi_stream_raw_cc(encoder_settings[banked_encoder_idx].encoder_midi_channel,
 			midi_stream_raw_cc(midi_channel,  // !Summer2016Update: !Review: should 'super knob' use shift midi channel
 			encoder_settings[banked_encoder_idx].encoder_midi_number+64,
@@ -967,7 +1100,7 @@ void send_encoder_midi(uint8_t banked_encoder_idx, uint8_t value, bool state, bo
 void send_element_midi(enc_control_type_t type, uint8_t banked_encoder_idx, uint8_t value, bool state)
 {
 	//if(banked_encoder_idx>15){
-	if(banked_encoder_idx >= BANKED_ENCODERS){
+	if(banked_encoder_idx >= LAYER_ENCODERS){
 		return;
 	}
 	
@@ -989,8 +1122,6 @@ void send_element_midi(enc_control_type_t type, uint8_t banked_encoder_idx, uint
 					// Clamp to 127
 					secondary_value = secondary_value > 127 ? 127 : secondary_value;
 
-					MIDI_Device_Flush(g_midi_interface_info);
-						
 					midi_stream_raw_cc(encoder_settings[banked_encoder_idx].encoder_midi_channel,
 										encoder_settings[banked_encoder_idx].encoder_midi_number+64,
 										(uint8_t)secondary_value);
@@ -1077,28 +1208,23 @@ void send_element_midi(enc_control_type_t type, uint8_t banked_encoder_idx, uint
 #define ENABLE_DUPLICATE_INPUT_MAPPINGS 1
 
 // Midi Feedback - Main Routine
-void process_element_midi(uint8_t channel, uint8_t type, uint8_t number, uint8_t value, uint8_t state)
+static void element_midi_feedback(uint8_t channel, uint8_t type, uint8_t number, uint8_t value, uint8_t state)
 {
 	// If the incoming midi is in the system channel then its mapping is fixed 
 	if (channel == midi_system_channel) {
 		// Fixed for notes for now
 		if ((type == SEND_NOTE) || (type == SEND_NOTE_OFF)){
-			if ((number >= SHIFT_OFFSET) && (number <= SHIFT_OFFSET+32)){
-				number = number - SHIFT_OFFSET;
-				uint8_t index  = number % 16;
-				uint8_t bank   = number / 16;
-				// Set the corresponding overide bit
-				shift_mode_midi_override[bank] |= (0x0001 << index);
-				if (value){
-					shift_mode_switch_state[bank] |= (0x0001 << index);
-					} else {
-					shift_mode_switch_state[bank] &= ~(0x0001 << index);
-				}
+			if ((number >= SHIFT_OFFSET) && (number < SHIFT_OFFSET+(SHIFT_PAGES*16))){
+				// The shift page switches, whatever they have been mapped to
+				uint8_t idx = BANKED_ENCODERS + (number - SHIFT_OFFSET);
+				value = (type == SEND_NOTE) ? value : 0;
+				process_sw_rgb_update(idx, value);
+				process_sw_toggle_update(idx, value);
 			}
 		}
 	} else {
 		// Otherwise the input is re mappable so scan through the input map for a match
-		for(uint8_t i=0;i<64;++i){
+		for(uint8_t i=0;i<LAYER_ENCODERS;++i){
 			// Search the input map for a match
 			if(encoder_settings[i].encoder_midi_number == number){
 				uint8_t output_type = encoder_settings[i].encoder_midi_type;
@@ -1123,7 +1249,7 @@ void process_element_midi(uint8_t channel, uint8_t type, uint8_t number, uint8_t
 					#if ENABLE_DUPLICATE_INPUT_MAPPINGS == 0
 					return;
 					#endif
-				} else if(encoder_settings[i].encoder_shift_midi_channel == channel){
+				} else if((i < BANKED_ENCODERS) && (encoder_settings[i].encoder_shift_midi_channel == channel)){
 					// Matched to an shifted encoder's indicator
 					// - !Summer2016Update: MIDI Type Filtering for MIDI Feedback
 					if(type == SEND_CC){ 
@@ -1205,6 +1331,17 @@ void process_element_midi(uint8_t channel, uint8_t type, uint8_t number, uint8_t
 	}
 }
 
+/**
+ * Profiled entry to element_midi_feedback(), which returns from several 
+ * places once a message is matched.
+ */
+void process_element_midi(uint8_t channel, uint8_t type, uint8_t number, uint8_t value, uint8_t state)
+{
+	uint16_t profile_start = profile_timestamp();
+	element_midi_feedback(channel, type, number, value, state);
+	profile_record(PROFILE_ELEMENT_MIDI, profile_start);
+}
+
 // Midi Feedback - Encoder Value Indicator Displays
 // value: MIDI Value (7-bit)
 // shifted: 	0 = Incoming messages is referencing base encoder mapping
@@ -1218,10 +1355,13 @@ void process_indicator_update(uint8_t idx, uint8_t value, uint8_t rx_msg_shifted
 	uint8_t current_shift_state = encoder_is_in_shift_state(bank, encoder); 
 	uint8_t virtual_encoder_id = idx;// can't use get_virtual_encoder_id(bank, encoder) because we may be accessing encoder outside of current shift state.
 	virtual_encoder_id += rx_msg_shifted_mapping ? BANKED_ENCODERS:0; // Increment virtual_encoder_id to enable addressing of rx_msg_shifted_mapping encoders (if applicable)
+	if (bank >= NUM_BANKS) {
+		virtual_encoder_id = get_virtual_encoder_id(bank, encoder); // Shift pages have no shifted mapping
+	}
 	
 	// !review: should be able to merge cases here, now that raw_encoder_value has been expanded
 	// Update the raw value if bank is active, and the encoder is not currently moving
-	if (bank == current_encoder_bank()) {
+	if (bank == encoder_layer) {
 		if ( !encoder_is_active(encoder)  ||  encoder_midi_type_is_relative(encoder) ) {
 			int16_t raw_value= ((uint16_t)value)*100;
 			raw_encoder_value[virtual_encoder_id] = raw_value;
@@ -1249,7 +1389,7 @@ void process_sw_rgb_update(uint8_t idx, uint8_t value)
 	if (value == 0){
 		// Disable the color over ride
 		switch_color_overide[bank] &= ~(0x01<<encoder);
-		switch_color_buffer[bank][encoder] = encoder_settings[encoder].inactive_color;
+		switch_color_buffer[bank][encoder] = encoder_settings[idx].inactive_color;
 	} else if (value >0 && value < 126) { // Exclude 126 as we don't allow user to set color to white
 		// Enable the override and set the color to value
 		switch_color_overide[bank] |= (0x01<<encoder);
@@ -1314,9 +1454,7 @@ void process_sw_encoder_shift_update(uint8_t idx, uint8_t value){
 	// Update Encoder Value Display
 	// - Get virtual encoder number so we know which value to display (shifted or unshifted)
 	// - this must stay after the update of enc_switch_toggle_state!
-	uint8_t virtual_encoder_id = idx;
-	if (encoder_is_in_shift_state(bank, encoder))
-		{virtual_encoder_id += 64;}
+	uint8_t virtual_encoder_id = get_virtual_encoder_id(bank, encoder);
 	indicator_value_buffer[bank][encoder]=(uint8_t)(raw_encoder_value[virtual_encoder_id]/100); // update display buffer
 }
 
@@ -1400,15 +1538,15 @@ void update_encoder_display(void)
 //#define FORCE_UPDATE
 #ifdef FORCE_UPDATE
 	#warning FORCE UPDATE is Enabled, may impede some LED Operations
-	set_encoder_indicator(idx, indicator_value_buffer[encoder_bank][idx], encoder_settings[idx].has_detent,
+	set_encoder_indicator(idx, indicator_value_buffer[encoder_layer][idx], encoder_settings[idx].has_detent,
 	encoder_settings[idx].indicator_display_type,
 	encoder_settings[idx].detent_color);
-	set_encoder_rgb(idx, switch_color_buffer[encoder_bank][idx]);
+	set_encoder_rgb(idx, switch_color_buffer[encoder_layer][idx]);
 #endif 
 	
 	// First the indicator display
-	uint8_t currentValue = indicator_value_buffer[encoder_bank][idx];
-	uint8_t banked_encoder_idx = idx + encoder_bank*PHYSICAL_ENCODERS;				
+	uint8_t currentValue = indicator_value_buffer[encoder_layer][idx];
+	uint8_t banked_encoder_idx = idx + encoder_layer*PHYSICAL_ENCODERS;				
 	if (currentValue != prevIndicatorValue[idx]) {
 		set_encoder_indicator(idx, currentValue, encoder_settings[banked_encoder_idx].has_detent,
 								encoder_settings[banked_encoder_idx].indicator_display_type,
@@ -1417,7 +1555,7 @@ void update_encoder_display(void)
 	}
 	
 	// Next the RGB display
-	currentValue = switch_color_buffer[encoder_bank][idx];
+	currentValue = switch_color_buffer[encoder_layer][idx];
 	if (currentValue != prevSwitchColorValue[idx]) {
 		set_encoder_rgb(idx, currentValue);
 		prevSwitchColorValue[idx] = currentValue;
@@ -1432,17 +1570,17 @@ void update_encoder_display(void)
 
 	// Encoder Animation Buffer takes priority over Switch Animation Buffer if there are Conflicts
 	// - however either animation buffer can run either type of animation in reality
-	currentValue = encoder_animation_buffer[encoder_bank][idx];
+	currentValue = encoder_animation_buffer[encoder_layer][idx];
 	if (currentValue){
-		run_encoder_animation(idx, encoder_bank, currentValue, switch_color_buffer[encoder_bank][idx]);
+		run_encoder_animation(idx, encoder_layer, currentValue, switch_color_buffer[encoder_layer][idx]);
 		prevEncoderAnimationValue[idx] = currentValue;
 	} else if (prevEncoderAnimationValue[idx]) {
 		// !Summer2016Update: Reset the Indicator Display/ RGB Display as necessary
 		if (animation_is_switch_rgb(prevEncoderAnimationValue[idx])) {
-			set_encoder_rgb(idx, switch_color_buffer[encoder_bank][idx]);
+			set_encoder_rgb(idx, switch_color_buffer[encoder_layer][idx]);
 		}
 		else if (animation_is_encoder_indicator(prevEncoderAnimationValue[idx])) {
-			set_encoder_indicator(idx, indicator_value_buffer[encoder_bank][idx], encoder_settings[banked_encoder_idx].has_detent,  
+			set_encoder_indicator(idx, indicator_value_buffer[encoder_layer][idx], encoder_settings[banked_encoder_idx].has_detent,  
 					encoder_settings[banked_encoder_idx].indicator_display_type,
 					encoder_settings[banked_encoder_idx].detent_color);
 		}
@@ -1451,20 +1589,20 @@ void update_encoder_display(void)
 	}
 
 	// Run Switch Animation, or set the indicator to the last set color.
-	if (!animation_buffer_conflict_exists(encoder_bank, idx)) {  // !start here: test me! Animation buffer conflicts
+	if (!animation_buffer_conflict_exists(encoder_layer, idx)) {  // !start here: test me! Animation buffer conflicts
 		// Run The Encoder Value Display Animation
-		currentValue = switch_animation_buffer[encoder_bank][idx];
+		currentValue = switch_animation_buffer[encoder_layer][idx];
 		if (currentValue) { // !review: could make this more robust by limiting currentValue to only Encoder related animatinos 
-			run_encoder_animation(idx, encoder_bank, currentValue, switch_color_buffer[encoder_bank][idx]);
+			run_encoder_animation(idx, encoder_layer, currentValue, switch_color_buffer[encoder_layer][idx]);
 			prevSwAnimationValue[idx] = currentValue;
 		}  
 		else if (prevSwAnimationValue[idx]) {  // Animation Just Ended
 			// !Summer2016Update: Reset the Indicator Display/ RGB Display as necessary
 			if (animation_is_switch_rgb(prevSwAnimationValue[idx])) {
-				set_encoder_rgb(idx, switch_color_buffer[encoder_bank][idx]);
+				set_encoder_rgb(idx, switch_color_buffer[encoder_layer][idx]);
 			}
 			else if (animation_is_encoder_indicator(prevSwAnimationValue[idx])) {
-				set_encoder_indicator(idx, indicator_value_buffer[encoder_bank][idx], encoder_settings[banked_encoder_idx].has_detent,
+				set_encoder_indicator(idx, indicator_value_buffer[encoder_layer][idx], encoder_settings[banked_encoder_idx].has_detent,
 				encoder_settings[banked_encoder_idx].indicator_display_type,
 				encoder_settings[banked_encoder_idx].detent_color);
 			}
@@ -1477,6 +1615,23 @@ void update_encoder_display(void)
 	if(idx > 15){idx = 0;}
 }
 
+/**
+ * Returns true if update_encoder_display() has anything to draw, that is a
+ * value or color which has changed or an animation running or just ended.
+ */
+bool encoder_display_pending(void)
+{
+	for (uint8_t i=0;i<16;++i) {
+		if (indicator_value_buffer[encoder_layer][i] != prevIndicatorValue[i] ||
+		    switch_color_buffer[encoder_layer][i] != prevSwitchColorValue[i] ||
+			encoder_animation_buffer[encoder_layer][i] || prevEncoderAnimationValue[i] ||
+			switch_animation_buffer[encoder_layer][i] || prevSwAnimationValue[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  * Rebuilds the entire display, this is called when the unit powers up
  * or when changing banks.
@@ -1509,6 +1664,9 @@ void change_encoder_bank(uint8_t new_bank) // Change Bank
 		prevIndicatorValue[i] = -1;
 		prevSwitchColorValue[i] = -1;	
 		
+		// Movement part way through a fine step belongs to the old bank
+		clear_fine_adjust(i);
+		
 		// Read in all the encoder settings for the current bank
 		// - !Summer2016Update: Removed in favor of expanding encoder_settings to include all banks 
 		//~ get_encoder_config(new_bank, i, &encoder_settings[i]);  
@@ -1529,6 +1687,92 @@ void change_encoder_bank(uint8_t new_bank) // Change Bank
 	} 
 	
 	encoder_bank = new_bank;                                                 
+	
+	// A held shift page stays on display, the bank is shown once it is released
+	if (encoder_layer < NUM_BANKS) {
+		encoder_layer = new_bank;
+	}
+	
+	// Side switches follow the bank
+	set_side_switch_layer(new_bank);
+}
+
+/**
+ * Moves the encoders on to another layer. Only the indicators whose display
+ * settings differ between the two layers are forced to redraw, the rest
+ * redraw as their values differ.
+ * 
+ * \param layer [in]	A bank, or NUM_BANKS + the shift page
+ */
+static void set_encoder_layer(uint8_t layer)
+{
+	for (uint8_t i=0;i<16;++i) {
+		uint8_t old_idx = encoder_layer*PHYSICAL_ENCODERS + i;
+		uint8_t new_idx = layer*PHYSICAL_ENCODERS + i;
+		
+		if (encoder_settings[old_idx].has_detent != encoder_settings[new_idx].has_detent ||
+			encoder_settings[old_idx].indicator_display_type != encoder_settings[new_idx].indicator_display_type ||
+			encoder_settings[old_idx].detent_color != encoder_settings[new_idx].detent_color) {
+			prevIndicatorValue[i] = -1;
+		}
+		
+		// Movement part way through a detent or fine step belongs to the old layer
+		encoder_detent_counter[i] = 0;
+		clear_fine_adjust(i);
+	}
+	
+	encoder_layer = layer;
+}
+
+/**
+ * Shows and plays a shift page on the encoders until exit_shift_page() is
+ * called. The shift page encoders work like those of a bank, with their own
+ * MIDI settings, values and colors.
+ * 
+ * \param page [in]	0, 1 Which shift page is being accessed
+ */
+void enter_shift_page(uint8_t page)
+{
+	if (page < SHIFT_PAGES) {
+		set_encoder_layer(NUM_BANKS + page);
+	}
+}
+
+/**
+ * Returns the encoders to the current bank after enter_shift_page()
+ */
+void exit_shift_page(void)
+{
+	set_encoder_layer(encoder_bank);
+}
+
+/**
+ * Sets an encoder in the current bank to a value and sends its MIDI, as if
+ * it had been turned there.
+ * 
+ * \param encoder [in]	The encoder (0 - 15)
+ * 
+ * \param value [in]	The new 7 bit value
+ */
+void set_encoder_value(uint8_t encoder, uint8_t value)
+{
+	bool shifted = encoder_is_in_shift_state(encoder_bank, encoder);
+	uint8_t virtual_encoder_id = get_virtual_encoder_id(encoder_bank, encoder);
+	
+	raw_encoder_value[virtual_encoder_id] = (int16_t)value * 100;
+	indicator_value_buffer[encoder_bank][encoder] = value;
+	
+	send_encoder_midi(encoder_bank*16 + encoder, value, true, shifted);
+}
+
+/**
+ * Returns the 7 bit value of an encoder in the current bank
+ * 
+ * \param encoder [in]	The encoder (0 - 15)
+ */
+uint8_t read_encoder_value(uint8_t encoder)
+{
+	return scale_encoder_value(raw_encoder_value[get_virtual_encoder_id(encoder_bank, encoder)]);
 }
 
 /**
@@ -1611,6 +1855,10 @@ bool color_overide_active(uint8_t bank, uint8_t encoder)
  */
 bool encoder_is_in_shift_state(uint8_t bank, uint8_t encoder)
 {
+	// Shift page encoders have no shifted value of their own
+	if (bank >= NUM_BANKS) {
+		return false;
+	}
 	uint8_t banked_encoder_idx = encoder + bank*PHYSICAL_ENCODERS;				
 	uint16_t bit = 0x0001 << encoder;
 	/*if ((encoder_settings[encoder].switch_action_type == ENC_SHIFT_HOLD ||
@@ -1624,10 +1872,10 @@ bool encoder_is_in_shift_state(uint8_t bank, uint8_t encoder)
 		return false;
 	}
 }
-// This function assumes bank == current bank
+// This function assumes bank == current layer
 bool encoder_midi_type_is_relative(uint8_t encoder) 
 {
-	uint8_t banked_encoder_idx = encoder + encoder_bank*PHYSICAL_ENCODERS;				
+	uint8_t banked_encoder_idx = encoder + encoder_layer*PHYSICAL_ENCODERS;				
 	if (encoder_settings[banked_encoder_idx].encoder_midi_type == SEND_REL_ENC){
 		return true;
 	}
@@ -29,6 +29,7 @@
 		#include <midi.h>
 		#include <input.h>
 		#include <config.h>
+		#include <constants.h>
 		
 	/*	Macros: */
 
@@ -37,6 +38,10 @@
 	#define BANKED_ENCODERS 64 // essentially virtual encoders but not including 'shifted' encoders.
 	#define BANKED_ENCODER_MASK 0x3F // For Determining banked encoder id from the virtual encoder id
 	#define VIRTUAL_ENCODERS 128  // Twister Firmware supports 4 Banks of 16 Encoders, each containing a virtual shift encoder (4x16x2=128)
+	#define SHIFT_PAGES 2 // The shift pages are layers of 16 encoders which follow the banks
+	#define NUM_LAYERS (NUM_BANKS + SHIFT_PAGES)
+	#define LAYER_ENCODERS (NUM_LAYERS * PHYSICAL_ENCODERS) // The banked encoders followed by the shift page encoders
+	#define FINE_ADJUST_SHIFT_MAX 6 // Fine adjust divides steps by at most 2^6
 
 	/*	Types: */
 	
@@ -63,6 +68,7 @@
 			SW_UP,
 			SW_DOWN,
 			SW_HELD,
+			SW_REPEAT,
 		} switch_event_t;
 
 		// Encoder Switch MIDI Type Enum
@@ -125,10 +131,10 @@
 		
 		/* Variables */
 		
-		extern uint8_t indicator_value_buffer[4][16];
+		extern uint8_t indicator_value_buffer[NUM_LAYERS][16];
 		//static encoder_config_t encoder_settings[16];
 		//static encoder_config_t encoder_settings[64];
-		extern encoder_config_t encoder_settings[64];
+		extern encoder_config_t encoder_settings[LAYER_ENCODERS];
 		// - overall, the use of input_map over an enlarged encoder_settings saves about 236 Bytes of RAM (624->960)
 		// -- But logically, the use of encoder_settings is a much simpler and faster implementation
 
@@ -138,10 +144,15 @@
 		void factory_reset_encoder_config(void);
 		
 		void encoders_init(void);
+		void set_fine_adjust_shift(uint8_t shift);
+		uint8_t get_fine_adjust_shift(void);
 		void process_encoder_input(void);
 		void update_encoder_display(void);
+		bool encoder_display_pending(void);
 		void change_encoder_bank(uint8_t new_bank);
 		uint8_t current_encoder_bank(void);
+		void set_encoder_value(uint8_t encoder, uint8_t value);
+		uint8_t read_encoder_value(uint8_t encoder);
 		void refresh_display(void);
 		
 		void process_element_midi(uint8_t channel, uint8_t type, uint8_t number, uint8_t value, uint8_t state);
@@ -154,7 +165,8 @@
 		void process_encoder_animation_update(uint8_t idx, uint8_t value);
 		void process_shift_update(uint8_t idx, uint8_t value);
 		
-		void run_shift_mode(uint8_t page);
+		void enter_shift_page(uint8_t page);
+		void exit_shift_page(void);
 		
 		uint8_t scale_encoder_value(int16_t value);
 		int16_t clamp_encoder_raw_value(int16_t value);
@@ -0,0 +1,172 @@
+/*
+ * gestures.c
+ *
+ * Created: 10/18/2026 10:12:31 AM
+ *
+ *  Gesture recognition for the encoder and side switches. Each switch runs
+ *  a small state machine driven by the de-bounced switch state and the 
+ *  ms timer, which turns presses into taps, double taps, long presses and 
+ *  hold-and-turns. The switch edge handling elsewhere is not affected, 
+ *  gestures are carried out in addition to it. Each gesture type is mapped
+ *  to a MIDI message or a macro, see gesture_action_t. Gestures work in
+ *  the banks and on the shift pages alike.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gestures.h>
+#include <config.h>
+#include <macros.h>
+
+// Per switch recognizer states
+typedef enum {
+	GESTURE_IDLE,
+	GESTURE_PRESSED,        // First press, waiting for release, hold or turn
+	GESTURE_RELEASED,       // Short press released, waiting for a second press
+	GESTURE_SPENT,          // Gesture sent, waiting for the switch to be released
+} gesture_state_t;
+
+typedef struct {
+	uint8_t  state;
+	uint16_t timestamp;     // Low 16 bits of the ms timer at the last transition
+	uint16_t enc_total;     // Encoder step total when the switch was pressed
+} gesture_tracker_t;
+
+// Holds all configurable gesture settings
+static gesture_settings_t gesture_cfg;
+
+static gesture_tracker_t gesture_tracker[GESTURE_NUM_SWITCHES];
+
+static void gesture_event(uint8_t switch_idx, gesture_t gesture);
+
+void gestures_init(void)
+{
+	memset(gesture_tracker, 0x00, sizeof(gesture_tracker));
+}
+
+void gesture_config(gesture_settings_t *settings)
+{
+	gesture_cfg.double_tap_time = settings->double_tap_time;
+	gesture_cfg.long_press_time = settings->long_press_time;
+	gesture_cfg.turn_steps      = settings->turn_steps;
+	gesture_cfg.send_midi       = settings->send_midi;
+	gesture_cfg.channel         = settings->channel;
+	
+	memcpy(gesture_cfg.action, settings->action, sizeof(gesture_cfg.action));
+	memcpy(gesture_cfg.number, settings->number, sizeof(gesture_cfg.number));
+}
+
+gesture_settings_t* get_gesture_config(void)
+{
+	return &gesture_cfg;
+}
+
+/**
+ * Advances the gesture state machine of every switch by one step. This 
+ * should be called once per main loop after the switch states have been 
+ * updated, the time taken is fixed by the number of switches.
+ */
+
+void process_gestures(void)
+{
+	uint16_t now = (uint16_t)get_ms_timer();
+	uint16_t double_tap_ms = gesture_cfg.double_tap_time * GESTURE_TIME_UNIT_MS;
+	uint16_t long_press_ms = gesture_cfg.long_press_time * GESTURE_TIME_UNIT_MS;
+	
+	uint32_t switch_state = ((uint32_t)get_side_switch_state() << GESTURE_FIRST_SIDE_SWITCH) 
+							| get_enc_switch_state();
+	
+	for (uint8_t i = 0; i < GESTURE_NUM_SWITCHES; ++i) {
+		
+		gesture_tracker_t* tracker = &gesture_tracker[i];
+		bool pressed = (switch_state >> i) & 0x01;
+		uint16_t elapsed = now - tracker->timestamp;
+		
+		switch (tracker->state) {
+			case GESTURE_IDLE:{
+				if (pressed) {
+					tracker->state = GESTURE_PRESSED;
+					tracker->timestamp = now;
+					if (i < GESTURE_FIRST_SIDE_SWITCH) {
+						tracker->enc_total = get_encoder_total(i);
+					}
+				}
+			}
+			break;
+			case GESTURE_PRESSED:{
+				if (!pressed) {
+					tracker->state = GESTURE_RELEASED;
+					tracker->timestamp = now;
+				} else if (i < GESTURE_FIRST_SIDE_SWITCH &&
+				           abs((int16_t)(get_encoder_total(i) - tracker->enc_total)) >= gesture_cfg.turn_steps) {
+					gesture_event(i, GESTURE_HOLD_TURN);
+					tracker->state = GESTURE_SPENT;
+				} else if (elapsed >= long_press_ms) {
+					gesture_event(i, GESTURE_LONG_PRESS);
+					tracker->state = GESTURE_SPENT;
+				}
+			}
+			break;
+			case GESTURE_RELEASED:{
+				if (pressed) {
+					gesture_event(i, GESTURE_DOUBLE_TAP);
+					tracker->state = GESTURE_SPENT;
+				} else if (elapsed >= double_tap_ms) {
+					gesture_event(i, GESTURE_TAP);
+					tracker->state = GESTURE_IDLE;
+				}
+			}
+			break;
+			case GESTURE_SPENT:{
+				if (!pressed) {
+					tracker->state = GESTURE_IDLE;
+				}
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * Carries out what a completed gesture is mapped to.
+ */
+
+static void gesture_event(uint8_t switch_idx, gesture_t gesture)
+{
+	uint8_t channel = gesture_cfg.channel;
+	uint8_t number  = (gesture_cfg.number[gesture] + switch_idx) & 0x7F;
+	
+	switch (gesture_cfg.action[gesture]) {
+		case GESTURE_ACTION_CC:{
+			midi_stream_raw_cc(channel, number, 127);
+		} break;
+		case GESTURE_ACTION_NOTE:{
+			midi_stream_raw_note(channel, number, true, 127);
+			midi_stream_raw_note(channel, number, false, 0);
+		} break;
+		case GESTURE_ACTION_MACRO:{
+			start_macro(gesture_cfg.number[gesture]);
+		} break;
+		case GESTURE_ACTION_NONE:
+		break;
+		default:{
+			// The CC number is the switch index and the value the gesture type
+			if (gesture_cfg.send_midi) {
+				midi_stream_raw_cc(channel, switch_idx, gesture);
+			}
+		} break;
+	}
+}
@@ -0,0 +1,82 @@
+/*
+ * gestures.h
+ *
+ * Created: 10/18/2026 10:12:31 AM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef GESTURES_H_
+#define GESTURES_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		#include <input.h>
+		
+	/*	Macros: */
+	
+		// Gestures are tracked for the 16 encoder switches followed by the 
+		// 6 side switches
+		#define GESTURE_NUM_SWITCHES       22
+		#define GESTURE_FIRST_SIDE_SWITCH  16
+		
+		// Gesture times are set in 10 mS units
+		#define GESTURE_TIME_UNIT_MS       10
+
+	/*	Types: */
+	
+		typedef enum gesture {
+			GESTURE_NONE,
+			GESTURE_TAP,		 // Short press and release, no second press followed
+			GESTURE_DOUBLE_TAP,  // Second press within the double tap time
+			GESTURE_LONG_PRESS,  // Held for the long press time without turning
+			GESTURE_HOLD_TURN,   // Encoder turned while its switch is held
+			GESTURE_COUNT,
+		} gesture_t;
+		
+		// What each gesture is mapped to. The CC and note numbers are the
+		// gesture's number plus the switch index, so every switch sends its
+		// own message
+		typedef enum gesture_action {
+			GESTURE_ACTION_DEFAULT,  // CC switch index = gesture, if send_midi is set
+			GESTURE_ACTION_NONE,	 // Nothing
+			GESTURE_ACTION_CC,		 // CC number + switch index = 127
+			GESTURE_ACTION_NOTE,	 // Note number + switch index, on then off
+			GESTURE_ACTION_MACRO,	 // Start macro number
+			GESTURE_ACTION_COUNT,
+		} gesture_action_t;
+		
+		// Structure which holds the gesture settings
+		typedef struct {
+			uint8_t double_tap_time;  // Longest gap between two taps, 10 mS units
+			uint8_t long_press_time;  // Shortest hold for a long press, 10 mS units
+			uint8_t turn_steps;		  // Encoder steps needed for a hold and turn
+			bool    send_midi;        // Send unmapped gestures as a CC
+			uint8_t channel;		  // MIDI channel of the gesture messages
+			uint8_t action[GESTURE_COUNT];  // gesture_action_t of each gesture
+			uint8_t number[GESTURE_COUNT];  // Its CC, note or macro number
+		} gesture_settings_t;
+
+	/* Function Prototypes: */
+	
+		void gestures_init(void);
+		void gesture_config(gesture_settings_t *settings);
+		gesture_settings_t* get_gesture_config(void);
+		
+		void process_gestures(void);
+
+#endif /* GESTURES_H_ */
@@ -23,12 +23,42 @@
  */
 
 #include <input.h>
+#include <scheduler.h>
+#include <profiler.h>
+#include <watchdog.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
-static uint32_t ms_timer;
+static volatile uint32_t ms_timer;
+
+// Timer 1 count at the previous scan and the microseconds not yet added to
+// ms_timer, used to keep ms_timer running at a constant rate whatever the
+// current scan rate is.
+static uint16_t last_scan_count;
+static uint16_t ms_timer_us_remainder;
+
+// Timer 1 ticks since the last switch sample / inactivity update
+static uint16_t slow_tick_count;
+
+// Scan rate and load statistics, see input_diagnostics_t
+static input_diagnostics_t input_diagnostics;
+static uint16_t load_busy_ticks;
+static uint16_t load_window_ticks;
+
+// Raw input capture ring buffer, a new sample is added whenever any raw 
+// input differs from the previous scan. capture_head is the next slot to 
+// be written.
+static input_sample_t input_capture[INPUT_CAPTURE_SIZE];
+static uint8_t  capture_head;
+static uint8_t  capture_count;
+static uint16_t capture_ticks;
+static bool     capture_enabled;
+static uint16_t capture_prev_enc_switch;
+static uint8_t  capture_prev_side_switch;
+
+static uint8_t read_side_switch_pins(void);
 
 // Buffers used to debounce the switch states;
 uint16_t enc_switch_debounce_buffer[SWITCH_DEBOUNCE_BUFFER_SIZE];
@@ -50,8 +80,15 @@ uint16_t g_enc_switch_down;
 uint8_t  g_side_switch_up;
 uint8_t  g_side_switch_down;
 
-// The relative movement of the 16 encoders
-int8_t  encoder_state[16];
+// Switches held through a combo, their edges are hidden until released
+uint16_t g_enc_switch_suppressed;
+uint8_t  g_side_switch_suppressed;
+
+// Running step totals for the 16 encoders. These are only ever written by
+// encoder_scan(), the main loop works out the movement by comparing them
+// against the totals it saw last time in encoder_state_read.
+static volatile uint16_t encoder_state[16];
+static uint16_t encoder_state_read[16];
 
 // The previous encoder pin states
 uint16_t encoder_cha_state_prev = 0;
@@ -60,7 +97,10 @@ uint16_t encoder_chb_state_prev = 0;
 // The encoder inactivity counter
 uint8_t encoder_inactive_counter[16];
 
-static uint16_t timer_cca_value = 125;
+// Edge statistics for each encoder, written by encoder_scan()
+static encoder_health_t encoder_health[16];
+
+static uint16_t timer_cca_value = INPUT_SCAN_RATE;
 static uint16_t timer_ccb_value = 0;
 
 void do_task(void);
@@ -109,7 +149,8 @@ void input_init(void)
 	ioport_set_pin_level(ENC_CLK, false); 
 	
 	//Clear out the state variables
-	memset(encoder_state, 0x00, 16);
+	memset((void*)encoder_state, 0x00, sizeof(encoder_state));
+	memset(encoder_state_read, 0x00, sizeof(encoder_state_read));
 	
 	g_enc_prev_switch_state  = 0;
 	g_enc_switch_state		 = 0;
@@ -120,19 +161,22 @@ void input_init(void)
 	g_side_prev_switch_state = 0;
 	g_side_switch_up		 = 0;
 	g_side_switch_down       = 0;
+	
+	g_enc_switch_suppressed  = 0;
+	g_side_switch_suppressed = 0;
 
 
 	// Timer Initialization ---------------------------------------------------
 	
 	/** The Input Driver uses timer counter compare A interrupt to ensure the 
 	 *	inputs are scanned every 1.28 ms. (1/32x10^6) x 1024 x 40
+	 *  While any encoder is turning the scan rate is raised to 
+	 *  INPUT_SCAN_RATE_BURST so fast spins don't skip quadrature states.
 	 *  To support the timing requirements of the sequencer and other functions
 	 *  access to the second CC channel is provided, allowing scheduling of
 	 *  events.
 	 */
 	
-	#define INPUT_SCAN_RATE 40
-	
 	// Enable Timer 1 
 	tc_enable(&TCC1);
 	// Set Timer 1 overflow callback to display_frame_timer()
@@ -152,6 +196,17 @@ void input_init(void)
 	tc_write_clock_source(&TCC1, TC_CLKSEL_DIV1024_gc);
 	
 	ms_timer = 0;
+	ms_timer_us_remainder = 0;
+	last_scan_count = 0;
+	slow_tick_count = 0;
+	
+	memset(&input_diagnostics, 0x00, sizeof(input_diagnostics));
+	memset(encoder_health, 0x00, sizeof(encoder_health));
+	load_busy_ticks = 0;
+	load_window_ticks = 0;
+	
+	clear_input_capture();
+	capture_enabled = true;
 	
 	ioport_set_pin_dir(DEBUG_PIN, IOPORT_DIR_OUTPUT);
 }
@@ -170,7 +225,9 @@ void do_task(void)
 {
 	tc_set_ccb_interrupt_level(&TCC1, TC_INT_LVL_OFF);
 	task_is_scheduled = false;
+	uint16_t profile_start = profile_timestamp();
 	scheduled_task();
+	profile_record(PROFILE_ISR_DO_TASK, profile_start);
 }
 
 /**
@@ -215,31 +272,180 @@ bool cancel_task() // !review: this is set to 'bool' but returns nothing
 
 
 /**
- * Returns a 32 bit counter, this counter is incremented ever 1ms by the input
- * scan routine. This is NOT accurate (CLK is +/- 1.5%)
+ * Returns a 32 bit millisecond counter. The count is kept by the input scan 
+ * routine from the free running Timer 1 count so it stays correct whatever
+ * rate the inputs are being scanned at. This is NOT accurate (CLK is +/- 1.5%)
  *
  * \return ms_timer value
  */
 
 uint32_t get_ms_timer(void)
 {
-	return ms_timer;
+	uint32_t ms;
+	
+	// The 32 bit read is not atomic, re-read if the scan ISR got in between
+	do {
+		ms = ms_timer;
+	} while (ms != ms_timer);
+	
+	return ms;
+}
+
+/**
+ * Returns the input scan statistics. The counters wrap, callers should 
+ * difference successive readings or clear them with 
+ * clear_input_diagnostics().
+ *
+ * \return pointer to the input diagnostics structure
+ */
+
+const input_diagnostics_t* get_input_diagnostics(void)
+{
+	return &input_diagnostics;
+}
+
+void clear_input_diagnostics(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	
+	input_diagnostics.missed_edges = 0;
+	input_diagnostics.burst_scans = 0;
+	input_diagnostics.idle_scans = 0;
+	input_diagnostics.max_scan_ticks = 0;
+	
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Copies the edge statistics of one encoder.
+ *
+ * \param encoder [in]	The encoder index, 0 - 15
+ *
+ * \param health [out]	Receives the statistics
+ */
+
+void get_encoder_health(uint8_t encoder, encoder_health_t* health)
+{
+	irqflags_t flags = cpu_irq_save();
+	*health = encoder_health[encoder & 0x0F];
+	cpu_irq_restore(flags);
+}
+
+void clear_encoder_health(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	
+	for (uint8_t i=0;i<16;++i) {
+		encoder_health[i].edges_a = 0;
+		encoder_health[i].edges_b = 0;
+		encoder_health[i].illegal = 0;
+		encoder_health[i].reversals = 0;
+		encoder_health[i].last_edge_a = ms_timer;
+		encoder_health[i].last_edge_b = ms_timer;
+		encoder_health[i].last_step = 0;
+	}
+	
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Empties the raw input capture buffer. The first sample captured after 
+ * this is timed from the moment the buffer was cleared.
+ */
+
+void clear_input_capture(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	
+	capture_head = 0;
+	capture_count = 0;
+	capture_ticks = 0;
+	capture_prev_enc_switch = 0;
+	capture_prev_side_switch = 0;
+	
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Stops or restarts raw input capture, capture should be stopped while the
+ * buffer is being read out so it holds still.
+ */
+
+void enable_input_capture(bool enable)
+{
+	capture_enabled = enable;
+}
+
+uint8_t get_input_capture_count(void)
+{
+	return capture_count;
+}
+
+/**
+ * Copies a sample out of the raw input capture buffer.
+ *
+ * \param [in] idx		Index of the sample, 0 is the oldest sample held
+ *
+ * \param [out] sample	Where to copy the sample to
+ *
+ * \return true if idx was in range
+ */
+
+bool get_input_capture_sample(uint8_t idx, input_sample_t* sample)
+{
+	bool valid = false;
+	
+	irqflags_t flags = cpu_irq_save();
+	
+	if (idx < capture_count) {
+		uint8_t oldest = (capture_head + INPUT_CAPTURE_SIZE - capture_count) % INPUT_CAPTURE_SIZE;
+		*sample = input_capture[(oldest + idx) % INPUT_CAPTURE_SIZE];
+		valid = true;
+	}
+	
+	cpu_irq_restore(flags);
+	
+	return valid;
 }
 
 /*	
  *  encoder_scan scans the encoder pins and converts any pin state changes to 
  *  relative movements which are stored in the encoder_state array.
+ *
+ *  The scan runs every INPUT_SCAN_RATE_BURST timer ticks while any encoder
+ *  has moved within the inactivity threshold and every INPUT_SCAN_RATE 
+ *  ticks otherwise. Switch de-bouncing and the inactivity counters always
+ *  advance once per INPUT_SCAN_RATE ticks so their timing does not depend
+ *  on the scan rate.
  */
 static uint8_t enc_switch_buffer_pos = 0;
 
 void encoder_scan(void)
 {
-	// Increment the timer compare value
-	timer_cca_value += INPUT_SCAN_RATE;
-	tc_write_cc(&TCC1, TC_CCA, timer_cca_value);
+	uint16_t profile_start = profile_timestamp();
+	uint16_t scan_start = tc_read_count(&TCC1);
+	uint16_t elapsed = scan_start - last_scan_count;
+	last_scan_count = scan_start;
+	
+	// Advance the ms_timer by the time since the last scan
+	uint32_t elapsed_us = ms_timer_us_remainder + (uint32_t)elapsed * INPUT_TIMER_TICK_US;
+	while (elapsed_us >= 1000) {
+		elapsed_us -= 1000;
+		ms_timer++;
+	}
+	ms_timer_us_remainder = elapsed_us;
 	
-	// Increment the ms_timer count
-	ms_timer++;
+	// Switch samples and inactivity are counted at the idle scan rate
+	bool slow_tick = false;
+	slow_tick_count += elapsed;
+	if (slow_tick_count >= INPUT_SCAN_RATE) {
+		slow_tick_count -= INPUT_SCAN_RATE;
+		if (slow_tick_count >= INPUT_SCAN_RATE) {
+			// Don't try to catch up after the scan has been held off
+			slow_tick_count = 0;
+		}
+		slow_tick = true;
+	}
 	
 	// Latch the encoder data into the shift registers, latching data also 
 	// presents first bit to ENC_DATA so no need to clk in the first bit
@@ -259,8 +465,10 @@ void encoder_scan(void)
 	
 	// Add the current state to the circular debounce buffer, and increment the 
 	// buffer pos.
-	enc_switch_debounce_buffer[enc_switch_buffer_pos] = current_enc_switch_state;
-	enc_switch_buffer_pos = (enc_switch_buffer_pos + 1) % SWITCH_DEBOUNCE_BUFFER_SIZE;
+	if (slow_tick) {
+		enc_switch_debounce_buffer[enc_switch_buffer_pos] = current_enc_switch_state;
+		enc_switch_buffer_pos = (enc_switch_buffer_pos + 1) % SWITCH_DEBOUNCE_BUFFER_SIZE;
+	}
 
 	uint16_t encoder_cha_state = 0;
 	uint16_t encoder_chb_state = 0;
@@ -280,84 +488,232 @@ void encoder_scan(void)
 	// Leave the encoder register latch low now we are done reading
 	ioport_set_pin_level(ENC_LATCH, false);
 	
+	// Record the raw inputs if anything has changed since the last scan
+	if (capture_enabled) {
+		uint8_t side_switch_state = read_side_switch_pins();
+		uint32_t ticks = (uint32_t)capture_ticks + elapsed;
+		capture_ticks = ticks > UINT16_MAX ? UINT16_MAX : ticks;
+		
+		if (current_enc_switch_state != capture_prev_enc_switch ||
+		    encoder_cha_state != encoder_cha_state_prev ||
+		    encoder_chb_state != encoder_chb_state_prev ||
+		    side_switch_state != capture_prev_side_switch) {
+				
+			input_sample_t* sample = &input_capture[capture_head];
+			sample->ticks       = capture_ticks;
+			sample->enc_switch  = current_enc_switch_state;
+			sample->cha         = encoder_cha_state;
+			sample->chb         = encoder_chb_state;
+			sample->side_switch = side_switch_state;
+			
+			capture_head = (capture_head + 1) % INPUT_CAPTURE_SIZE;
+			if (capture_count < INPUT_CAPTURE_SIZE) {
+				capture_count++;
+			}
+			capture_ticks = 0;
+			capture_prev_enc_switch = current_enc_switch_state;
+			capture_prev_side_switch = side_switch_state;
+		}
+	}
+	
 	// Process the encoder channel state data
+	bool any_active = false;
 	bit = 0x00001;
 	for (uint8_t i = 0; i < 16;++i) {
 		
-		if((encoder_cha_state & bit) != (encoder_cha_state_prev & bit)) {	
+		bool cha_changed = (encoder_cha_state & bit) != (encoder_cha_state_prev & bit);
+		bool chb_changed = (encoder_chb_state & bit) != (encoder_chb_state_prev & bit);
+		encoder_health_t* health = &encoder_health[i];
+		
+		if (cha_changed && health->edges_a != 0xFFFF) health->edges_a++;
+		if (chb_changed && health->edges_b != 0xFFFF) health->edges_b++;
+		
+		if(cha_changed) {	
 		// First check to see if Channel A has changed.
+			int8_t step;
+		
+			if (chb_changed) {
+			// Both channels changing means a state was skipped since the 
+			// last scan, the direction can't be known
+				input_diagnostics.missed_edges++;
+				if (health->illegal != 0xFFFF) health->illegal++;
+			}
 		
 			if ((encoder_cha_state & bit) && !(encoder_cha_state_prev & bit)) {
 			// If rising edge on A
 				if (encoder_chb_state & bit) {
 				// And B is currently high
-					encoder_state[i]--;
+					step = -1;
 				} else {
 				// or B is low
-					encoder_state[i]++;
+					step = 1;
 				}
 			} else {
 			// else it was a falling edge on A
 				if (encoder_chb_state & bit) {
 				// And B is currently high
-					encoder_state[i]++;
+					step = 1;
 				} else {
 				// or B is low
-					encoder_state[i]--;
+					step = -1;
 				}
 			}
 			
+			encoder_state[i] += step;
+			
+			// A direction change straight after the previous step is jitter,
+			// not the user turning back
+			if (!chb_changed) {
+				if (step != health->last_step &&
+				    ms_timer - max(health->last_edge_a, health->last_edge_b) < ENCODER_REVERSAL_MS &&
+					health->reversals != 0xFFFF) {
+					health->reversals++;
+				}
+				health->last_step = step;
+			} else {
+				health->last_edge_b = ms_timer;
+			}
+			health->last_edge_a = ms_timer;
+			
 			//Reset inactivity counter
 			encoder_inactive_counter[i] = 0;
 			
-		} else if ((encoder_chb_state & bit) != (encoder_chb_state_prev & bit)) {
+		} else if (chb_changed) {
 		// if Channel A didn't change check to see if Channel B did
+			int8_t step;
 		
 			if ((encoder_chb_state & bit) && !(encoder_chb_state_prev & bit)) {
 			// If rising Edge on B
 				if (encoder_cha_state & bit) {
 				// and A is currently high
-					encoder_state[i]++;
+					step = 1;
 				} else {
 				// or A is low
-					encoder_state[i]--;
+					step = -1;
 				}
 			} else {
 			// else it was a falling edge on B
 				if (encoder_cha_state & bit){
 				// and A is currently high
-					encoder_state[i]--;
+					step = -1;
 				} else {
 				// or A is low
-					encoder_state[i]++;
+					step = 1;
 				}
 			}
 			
+			encoder_state[i] += step;
+			
+			if (step != health->last_step &&
+			    ms_timer - max(health->last_edge_a, health->last_edge_b) < ENCODER_REVERSAL_MS &&
+				health->reversals != 0xFFFF) {
+				health->reversals++;
+			}
+			health->last_step = step;
+			health->last_edge_b = ms_timer;
+			
 			//Reset inactivity counter
 			encoder_inactive_counter[i] = 0;
 			
-		} else {
+		} else if (slow_tick) {
 		// neither channel changed so increment the time since last update
 			if ( encoder_inactive_counter[i] < ENCODER_INACTIVE_THRESHOLD ){
 				encoder_inactive_counter[i]++;
 			}	
 		}
+		
+		if (encoder_inactive_counter[i] < ENCODER_INACTIVE_THRESHOLD) {
+			any_active = true;
+		}
 		bit <<= 1;
 	}
 	
 	// Store current state for future comparisons
 	encoder_cha_state_prev = encoder_cha_state;
 	encoder_chb_state_prev = encoder_chb_state;
+	
+	// Let the main loop process the new input
+	scheduler_set_ready(TASK_INPUT);
+	
+	// Schedule the next scan, burst while anything is turning. If this scan
+	// was held off past the next compare point re-base on the current count
+	// rather than waiting for the timer to wrap.
+	uint8_t scan_rate;
+	if (any_active) {
+		scan_rate = INPUT_SCAN_RATE_BURST;
+		input_diagnostics.burst_scans++;
+	} else {
+		scan_rate = INPUT_SCAN_RATE;
+		input_diagnostics.idle_scans++;
+	}
+	
+	uint16_t scan_end = tc_read_count(&TCC1);
+	
+	timer_cca_value += scan_rate;
+	if ((int16_t)(timer_cca_value - scan_end) <= 0) {
+		timer_cca_value = scan_end + scan_rate;
+	}
+	tc_write_cc(&TCC1, TC_CCA, timer_cca_value);
+	
+	// Track the time spent scanning. The 32 uS timer resolution is coarse
+	// compared to a scan but the error averages out over the window.
+	uint16_t scan_ticks = scan_end - scan_start;
+	if (scan_ticks > input_diagnostics.max_scan_ticks) {
+		input_diagnostics.max_scan_ticks = scan_ticks;
+	}
+	load_busy_ticks += scan_ticks;
+	load_window_ticks += elapsed;
+	if (load_window_ticks >= INPUT_LOAD_WINDOW) {
+		input_diagnostics.isr_load = ((uint32_t)load_busy_ticks * 1000) / load_window_ticks;
+		load_busy_ticks = 0;
+		load_window_ticks = 0;
+	}
+	
+	heartbeat(HEARTBEAT_INPUT);
+	
+	profile_record(PROFILE_ISR_ENCODER_SCAN, profile_start);
+}
+
+/**
+ * Returns the running step total for an encoder. This wraps and only the
+ * difference between two readings has any meaning, it is not affected by
+ * calls to get_encoder_value(). As a 16 bit read is two instructions on the
+ * AVR the total is read until two reads agree, the scan ISR can't run twice
+ * within that window.
+ */
+uint16_t get_encoder_total(uint8_t encoder)
+{
+	uint16_t total;
+	
+	do {
+		total = encoder_state[encoder];
+	} while (total != encoder_state[encoder]);
+	
+	return total;
 }
 
 /**
  * Returns number of encoder steps since last time this function was called
+ *
+ * The ISR only ever adds to the running total so nothing it does between our
+ * read and the update of encoder_state_read can be lost. Movement larger than
+ * an int8_t can hold is returned over successive calls rather than wrapping. 
  */
 int8_t get_encoder_value(uint8_t encoder)
 {
-	int8_t return_value = encoder_state[encoder];
-	encoder_state[encoder] = 0;
-	return return_value;
+	uint16_t total = get_encoder_total(encoder);
+	
+	int16_t steps = (int16_t)(total - encoder_state_read[encoder]);
+	
+	if (steps > INT8_MAX) {
+		steps = INT8_MAX;
+	} else if (steps < INT8_MIN) {
+		steps = INT8_MIN;
+	}
+	
+	encoder_state_read[encoder] += steps;
+	
+	return (int8_t)steps;
 }
 
 
@@ -380,6 +736,10 @@ uint16_t update_encoder_switch_state(void)
 	g_enc_switch_up = (g_enc_prev_switch_state ^ g_enc_switch_state) & g_enc_prev_switch_state;
 	// If a bit has changed and it was 1 in the previous state, it's a KeyDown.
 	g_enc_switch_down = (g_enc_prev_switch_state ^ g_enc_switch_state) & g_enc_switch_state;
+	// Hide the edges of suppressed switches, including their release
+	g_enc_switch_up   &= ~g_enc_switch_suppressed;
+	g_enc_switch_down &= ~g_enc_switch_suppressed;
+	g_enc_switch_suppressed &= g_enc_switch_state;
 	// Demote the current state to history.
 	g_enc_prev_switch_state = g_enc_switch_state;
 	
@@ -408,7 +768,12 @@ uint16_t get_enc_switch_up(void)
 
 static uint8_t side_switch_buffer_pos = 0;
 
-uint16_t update_side_switch_state(void)
+/**
+ * Reads the side switch pins and returns the raw (not de-bounced) state,
+ * if a bit is set the switch is closed.
+ */
+
+static uint8_t read_side_switch_pins(void)
 {
 	uint8_t current_side_switch_state = 0;
 	uint8_t bit   = 0x0001;
@@ -441,6 +806,13 @@ uint16_t update_side_switch_state(void)
 		current_side_switch_state |= bit;
 	} 
 	
+	return current_side_switch_state;
+}
+
+uint16_t update_side_switch_state(void)
+{
+	uint8_t current_side_switch_state = read_side_switch_pins();
+	
 	// Add the current state to the de-bounce buffer
 	side_switch_debounce_buffer[side_switch_buffer_pos] = current_side_switch_state;
 	side_switch_buffer_pos = (side_switch_buffer_pos + 1) % SWITCH_DEBOUNCE_BUFFER_SIZE;
@@ -458,6 +830,10 @@ uint16_t update_side_switch_state(void)
 	g_side_switch_up = (g_side_prev_switch_state ^ g_side_switch_state) & g_side_prev_switch_state;
 	// If a bit has changed and it was 1 in the previous state, it's a KeyUp.
 	g_side_switch_down = (g_side_prev_switch_state ^ g_side_switch_state) & g_side_switch_state;
+	// Hide the edges of suppressed switches, including their release
+	g_side_switch_up   &= ~g_side_switch_suppressed;
+	g_side_switch_down &= ~g_side_switch_suppressed;
+	g_side_switch_suppressed &= g_side_switch_state;
 	// Demote the current state to history.
 	g_side_prev_switch_state = g_side_switch_state;
 
@@ -479,6 +855,27 @@ uint16_t get_side_switch_up(void)
 	return g_side_switch_up;
 }
 
+/**
+ * Hides the edges of the given switches from the switch up and down state
+ * until each switch has been released. Used so that a combo does not also 
+ * carry out the actions of the individual switches it is made of.
+ *
+ * \param enc_mask [in]	Encoder switches to suppress, bit 0 = encoder 1
+ *
+ * \param side_mask [in]	Side switches to suppress, bit 0 = side switch 1
+ */
+
+void suppress_switches(uint16_t enc_mask, uint8_t side_mask)
+{
+	g_enc_switch_suppressed  |= enc_mask & g_enc_switch_state;
+	g_enc_switch_up          &= ~enc_mask;
+	g_enc_switch_down        &= ~enc_mask;
+	
+	g_side_switch_suppressed |= side_mask & g_side_switch_state;
+	g_side_switch_up         &= ~side_mask;
+	g_side_switch_down       &= ~side_mask;
+}
+
 bool encoder_is_active(uint8_t enc_idx)
 {
 	if (encoder_inactive_counter[enc_idx] >= ENCODER_INACTIVE_THRESHOLD){
@@ -31,6 +31,21 @@
 	#define SWITCH_DEBOUNCE_BUFFER_SIZE	10
 	
 	#define ENCODER_INACTIVE_THRESHOLD 100
+	
+	// Input scan periods in Timer 1 ticks (32 uS), idle and while turning
+	#define INPUT_TIMER_TICK_US         32
+	#define INPUT_SCAN_RATE             40
+	#define INPUT_SCAN_RATE_BURST       10
+	
+	// Number of Timer 1 ticks the scan load is averaged over (~1 S)
+	#define INPUT_LOAD_WINDOW           31250
+	
+	// Number of raw input samples held by the capture buffer
+	#define INPUT_CAPTURE_SIZE          64
+	
+	// A change of direction sooner than this after the previous step is
+	// counted as a reversal by the encoder health counters (mS)
+	#define ENCODER_REVERSAL_MS         10
 
 	// Input Pin Definitions
 	#define SIDE_SW6		IOPORT_CREATE_PIN(PORTA, 5)
@@ -50,6 +65,38 @@
 	#define D_CLK 0x02
 	#define D_DATA 0x03
 	
+/* Types: */
+
+	// Input scan statistics
+	typedef struct {
+		uint16_t missed_edges;    // Scans where both channels of an encoder changed
+		uint16_t burst_scans;     // Scans run at INPUT_SCAN_RATE_BURST
+		uint16_t idle_scans;      // Scans run at INPUT_SCAN_RATE
+		uint16_t isr_load;        // Share of CPU time spent scanning, per mille
+		uint16_t max_scan_ticks;  // Longest scan seen, in Timer 1 ticks
+	} input_diagnostics_t;
+	
+	// Raw input state captured by the input scan. Switch bits are set when 
+	// the switch is closed, channel bits are the encoder pin levels.
+	typedef struct {
+		uint16_t ticks;           // Timer 1 ticks since the previous sample, saturates
+		uint16_t enc_switch;      // Encoder switches, bit 0 = encoder 1
+		uint16_t cha;             // Encoder channel A, bit 0 = encoder 1
+		uint16_t chb;             // Encoder channel B, bit 0 = encoder 1
+		uint8_t  side_switch;     // Side switches, bit 0 = side switch 1
+	} input_sample_t;
+
+	// Per encoder edge statistics, counters saturate rather than wrap
+	typedef struct {
+		uint16_t edges_a;         // Edges seen on channel A
+		uint16_t edges_b;         // Edges seen on channel B
+		uint16_t illegal;         // Scans where both channels changed at once
+		uint16_t reversals;       // Direction changes within ENCODER_REVERSAL_MS
+		uint32_t last_edge_a;     // ms timer at the last channel A edge
+		uint32_t last_edge_b;     // ms timer at the last channel B edge
+		int8_t   last_step;       // Direction of the last step, 1 or -1
+	} encoder_health_t;
+
 /* Global Variables */
 
 /* Function Prototypes */
@@ -58,6 +105,7 @@
 	
 	void encoder_scan(void);
 	int8_t get_encoder_value(uint8_t encoder);
+	uint16_t get_encoder_total(uint8_t encoder);
 	
 	uint16_t update_encoder_switch_state(void);
 
@@ -67,6 +115,17 @@
 	
 	uint32_t get_ms_timer(void);
 	
+	const input_diagnostics_t* get_input_diagnostics(void);
+	void clear_input_diagnostics(void);
+	
+	void clear_input_capture(void);
+	void enable_input_capture(bool enable);
+	uint8_t get_input_capture_count(void);
+	bool get_input_capture_sample(uint8_t idx, input_sample_t* sample);
+	
+	void get_encoder_health(uint8_t encoder, encoder_health_t* health);
+	void clear_encoder_health(void);
+	
 	bool schedule_task(void (*task)(void), uint16_t time);
 	bool cancel_task(void);
 	
@@ -76,5 +135,7 @@
 	uint16_t get_side_switch_state(void);
 	uint16_t get_side_switch_down(void);
 	uint16_t get_side_switch_up(void);
+	
+	void suppress_switches(uint16_t enc_mask, uint8_t side_mask);
 
 #endif /* INPUT_H_ */
\ No newline at end of file
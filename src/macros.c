@@ -0,0 +1,386 @@
+/*
+ * macros.c
+ *
+ * Created: 10/18/2026 5:41:07 PM
+ *
+ *  Side switch macros. A macro is a short list of op codes kept in EEPROM
+ *  which sends MIDI, changes bank and sets encoder values. It is loaded
+ *  into RAM when started and stepped from the main loop a few ops at a 
+ *  time, a wait op leaves the rest of the macro for a later pass.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <macros.h>
+#include <config.h>
+#include <scheduler.h>
+
+/**********
+Macros SysEx protocol:
+
+    0xf0 0x0 0x1 0x79 0x8 OP CMD-SPECIFIC 0xf7
+	
+	CODE is the op codes of a macro, see macro_op_t, up to MACRO_MAX_SIZE 
+	bytes. A macro which does not fill the page ends with MACRO_END.
+	
+	OP 0x0 - Read the macros
+		Request:
+			0xf0 0x0 0x1 0x79 0x8 0x0 0xf7
+		Response, one message per macro:
+			0xf0 0x0 0x1 0x79 0x8 0x0 INDEX CODE 0xf7
+			
+	OP 0x1 - Write a macro, the macro is saved to EEPROM
+		Request:
+			0xf0 0x0 0x1 0x79 0x8 0x1 INDEX CODE 0xf7
+				Macros which are not valid are ignored
+				
+	OP 0x2 - Run a macro
+		Request:
+			0xf0 0x0 0x1 0x79 0x8 0x2 INDEX 0xf7
+			
+	OP 0x3 - Clear all macros
+		Request:
+			0xf0 0x0 0x1 0x79 0x8 0x3 0xf7
+
+**********/
+
+#define MACRO_OP_READ    0x00
+#define MACRO_OP_WRITE   0x01
+#define MACRO_OP_RUN     0x02
+#define MACRO_OP_CLEAR   0x03
+
+// Argument count of each op code
+static const uint8_t macro_op_size[MACRO_OP_COUNT] = {
+	0,	// MACRO_END
+	3,	// MACRO_CC
+	3,	// MACRO_NOTE
+	1,	// MACRO_BANK
+	2,	// MACRO_SET_VALUE
+	2,	// MACRO_WAIT
+	2,	// MACRO_STORE
+	2,	// MACRO_RECALL
+};
+
+// The running macro
+static uint8_t macro_code[MACRO_MAX_SIZE];
+static uint8_t macro_pc;
+static bool    macro_running;
+static bool    macro_waiting;
+static uint32_t macro_wait_start;
+static uint16_t macro_wait_ms;
+
+static uint8_t macro_registers[MACRO_REGISTERS];
+
+// A macro written over SysEx waiting to be saved
+static uint8_t macro_write_buffer[MACRO_MAX_SIZE];
+static uint8_t macro_write_idx;
+static bool    macro_write_pending;
+
+// Macros waiting to be cleared, bit 0 = macro 0
+static uint8_t macro_clear_pending;
+
+static bool macro_is_valid(const uint8_t* code);
+static void save_macro(uint8_t idx, const uint8_t* code);
+static void do_macro_op(const uint8_t* op);
+
+void macros_init(void)
+{
+	macro_running       = false;
+	macro_write_pending = false;
+	macro_clear_pending = 0;
+	memset(macro_registers, 0x00, sizeof(macro_registers));
+}
+
+void macros_factory_reset(void)
+{
+	uint8_t empty[MACRO_MAX_SIZE];
+	
+	memset(empty, MACRO_END, sizeof(empty));
+	
+	for (uint8_t i=0;i<MACRO_COUNT;++i) {
+		save_macro(i, empty);
+	}
+}
+
+/**
+ * Checks every op code and argument of a macro, so a running macro never 
+ * has to. The macro must end within MACRO_MAX_SIZE bytes, running off the
+ * end of the page counts as the end.
+ */
+
+static bool macro_is_valid(const uint8_t* code)
+{
+	uint8_t pc = 0;
+	
+	while (pc < MACRO_MAX_SIZE) {
+		const uint8_t* op = &code[pc];
+		
+		if (op[0] == MACRO_END) {
+			return true;
+		}
+		if (op[0] >= MACRO_OP_COUNT || pc + 1 + macro_op_size[op[0]] > MACRO_MAX_SIZE) {
+			return false;
+		}
+		for (uint8_t i=1;i<=macro_op_size[op[0]];++i) {
+			if (op[i] > 0x7F) {
+				return false;
+			}
+		}
+		
+		switch (op[0]) {
+			case MACRO_CC:
+			case MACRO_NOTE:
+				if (op[1] > 0x0F) return false;
+			break;
+			case MACRO_BANK:
+				if (op[1] >= NUM_BANKS) return false;
+			break;
+			case MACRO_SET_VALUE:
+				if (op[1] > 15) return false;
+			break;
+			case MACRO_STORE:
+			case MACRO_RECALL:
+				if (op[1] >= MACRO_REGISTERS || op[2] > 15) return false;
+			break;
+			default:
+			break;
+		}
+		
+		pc += 1 + macro_op_size[op[0]];
+	}
+	
+	return true;
+}
+
+static void save_macro(uint8_t idx, const uint8_t* code)
+{
+	cpu_irq_disable();
+	nvm_eeprom_load_page_to_buffer(code);
+	nvm_eeprom_atomic_write_page(MACRO_EE_START_PAGE + idx);
+	cpu_irq_enable();
+}
+
+/**
+ * Loads a macro from EEPROM and starts it, replacing any macro which is 
+ * still running. Erased or invalid macros do nothing.
+ *
+ * \param idx [in]	The macro to run
+ *
+ * \return true if the macro was started
+ */
+
+bool start_macro(uint8_t idx)
+{
+	if (idx >= MACRO_COUNT) {
+		return false;
+	}
+	
+	nvm_eeprom_read_buffer((MACRO_EE_START_PAGE + idx) * EEPROM_PAGE_SIZE, macro_code, MACRO_MAX_SIZE);
+	
+	macro_running = macro_code[0] != MACRO_END && macro_is_valid(macro_code);
+	macro_waiting = false;
+	macro_pc      = 0;
+	
+	return macro_running;
+}
+
+/**
+ * Returns true while the running macro has an op ready to carry out.
+ */
+
+bool macro_pending(void)
+{
+	if (macro_running && macro_waiting &&
+		(get_ms_timer() - macro_wait_start) >= macro_wait_ms) {
+		macro_waiting = false;
+	}
+	
+	return macro_running && !macro_waiting;
+}
+
+/**
+ * Steps the running macro, run by the main loop macro task. At most 
+ * MACRO_STEPS_PER_PASS ops are carried out, stopping early at a wait.
+ */
+
+void run_macros(void)
+{
+	for (uint8_t step=0;step<MACRO_STEPS_PER_PASS;++step) {
+		if (!macro_pending()) {
+			return;
+		}
+		
+		if (macro_pc >= MACRO_MAX_SIZE || macro_code[macro_pc] == MACRO_END) {
+			macro_running = false;
+			return;
+		}
+		
+		const uint8_t* op = &macro_code[macro_pc];
+		macro_pc += 1 + macro_op_size[op[0]];
+		
+		do_macro_op(op);
+	}
+}
+
+static void do_macro_op(const uint8_t* op)
+{
+	switch (op[0]) {
+		case MACRO_CC:{
+			midi_stream_raw_cc(op[1], op[2], op[3]);
+		} break;
+		case MACRO_NOTE:{
+			midi_stream_raw_note(op[1], op[2], op[3] != 0, op[3]);
+		} break;
+		case MACRO_BANK:{
+			if (op[1] != current_encoder_bank()) {
+				// Send bank change MIDI output
+				midi_stream_raw_cc(midi_system_channel, current_encoder_bank(), 0);
+				midi_stream_raw_cc(midi_system_channel, op[1], 127);
+				change_encoder_bank(op[1]);
+			}
+		} break;
+		case MACRO_SET_VALUE:{
+			set_encoder_value(op[1], op[2]);
+		} break;
+		case MACRO_WAIT:{
+			macro_wait_start = get_ms_timer();
+			macro_wait_ms    = op[1] | ((uint16_t)op[2] << 7);
+			macro_waiting    = true;
+		} break;
+		case MACRO_STORE:{
+			macro_registers[op[1]] = read_encoder_value(op[2]);
+		} break;
+		case MACRO_RECALL:{
+			set_encoder_value(op[2], macro_registers[op[1]]);
+		} break;
+		default:
+		break;
+	}
+}
+
+/**
+ * Saves a macro written over SysEx, run by the main loop EEPROM task so the
+ * slow page write is kept out of the MIDI handler. Cleared macros are 
+ * written one page per call.
+ */
+
+void commit_macros(void)
+{
+	if (macro_write_pending) {
+		macro_write_pending = false;
+		save_macro(macro_write_idx, macro_write_buffer);
+	} else if (macro_clear_pending) {
+		uint8_t empty[MACRO_MAX_SIZE];
+		uint8_t idx = 0;
+		
+		while (!(macro_clear_pending & (0x01 << idx))) {
+			++idx;
+		}
+		
+		memset(empty, MACRO_END, sizeof(empty));
+		macro_clear_pending &= ~(0x01 << idx);
+		save_macro(idx, empty);
+	}
+	
+	if (macro_write_pending || macro_clear_pending) {
+		scheduler_set_ready(TASK_EEPROM);
+	}
+}
+
+static void send_macro(uint8_t idx)
+{
+	uint8_t payload[MACRO_MAX_SIZE + 8] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+										   SYSEX_COMMAND_MACROS,
+										   MACRO_OP_READ,
+										   idx};
+	uint8_t size = 7;
+	uint8_t code[MACRO_MAX_SIZE];
+	
+	nvm_eeprom_read_buffer((MACRO_EE_START_PAGE + idx) * EEPROM_PAGE_SIZE, code, MACRO_MAX_SIZE);
+	
+	// Erased pages read back as an empty macro
+	if (!macro_is_valid(code)) {
+		code[0] = MACRO_END;
+	}
+	
+	// Send up to and including the end
+	for (uint8_t i=0;i<MACRO_MAX_SIZE;++i) {
+		payload[size++] = code[i];
+		if (code[i] == MACRO_END) {
+			break;
+		}
+	}
+	
+	payload[size++] = 0xf7;
+	
+	midi_stream_sysex(size, payload);
+	wdt_reset();
+}
+
+void sysExCmdMacros(uint8_t length, uint8_t* buffer)
+{
+	if (length < 2) return;
+	
+	switch (buffer[0]) {
+		case MACRO_OP_READ:{
+			// Pick up macros which have not been saved yet
+			while (macro_write_pending || macro_clear_pending) {
+				commit_macros();
+			}
+			for (uint8_t i=0;i<MACRO_COUNT;++i) {
+				send_macro(i);
+			}
+		}
+		break;
+		case MACRO_OP_WRITE:{
+			// Op, index and the end of the message surround the code
+			if (length < 3 || buffer[1] >= MACRO_COUNT || length - 3 > MACRO_MAX_SIZE) return;
+			
+			// Only one write is held at a time
+			if (macro_write_pending) {
+				commit_macros();
+			}
+			
+			memset(macro_write_buffer, MACRO_END, sizeof(macro_write_buffer));
+			memcpy(macro_write_buffer, &buffer[2], length - 3);
+			
+			if (macro_is_valid(macro_write_buffer)) {
+				macro_write_idx     = buffer[1];
+				macro_write_pending = true;
+				scheduler_set_ready(TASK_EEPROM);
+			}
+		}
+		break;
+		case MACRO_OP_RUN:{
+			if (length < 3) return;
+			
+			while (macro_write_pending || macro_clear_pending) {
+				commit_macros();
+			}
+			start_macro(buffer[1]);
+		}
+		break;
+		case MACRO_OP_CLEAR:{
+			macro_running       = false;
+			macro_write_pending = false;
+			macro_clear_pending = (0x01 << MACRO_COUNT) - 1;
+			scheduler_set_ready(TASK_EEPROM);
+		}
+		break;
+		default:
+		break;
+	}
+}
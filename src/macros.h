@@ -0,0 +1,69 @@
+/*
+ * macros.h
+ *
+ * Created: 10/18/2026 5:41:07 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef MACROS_H_
+#define MACROS_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		
+	/*	Macros: */
+	
+		// Each macro is kept in its own EEPROM page, anything after the
+		// end of a shorter macro is padded with MACRO_END
+		#define MACRO_COUNT				4
+		#define MACRO_MAX_SIZE			EEPROM_PAGE_SIZE
+		
+		// Steps carried out per pass of the main loop, so a long macro 
+		// can't hold up input processing
+		#define MACRO_STEPS_PER_PASS	4
+		
+		// Values saved by MACRO_STORE for MACRO_RECALL
+		#define MACRO_REGISTERS			8
+
+	/*	Types: */
+	
+		// Macro op codes, followed by their arguments. All arguments are 
+		// 7 bit so macros can be sent over SysEx unchanged
+		typedef enum macro_op {
+			MACRO_END,			// End of the macro
+			MACRO_CC,			// CHANNEL NUMBER VALUE
+			MACRO_NOTE,			// CHANNEL NUMBER VELOCITY, 0 sends note off
+			MACRO_BANK,			// BANK, as the global bank side switch actions
+			MACRO_SET_VALUE,	// ENCODER VALUE, in the current bank
+			MACRO_WAIT,			// MS_LSB MS_MSB, 7 bits each
+			MACRO_STORE,		// REGISTER ENCODER, saves the encoder value
+			MACRO_RECALL,		// REGISTER ENCODER, sets the encoder to a saved value
+			MACRO_OP_COUNT,
+		} macro_op_t;
+
+	/* Function Prototypes: */
+	
+		void macros_init(void);
+		void macros_factory_reset(void);
+		bool start_macro(uint8_t idx);
+		bool macro_pending(void);
+		void run_macros(void);
+		void commit_macros(void);
+		void sysExCmdMacros(uint8_t length, uint8_t* buffer);
+
+#endif /* MACROS_H_ */
@@ -45,16 +45,37 @@
 #include "jump_to_bootloader.h"
 #include "sequencer.h"
 #include "self_test.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "watchdog.h"
+#include "usb_midi.h"
 
 //#define DEMO 
+
+// Expected worst case run times of the budgeted main loop tasks. An EEPROM
+// page write takes several mS, the display draws 6 encoders per pass when
+// ENABLE_MAX_LED_UPDATE_SPEED is set.
+#define EEPROM_TASK_BUDGET_US	10000
+#if ENABLE_MAX_LED_UPDATE_SPEED > 0
+#define DISPLAY_TASK_BUDGET_US	1200
+#else
+#define DISPLAY_TASK_BUDGET_US	200
+#endif
 	
 void system_init(void);
 void board_init(void);
 
-bool watchdog_flag = false;
+static void input_task(void);
+static void midi_in_task(void);
+static void eeprom_task(void);
+static void display_task(void);
+static bool display_pending(void);
 
 int main (void)
 {	
+	// Save the record of why we last reset before anything else runs
+	watchdog_init();
+	
 	// Initialize all systems	
 	system_init();
 	config_init();
@@ -64,6 +85,9 @@ int main (void)
 	midi_init();	
 	encoders_init();
 	side_switch_init();	
+	gestures_init();
+	combos_init();
+	macros_init();
 	display_init();
 	sequencer_init();
 	
@@ -78,15 +102,9 @@ int main (void)
 	// Check if we need to perform any self tests
 	check_self_test();
 	
-	//Then check for the four corner boot loader input pattern
-	if(update_encoder_switch_state() == 0x9009)
-	{
-		Jump_To_Bootloader();
-	} else if (update_encoder_switch_state() == 0xF000){
-		// Force factory test
-		eeprom_write(EE_SELF_TEST_FLAG, 0xFF);
-		check_self_test();
-	}
+	// Then check for start up combos such as the four corner boot loader 
+	// input pattern
+	check_boot_combos();
 	
 	// Clear out any start up noise from the encoders
 	for(uint8_t i=0;i<16;++i){
@@ -96,9 +114,24 @@ int main (void)
 	// If the USB connection is not configured within a certain window
 	// we switch to using serial/legacy for MIDI
 	schedule_task(set_midi_serial, 0xFFFF);
+	
+	// Set up the main loop tasks. Input is made ready by each encoder scan.
+	// The USB interrupt queues received MIDI and sends outgoing MIDI itself,
+	// incoming MIDI is polled from its ring as is the display which is only 
+	// drawn while the pass has time left. A running macro is polled until
+	// its next op is due. With nothing pending the loop sleeps until the 
+	// next interrupt.
+	profiler_init();
+	scheduler_init();
+	scheduler_install(TASK_INPUT,    input_task,    0,                      0);
+	scheduler_install(TASK_MIDI_IN,  midi_in_task,  0,                      midi_receive_pending);
+	scheduler_install(TASK_MACRO,    run_macros,    0,                      macro_pending);
+	scheduler_install(TASK_EEPROM,   eeprom_task,   EEPROM_TASK_BUDGET_US,  0);
+	scheduler_install(TASK_DISPLAY,  display_task,  DISPLAY_TASK_BUDGET_US, display_pending);
 
 	// Main Loop
 	do {
+		uint16_t loop_start = profile_timestamp();
 		
 			// Force display to rainbow demo		
 #ifdef DEMO
@@ -111,93 +144,162 @@ int main (void)
 			}
 #endif		
 
-			switch (get_op_mode()) {
-				case normal:{
-					// Process any encoder movements or changes to the switch state
-					process_encoder_input();
+			// Run every task that is ready, highest priority first
+			scheduler_run();
 			
-					// Check for any change to the encoder state and refresh the display, because
-					// redrawing any display is slow we only check and update 1 encoder per main loop
-					#if ENABLE_MAX_LED_UPDATE_SPEED > 0
-					 #warning LED Controllers are being Updated at a Higher Speed! This results in latency up to 8ms.
-					 // !Summer2016Update: improve LED Update Times
-					 // Performance Testing: Dual Animations running on Every Encoder. MIDI Feedback sent Constantly 1-message/ millisecond.
-					 // - Target Range is a maximum of 8ms.
-					 // < 1: latency = 2ms
-					 // < 4: latency in range (4-6ms)
-					 // < 6: latency in range (6-8ms)*
-					 // < 8: latency in range (8-10ms)
-					 // < 16:latency = (16-20ms)
-					 for(uint8_t encoder_display_counter = 0; encoder_display_counter < 6; encoder_display_counter++)  
-					 {
-						update_encoder_display();
-					 }
-					#else
-					 update_encoder_display();
-					#endif
-					// Now we have dealt with the encoders we check for side switch state changes
-					// Side switches either send MIDI or carry out an action
-					process_side_switch_input();
-				}
-				break;
-				case shift1:{
-					
-					run_shift_mode(0);
-					process_side_switch_input();	
-				}
-				break;
-				case shift2:{
-					
-					run_shift_mode(1);
-					process_side_switch_input();
-				}
-				break;
-				case sequencer:{
-					process_seq_side_buttons();
-					process_sequencer_input();	
-					run_sequencer_display();
-				}
-				break;
-			}
-			
-			
-			
-			if(midi_is_usb())
-			{
-				MIDI_Device_USBTask(g_midi_interface_info);
-				USB_USBTask();
-				
-				// If we are using the USB MIDI connection check for and process received MIDI packets
-				MIDI_EventPacket_t ReceivedMIDIEvent;
-				
-				// For now we disable interrupts while processing incoming MIDI, this avoids missed clock
-				// ticks. This could probably be solved more elegantly but it works
-				PMIC.CTRL &= ~(PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm);
-				
-				while (MIDI_Device_ReceiveEventPacket(g_midi_interface_info, &ReceivedMIDIEvent))
-				{
-					process_midi_packet(ReceivedMIDIEvent);
-				}				
-				PMIC.CTRL = PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm | PMIC_HILVLEN_bm;
-			} else {
-				// Otherwise process any legacy MIDI packets
-				PMIC.CTRL &= ~(PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm);
-				process_legacy_packet();
-				PMIC.CTRL = PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm | PMIC_HILVLEN_bm;
-			}
-			
-		watchdog_flag = true;	
+		// Reset the watch dog timer, dawg, but only if every subsystem
+		// has checked in
+		watchdog_service();
 		
-		// Reset the watch dog timer, dawg
-		if (watchdog_flag)
-		{
-			wdt_reset();
-			watchdog_flag = false;
-		}
+		profile_record(PROFILE_MAIN_LOOP, loop_start);
+		
+		// Sleep until the next interrupt if nothing is left to do
+		scheduler_idle();
 		
 	} while (1);
 }
 
+/**
+ * Processes encoder and switch input for the current op mode.
+ */
+static void input_task(void)
+{
+	// Update both sets of switches before any switch actions are carried
+	// out so combos can be matched against the complete switch state
+	if (get_op_mode() != sequencer) {
+		update_encoder_switch_state();
+		update_side_switch_state();
+		process_combos();
+	}
+	
+	switch (get_op_mode()) {
+		case normal:{
+			// Process any encoder movements or changes to the switch state
+			process_encoder_input();
+			// Now we have dealt with the encoders we check for side switch state changes
+			// Side switches either send MIDI or carry out an action
+			process_side_switch_input();
+			// With both switch states up to date look for any gestures
+			process_gestures();
+		}
+		break;
+		case shift1:{}
+		// cascade to the next case ... NO BREAK ON PURPOSE
+		case shift2:{
+			// The encoders are working on the shift page layer
+			process_encoder_input();
+			process_side_switch_input();
+			process_gestures();
+		}
+		break;
+		case sequencer:{
+			process_seq_side_buttons();
+			process_sequencer_input();	
+		}
+		break;
+		default:
+		break;
+	}
+}
+
+/**
+ * Services the USB connection and handles received MIDI.
+ */
+static void midi_in_task(void)
+{
+	if(midi_is_usb())
+	{
+		USB_USBTask();
+		
+		// If we are using the USB MIDI connection process the packets the USB 
+		// interrupt has received
+		MIDI_EventPacket_t ReceivedMIDIEvent;
+		
+		// For now we disable interrupts while processing incoming MIDI, this avoids missed clock
+		// ticks. This could probably be solved more elegantly but it works
+		PMIC.CTRL &= ~(PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm);
+		
+		while (usb_midi_receive(&ReceivedMIDIEvent))
+		{
+			process_midi_packet(ReceivedMIDIEvent);
+		}				
+		PMIC.CTRL = PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm | PMIC_HILVLEN_bm;
+	} else {
+		// Otherwise process any legacy MIDI packets
+		PMIC.CTRL &= ~(PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm);
+		process_legacy_packet();
+		PMIC.CTRL = PMIC_LOLVLEN_bm | PMIC_MEDLVLEN_bm | PMIC_HILVLEN_bm;
+	}
+}
+
+/**
+ * Writes settings changed over SysEx to EEPROM.
+ */
+static void eeprom_task(void)
+{
+	commit_combos();
+	commit_side_switch_layers();
+	commit_macros();
+}
+
+/**
+ * Draws the display for the current op mode.
+ */
+static void display_task(void)
+{
+	switch (get_op_mode()) {
+		case shift1:{}
+		// cascade to the next case ... NO BREAK ON PURPOSE
+		case shift2:{}
+		// cascade to the next case ... NO BREAK ON PURPOSE
+		case normal:{
+			// Check for any change to the encoder state and refresh the display, because
+			// redrawing any display is slow we only check and update 1 encoder per main loop
+			#if ENABLE_MAX_LED_UPDATE_SPEED > 0
+			 #warning LED Controllers are being Updated at a Higher Speed! This results in latency up to 8ms.
+			 // !Summer2016Update: improve LED Update Times
+			 // Performance Testing: Dual Animations running on Every Encoder. MIDI Feedback sent Constantly 1-message/ millisecond.
+			 // - Target Range is a maximum of 8ms.
+			 // < 1: latency = 2ms
+			 // < 4: latency in range (4-6ms)
+			 // < 6: latency in range (6-8ms)*
+			 // < 8: latency in range (8-10ms)
+			 // < 16:latency = (16-20ms)
+			 for(uint8_t encoder_display_counter = 0; encoder_display_counter < 6; encoder_display_counter++)  
+			 {
+				update_encoder_display();
+			 }
+			#else
+			 update_encoder_display();
+			#endif
+		}
+		break;
+		case sequencer:{
+			run_sequencer_display();
+		}
+		break;
+		default:
+		break;
+	}
+}
+
+/**
+ * Returns true if the display for the current op mode needs drawing.
+ */
+static bool display_pending(void)
+{
+	switch (get_op_mode()) {
+		case normal:
+		case shift1:
+		case shift2:
+			return encoder_display_pending();
+		case sequencer:
+			return true;
+		default:
+			return false;
+	}
+}
+
 /** Initializes ASF drivers */
 void system_init()
 {	
@@ -233,6 +335,11 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 	bool ConfigSuccess = true;
 
 	ConfigSuccess &= MIDI_Device_ConfigureEndpoints(g_midi_interface_info);
+	
+	// Hand the MIDI endpoints to the USB interrupt
+	if (ConfigSuccess){
+		usb_midi_init();
+	}
 
 	//LEDs_SetAllLEDs(ConfigSuccess ? LEDMASK_USB_READY : LEDMASK_USB_ERROR);
 	
@@ -251,6 +358,12 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 	}
 }
 
+/** Event handler for the library USB Start of Frame event, every 1 mS. */
+void EVENT_USB_Device_StartOfFrame(void)
+{
+	usb_midi_start_of_frame();
+}
+
 /** Event handler for the library USB Control Request reception event. */
 void EVENT_USB_Device_ControlRequest(void)
 {
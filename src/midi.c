@@ -23,6 +23,8 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */ 
 #include "midi.h"
+#include "usb_midi.h"
+#include "profiler.h"
 //#include "display_driver.h"
 
 static midi_port_type_t midi_port_mode;
@@ -146,6 +148,30 @@ bool midi_is_usb(void)
 }
 
 
+/**
+ *  Returns true if there is received MIDI or a USB control request waiting
+ *  to be handled. Only touches registers and the receive ring so it may be
+ *  called with interrupts disabled.
+**/
+bool midi_receive_pending(void)
+{
+	if (!midi_is_usb()) {
+		return !fifo_is_empty(&fifo_desc);
+	}
+	
+	if (USB_DeviceState == DEVICE_STATE_Unattached) {
+		return false;
+	}
+	
+	uint8_t prev_endpoint = Endpoint_GetCurrentEndpoint();
+	
+	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+	bool pending = Endpoint_IsSETUPReceived();
+	Endpoint_SelectEndpoint(prev_endpoint);
+	
+	return pending || usb_midi_rx_pending();
+}
+
 /* Send a 16 bit value as a song position pointer message for easy debugging */
 void debug_16_bit_value(uint16_t value)
 {
@@ -297,10 +323,7 @@ void midi_stream_raw_note(const uint8_t channel,
     midi_event.Data2       = pitch & 0x7f;   // 0..127
     midi_event.Data3       = velocity & 0x7f; // 0..127
 	if (midi_is_usb()){
-		int error_code = MIDI_Device_SendEventPacket(g_midi_interface_info, &midi_event);
-		if (error_code){
-			int i = 0 + error_code;
-		}
+		usb_midi_send(&midi_event);
 		
 	} else {
 		MIDI_send_legacy_packet(&midi_event);
@@ -320,7 +343,7 @@ void midi_stream_raw_cc(const uint8_t channel,
     midi_event.Data3       = value & 0x7f;  // 0..127
 
 	if (midi_is_usb()) {
-		MIDI_Device_SendEventPacket(g_midi_interface_info, &midi_event);
+		usb_midi_send(&midi_event);
 	} else {
 		MIDI_send_legacy_packet(&midi_event);
 	}
@@ -359,7 +382,7 @@ void midi_stream_sysex (const uint8_t length, uint8_t* data)
 		}
 		midi_event.Data2       = *data++;
 		midi_event.Data3       = *data++;
-		MIDI_Device_SendEventPacket(g_midi_interface_info, &midi_event);
+		usb_midi_send(&midi_event);
 		num -= 3;
 	}
 	if (num) {
@@ -379,7 +402,7 @@ void midi_stream_sysex (const uint8_t length, uint8_t* data)
 			midi_event.Data2    = *data++;
 			midi_event.Data3    = *data++;
 		}
-		MIDI_Device_SendEventPacket(g_midi_interface_info, &midi_event);
+		usb_midi_send(&midi_event);
 	}
 }
 
@@ -391,6 +414,8 @@ void midi_stream_sysex (const uint8_t length, uint8_t* data)
 **/
 void process_midi_packet(MIDI_EventPacket_t input_event)
 {
+	uint16_t profile_start = profile_timestamp();
+	
 	// Parse the USB-MIDI packet to see what it contains
 	switch (input_event.Event) {
 		case 0xF :
@@ -502,6 +527,8 @@ void process_midi_packet(MIDI_EventPacket_t input_event)
 		// do nothing.
 		break;
 	} // end USB-MIDI packet parse
+	
+	profile_record(PROFILE_MIDI_PACKET, profile_start);
 }
 
 
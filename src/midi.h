@@ -134,6 +134,7 @@
 	uint8_t getTickCount(void);
 
 	bool midi_is_usb(void);
+	bool midi_receive_pending(void);
 	
 	void set_midi_serial(void);
 	
@@ -0,0 +1,109 @@
+/*
+ * profiler.c
+ *
+ * Created: 10/18/2026 6:12:40 PM
+ *
+ *  Times the main loop, each scheduler task and the busiest interrupts 
+ *  against the free running Timer D0. For every measured point the number
+ *  of samples, the longest duration seen and a log2 histogram of durations
+ *  are kept, these are read back with the diagnostics SysEx command.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <profiler.h>
+
+#include <string.h>
+
+#if ENABLE_PROFILER > 0
+
+static profile_stats_t profile_stats[PROFILE_POINT_COUNT];
+
+void profiler_init(void)
+{
+	clear_profile_stats();
+	
+	// Timer D0 only counts, the overflow is handled by the unsigned 
+	// subtraction in profile_record()
+	tc_enable(&TCD0);
+	tc_set_wgm(&TCD0, TC_WG_NORMAL);
+#if PROFILE_CLOCK_DIV == 1
+	tc_write_clock_source(&TCD0, TC_CLKSEL_DIV1_gc);
+#elif PROFILE_CLOCK_DIV == 64
+	tc_write_clock_source(&TCD0, TC_CLKSEL_DIV64_gc);
+#else
+	#error PROFILE_CLOCK_DIV must be 1 or 64
+#endif
+}
+
+/**
+ * Records the time since start against a profile point, safe to call from
+ * interrupts.
+ *
+ * \param point [in]	The code path being measured
+ *
+ * \param start [in]	The profile_timestamp() taken when it was entered
+ */
+
+void profile_record(profile_point_t point, uint16_t start)
+{
+	uint16_t duration = profile_timestamp() - start;
+	
+	uint8_t bucket = 0;
+	uint16_t d = duration;
+	while (d && bucket < PROFILE_BUCKETS - 1) {
+		d >>= 1;
+		bucket++;
+	}
+	
+	irqflags_t flags = cpu_irq_save();
+	profile_stats_t* stats = &profile_stats[point];
+	if (stats->count < 0xFFFF) {
+		stats->count++;
+	}
+	if (stats->hist[bucket] < 0xFFFF) {
+		stats->hist[bucket]++;
+	}
+	if (duration > stats->max) {
+		stats->max = duration;
+	}
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Copies the statistics for one profile point.
+ */
+
+void get_profile_stats(profile_point_t point, profile_stats_t* stats)
+{
+	if (point >= PROFILE_POINT_COUNT) {
+		memset(stats, 0x00, sizeof(profile_stats_t));
+		return;
+	}
+	
+	irqflags_t flags = cpu_irq_save();
+	memcpy(stats, &profile_stats[point], sizeof(profile_stats_t));
+	cpu_irq_restore(flags);
+}
+
+void clear_profile_stats(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	memset(profile_stats, 0x00, sizeof(profile_stats));
+	cpu_irq_restore(flags);
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * profiler.h
+ *
+ * Created: 10/18/2026 6:12:40 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		#include <string.h>
+		#include <scheduler.h>
+		
+	/*	Macros: */
+	
+		// Set to 0 to remove the profiler, the timestamp and record calls
+		// then compile to nothing and Timer D0 is left off
+		#define ENABLE_PROFILER			1
+		
+		// Timer D0 prescaler. 64 gives a 2 uS tick and a 131 mS range, a 
+		// build may set 1 to time short paths in CPU cycles on the unit, 
+		// though anything over 2 mS then wraps
+		#ifndef PROFILE_CLOCK_DIV
+		#define PROFILE_CLOCK_DIV		64
+		#endif
+		
+		#define PROFILE_TICK_CYCLES		PROFILE_CLOCK_DIV
+		
+		// Durations are binned by their highest set bit, bucket 0 holds
+		// durations under one tick and bucket n those from 2^(n-1) ticks
+		#define PROFILE_BUCKETS			16
+
+	/*	Types: */
+	
+		// Measured code paths
+		typedef enum profile_point {
+			PROFILE_MAIN_LOOP,						// One main loop pass
+			PROFILE_TASK_FIRST,						// One per scheduler task
+			PROFILE_ISR_ENCODER_SCAN = PROFILE_TASK_FIRST + TASK_COUNT,
+			PROFILE_ISR_DISPLAY_FRAME,
+			PROFILE_ISR_DO_TASK,
+			PROFILE_ENCODER_INPUT,					// process_encoder_input()
+			PROFILE_MIDI_PACKET,					// process_midi_packet()
+			PROFILE_ELEMENT_MIDI,					// process_element_midi()
+			PROFILE_POINT_COUNT,
+		} profile_point_t;
+		
+		typedef struct {
+			uint16_t count;						// Saturates at 0xFFFF
+			uint16_t max;						// Longest duration in ticks
+			uint16_t hist[PROFILE_BUCKETS];		// Saturate at 0xFFFF
+		} profile_stats_t;
+
+	/* Function Prototypes: */
+	
+	#if ENABLE_PROFILER > 0
+	
+		void profiler_init(void);
+		void profile_record(profile_point_t point, uint16_t start);
+		void get_profile_stats(profile_point_t point, profile_stats_t* stats);
+		void clear_profile_stats(void);
+		
+		/**
+		 * Reads Timer D0. It is read from interrupts of every level, 16 bit 
+		 * reads share the timer TEMP register so interrupts are held off.
+		 */
+		static inline uint16_t profile_timestamp(void)
+		{
+			irqflags_t flags = cpu_irq_save();
+			uint16_t count = TCD0.CNT;
+			cpu_irq_restore(flags);
+			return count;
+		}
+		
+	#else
+	
+		static inline void profiler_init(void) {}
+		static inline void profile_record(profile_point_t point, uint16_t start) {(void)point; (void)start;}
+		static inline void get_profile_stats(profile_point_t point, profile_stats_t* stats) {(void)point; memset(stats, 0x00, sizeof(profile_stats_t));}
+		static inline void clear_profile_stats(void) {}
+		static inline uint16_t profile_timestamp(void) {return 0;}
+		
+	#endif
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,240 @@
+/*
+ * scheduler.c
+ *
+ * Created: 10/18/2026 5:02:18 PM
+ *
+ *  Cooperative main loop scheduler. Each task has a priority (its task id),
+ *  a ready flag set by an interrupt or event and an optional time budget.
+ *  Every pass of the main loop runs each ready task at most once, always
+ *  picking the highest priority ready task next, so a MIDI packet which
+ *  arrives while the display is being drawn is handled before any further
+ *  low priority work. When no task has work the CPU sleeps in IDLE until
+ *  the next interrupt.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <scheduler.h>
+#include <profiler.h>
+#include <watchdog.h>
+
+#include <string.h>
+
+typedef struct {
+	task_fn_t fn;
+	uint16_t  budget;	// Timer 0 ticks, 0 = always run when ready
+	task_poll_fn_t poll;	// Checked every pass, 0 = event driven
+} task_t;
+
+static task_t tasks[TASK_COUNT];
+
+// Set by scheduler_set_ready(), bit 0 = TASK_INPUT
+static volatile uint8_t task_ready;
+
+// Time spent asleep and in total over the current idle window, in Timer 0
+// ticks
+static uint32_t idle_ticks;
+static uint32_t window_ticks;
+static uint16_t window_last;
+static uint8_t  idle_percent;
+
+/**
+ * Reads Timer 0. The display timer interrupts also read the count and 16 bit
+ * reads share the timer TEMP register, so interrupts are held off.
+ */
+
+static uint16_t read_timer(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t count = tc_read_count(&TCC0);
+	cpu_irq_restore(flags);
+	return count;
+}
+
+void scheduler_init(void)
+{
+	memset(tasks, 0x00, sizeof(tasks));
+	task_ready = 0;
+	
+	idle_ticks = 0;
+	window_ticks = 0;
+	window_last = read_timer();
+	idle_percent = 0;
+	
+	// USB, the timers and the DMA all keep running in IDLE, any deeper mode
+	// would stop them
+	sleepmgr_init();
+	sleepmgr_lock_mode(SLEEPMGR_IDLE);
+}
+
+/**
+ * Installs a main loop task.
+ *
+ * \param task [in]		The task slot, which also sets its priority
+ *
+ * \param fn [in]		Function run when the task is ready
+ *
+ * \param budget_us [in]	Longest time the task is expected to take. The task 
+ *						is skipped for this pass if the time left in the pass
+ *						is shorter, 0 means the task always runs when ready.
+ *
+ * \param poll [in]	For tasks with no ready event, checked every pass and
+ *						the task is ready while it returns true. 0 if the task
+ *						is made ready by scheduler_set_ready().
+ */
+
+void scheduler_install(task_id_t task, task_fn_t fn, uint16_t budget_us, task_poll_fn_t poll)
+{
+	if (task >= TASK_COUNT) return;
+	
+	tasks[task].fn = fn;
+	tasks[task].budget = budget_us / SCHEDULER_TICK_US;
+	tasks[task].poll = poll;
+}
+
+/**
+ * Returns the ready flags of the polled tasks.
+ */
+
+static uint8_t poll_tasks(void)
+{
+	uint8_t polled = 0;
+	
+	for (uint8_t i=0;i<TASK_COUNT;++i) {
+		if (tasks[i].poll && tasks[i].poll()) {
+			polled |= (0x01 << i);
+		}
+	}
+	
+	return polled;
+}
+
+/**
+ * Marks a task as ready to run, safe to call from interrupts.
+ */
+
+void scheduler_set_ready(task_id_t task)
+{
+	irqflags_t flags = cpu_irq_save();
+	task_ready |= (0x01 << task);
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Runs one pass of the main loop. The highest priority ready task is run 
+ * first and the ready flags are checked again after every task, so tasks
+ * made ready while a lower priority task runs go next. Budgeted tasks 
+ * are only started while their budget fits in what the budgeted tasks
+ * already run this pass have left of SCHEDULER_LOOP_BUDGET_US, the first
+ * budgeted task of a pass is always allowed so none can be starved.
+ */
+
+void scheduler_run(void)
+{
+	uint16_t spent = 0;
+	bool     budgeted_ran = false;
+	uint8_t  ran = 0;
+	uint8_t  polled = poll_tasks();
+	
+	// Advance the idle window
+	uint16_t now = read_timer();
+	window_ticks += (uint16_t)(now - window_last);
+	window_last = now;
+	if (window_ticks >= SCHEDULER_IDLE_WINDOW) {
+		idle_percent = (idle_ticks * 100) / window_ticks;
+		idle_ticks = 0;
+		window_ticks = 0;
+	}
+	
+	while (true) {
+		
+		irqflags_t flags = cpu_irq_save();
+		uint8_t ready = (task_ready | polled) & ~ran;
+		cpu_irq_restore(flags);
+		
+		uint8_t bit = 0x01;
+		uint8_t next = TASK_COUNT;
+		
+		for (uint8_t i=0;i<TASK_COUNT;++i) {
+			if ((ready & bit) && tasks[i].fn != 0 &&
+			    (tasks[i].budget == 0 || !budgeted_ran ||
+				 spent + tasks[i].budget <= SCHEDULER_LOOP_BUDGET_US / SCHEDULER_TICK_US)) {
+				next = i;
+				break;
+			}
+			bit <<= 1;
+		}
+		
+		if (next == TASK_COUNT) {
+			break;
+		}
+		
+		// Clear the flag first so an event during the task makes it ready 
+		// again for the next pass
+		flags = cpu_irq_save();
+		task_ready &= ~bit;
+		cpu_irq_restore(flags);
+		
+		ran |= bit;
+		
+		uint16_t profile_start = profile_timestamp();
+		
+		if (tasks[next].budget) {
+			uint16_t start = read_timer();
+			tasks[next].fn();
+			spent += read_timer() - start;
+			budgeted_ran = true;
+		} else {
+			tasks[next].fn();
+		}
+		
+		profile_record(PROFILE_TASK_FIRST + next, profile_start);
+	}
+	
+	heartbeat(HEARTBEAT_SCHEDULER);
+}
+
+/**
+ * Sleeps until the next interrupt if no task has work to do. Call once per
+ * pass of the main loop after scheduler_run(). The ready flags are checked 
+ * with interrupts disabled and the sleep manager enables them again on the
+ * instruction before sleeping, so an event raised in between always wakes
+ * the loop.
+ */
+
+void scheduler_idle(void)
+{
+	cpu_irq_disable();
+	
+	if (task_ready || poll_tasks()) {
+		cpu_irq_enable();
+		return;
+	}
+	
+	uint16_t start = read_timer();
+	sleepmgr_enter_sleep();
+	idle_ticks += (uint16_t)(read_timer() - start);
+}
+
+/**
+ * Returns the share of time the main loop spent asleep over the last 
+ * SCHEDULER_IDLE_WINDOW.
+ */
+
+uint8_t scheduler_get_idle_percent(void)
+{
+	return idle_percent;
+}
@@ -0,0 +1,69 @@
+/*
+ * scheduler.h
+ *
+ * Created: 10/18/2026 5:02:18 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		
+	/*	Macros: */
+	
+		// Timer 0 runs at 32 MHz / 256, the scheduler times tasks against it
+		#define SCHEDULER_TICK_US		8
+		
+		// Time allowed for budgeted tasks in one pass of the main loop, a
+		// budgeted task is only started while its budget still fits in 
+		// what the budgeted tasks before it have left
+		#define SCHEDULER_LOOP_BUDGET_US	2000
+		
+		// Window over which the idle percentage is measured, in timer ticks
+		// (1 S)
+		#define SCHEDULER_IDLE_WINDOW		125000UL
+
+	/*	Types: */
+	
+		// Main loop tasks, highest priority first
+		typedef enum task_id {
+			TASK_INPUT,			// Encoder and switch processing
+			TASK_MIDI_IN,		// Receive and handle incoming MIDI
+			TASK_MACRO,			// Step the running side switch macro
+			TASK_EEPROM,		// Commit pending settings to EEPROM
+			TASK_DISPLAY,		// Render the encoder display
+			TASK_COUNT,
+		} task_id_t;
+		
+		typedef void (*task_fn_t)(void);
+		
+		// Returns true while a polled task has work to do
+		typedef bool (*task_poll_fn_t)(void);
+
+	/* Function Prototypes: */
+	
+		void scheduler_init(void);
+		void scheduler_install(task_id_t task, task_fn_t fn, uint16_t budget_us, task_poll_fn_t poll);
+		void scheduler_set_ready(task_id_t task);
+		void scheduler_run(void);
+		void scheduler_idle(void);
+		uint8_t scheduler_get_idle_percent(void);
+
+#endif /* SCHEDULER_H_ */
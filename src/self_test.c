@@ -44,6 +44,12 @@
 #define TEST_TIME_OUT			  5000
 #define MAX_SWITCH_DOWN           1000
 
+// Encoder health test thresholds
+#define HEALTH_MIN_EDGES           96	// Edges needed before an encoder can pass
+#define HEALTH_ILLEGAL_SHIFT        5	// Up to 1 illegal transition per 32 edges
+#define HEALTH_REVERSAL_SHIFT       4	// Up to 1 fast reversal per 16 edges
+#define HEALTH_STUCK_MS          1000	// Channel idle while the other moves
+
 /**
  * There are two different self tests that are performed during manufacture
  * The first is performed at the PCB assembly level and tests the functionality
@@ -97,9 +103,7 @@ bool check_self_test(void)
 				eeprom_write(EE_SELF_TEST_FLAG, ASSEMBLY_TEST_PASSED_FLAG);
 			} 
 			// Force a Reset
-			wdt_set_timeout_period(WDT_TIMEOUT_PERIOD_16CLK);
-			wdt_enable();
-			while(true){};
+			watchdog_force_reset();
 		} else {
 			return true;
 		}
@@ -368,6 +372,95 @@ bool assembly_self_test(void)
 	return true;
 }
 
+/**
+ * Checks the edge statistics of an encoder against the health thresholds.
+ * A healthy encoder has close to the same number of edges on each channel,
+ * few illegal transitions and few fast reversals.
+ *
+ * \return true if any threshold is exceeded
+ */
+
+static bool encoder_health_failed(const encoder_health_t* health, uint32_t now)
+{
+	uint16_t edges = health->edges_a + health->edges_b;
+	uint16_t imbalance = health->edges_a > health->edges_b ? 
+						 health->edges_a - health->edges_b : health->edges_b - health->edges_a;
+	
+	if (health->illegal > (edges >> HEALTH_ILLEGAL_SHIFT) + 2) {
+		return true;
+	}
+	if (health->reversals > (edges >> HEALTH_REVERSAL_SHIFT) + 2) {
+		return true;
+	}
+	if (imbalance > (edges >> 2) + 4) {
+		return true;
+	}
+	
+	// One channel stuck while the other is still changing
+	uint32_t age_a = now - health->last_edge_a;
+	uint32_t age_b = now - health->last_edge_b;
+	if ((age_a > HEALTH_STUCK_MS && age_b < HEALTH_STUCK_MS / 4 && health->edges_b > 8) ||
+	    (age_b > HEALTH_STUCK_MS && age_a < HEALTH_STUCK_MS / 4 && health->edges_a > 8)) {
+		return true;
+	}
+	
+	return false;
+}
+
+/**
+ * Encoder health test, run from the start up combo. The operator turns every
+ * encoder back and forth, its indicator shows how many edges have been seen.
+ * An encoder turns green once it has passed HEALTH_MIN_EDGES edges within
+ * the thresholds, or red as soon as a threshold is exceeded. The test ends
+ * when both middle side switches are pressed.
+ *
+ * \return true if every encoder passed
+ */
+
+bool encoder_health_test(void)
+{
+	uint16_t passed = 0x0000;
+	uint16_t failed = 0x0000;
+	
+	display_enable();
+	clear_display_buffer();
+	clear_encoder_health();
+	
+	while((update_side_switch_state() & 0x12) != 0x12){
+		
+		uint32_t now = get_ms_timer();
+		uint16_t bit = 0x0001;
+		
+		for(uint8_t i=0;i<16;++i){
+			encoder_health_t health;
+			
+			// Discard the movement, only the statistics are used
+			get_encoder_value(i);
+			get_encoder_health(i, &health);
+			
+			uint16_t edges = health.edges_a + health.edges_b;
+			
+			if (!(failed & bit) && encoder_health_failed(&health, now)) {
+				failed |= bit;
+				build_rgb(i, 0xFF0000, false);
+			} else if (!((failed | passed) & bit) && edges >= HEALTH_MIN_EDGES) {
+				passed |= bit;
+				build_rgb(i, 0x00FF00, false);
+			}
+			
+			uint8_t progress = edges >= HEALTH_MIN_EDGES ? 127 : (edges * 127) / HEALTH_MIN_EDGES;
+			set_encoder_indicator(i, progress, false, BAR, false);
+			
+			bit <<= 1;
+		}
+	}
+	
+	clear_display_buffer();
+	display_disable();
+	
+	return failed == 0x0000 && passed == 0xFFFF;
+}
+
 // Displays a flashing RED display pattern to indicate failure
 // This function never returns
 void fail_indicator(uint8_t element)
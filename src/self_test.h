@@ -35,6 +35,7 @@
 	// The two different tests
 	bool elec_self_test(void);
 	bool assembly_self_test(void);
+	bool encoder_health_test(void);
 	
 	// Helper functions
 	void fail_indicator(uint8_t element);
@@ -76,10 +76,11 @@ void sequencer_init(void)
 	{
 		set_slot_clip(i, 0);
 		
-		// Read in the default patterns
+		// Read in the default patterns, there is no default for the last one
+		// so it starts empty
 		for(uint8_t j=0;j<12;++j){
 			for(uint8_t k=0;k<16;++k){
-				pattern[i][j][k] = pgm_read_byte(&default_pattern[j][k]);
+				pattern[i][j][k] = j < 11 ? pgm_read_byte(&default_pattern[j][k]) : 0;
 			}
 		}
 		
@@ -308,9 +309,6 @@ void send_triggers(void){
 			}
 		}
 
-		// Flush USB endpoint now now to give best timing
-		MIDI_Device_Flush(g_midi_interface_info);
-		
 		rythmIndex++;
 		if(rythmIndex == 16){
 			rythmIndex = 0;
@@ -587,11 +587,8 @@ void do_alternate_functions(bool sw_down)
 }
 
 //  Sends all MIDI controlled parameters to the Software
-//  MIDI Interface is flush before to ensure it does not become overloaded by the 18 messages we are about to send
 void push_all_parameters(void){
 	
-	MIDI_Device_Flush(g_midi_interface_info);
-	
 	for(uint8_t i=0;i<4;++i){
 		midi_stream_raw_cc(SEQ_CHANNEL, SEQ_MUTE_OFFSET+i, 127 * slotSettings[i].mute_on);
 		midi_stream_raw_cc(SEQ_CHANNEL, SEQ_FILTER_ON_OFFSET+i, 127 * slotSettings[i].filter_on);
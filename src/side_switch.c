@@ -24,10 +24,63 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 **/
 #include <side_switch.h>
+#include <scheduler.h>
+
+/**********
+Side switch layers SysEx protocol:
+
+    0xf0 0x0 0x1 0x79 0x7 OP CMD-SPECIFIC 0xf7
+	
+	Each bank has its own layer of side switch actions. A bank which has 
+	not been written follows the global side switch settings, sending on
+	the system channel with the number offset by the bank if banked.
+	For MACRO_SS the NUMBER is the macro to run.
+	
+	OP 0x0 - Read the layers
+		Request:
+			0xf0 0x0 0x1 0x79 0x7 0x0 0xf7
+		Response, one message per bank and switch:
+			0xf0 0x0 0x1 0x79 0x7 0x0 BANK SWITCH ACTION CHANNEL NUMBER CUSTOM 0xf7
+			
+	OP 0x1 - Write a switch of a bank layer, the layer is saved to EEPROM
+		Request:
+			0xf0 0x0 0x1 0x79 0x7 0x1 BANK SWITCH ACTION CHANNEL NUMBER 0xf7
+				
+	OP 0x2 - Return all layers to the global side switch settings
+		Request:
+			0xf0 0x0 0x1 0x79 0x7 0x2 0xf7
+
+**********/
+
+#define SIDE_LAYER_OP_READ    0x00
+#define SIDE_LAYER_OP_WRITE   0x01
+#define SIDE_LAYER_OP_RESET   0x02
 
 // Holds all configurable side switch settings
 static side_sw_settings_t side_sw_cfg;
 
+// Holds the side switch actions for each bank
+static side_sw_layer_t side_sw_layers[NUM_BANKS];
+
+// The layer for the current bank, swapped when the bank changes
+static side_sw_layer_t* active_layer = &side_sw_layers[0];
+
+// The layer each switch was pressed on, held and up events are carried
+// out on the same layer even if the press changed the bank
+static side_sw_layer_t* pressed_layer[SIDE_SW_COUNT];
+
+// Banks whose layers have been set over SysEx, bit 0 = bank 1. All 
+// other layers follow the global side switch settings
+static uint8_t side_layer_custom;
+
+// Banks whose layers are waiting to be saved
+static uint8_t side_layer_dirty;
+
+// Held switches with an action that auto-repeats, bit 0 = switch 1, and
+// the ms timer value each is next due to repeat at
+static uint8_t  side_repeat_armed;
+static uint16_t side_repeat_due[SIDE_SW_COUNT];
+
 // Holds toggle state for switch if configured for MIDI toggle action
 static uint8_t side_switch_toggle_state[NUM_BANKS];
 
@@ -42,6 +95,9 @@ static op_mode_t mode = startup;
 // Internal Functions
 void side_switch_config(side_sw_settings_t *settings);
 void do_side_switch_function(uint8_t switch_num, switch_event_t state);
+static void build_default_layers(void);
+static bool side_switch_action_repeats(uint8_t action);
+static void save_side_switch_layer(uint8_t bank);
 
 // Initializes all side switch settings
 void side_switch_init(void)
@@ -50,6 +106,11 @@ void side_switch_init(void)
 	for(uint8_t i=0;i<NUM_BANKS;++i){
 		side_switch_toggle_state[i] = 0x00;
 	}
+	for(uint8_t i=0;i<SIDE_SW_COUNT;++i){
+		pressed_layer[i] = active_layer;
+	}
+	
+	side_switch_layers_init();
 }
 
 /**
@@ -78,6 +139,238 @@ void side_switch_config(side_sw_settings_t *settings)
 	side_sw_cfg.sw_action[3] = settings->sw_action[3];
 	side_sw_cfg.sw_action[4] = settings->sw_action[4];
 	side_sw_cfg.sw_action[5] = settings->sw_action[5];
+	
+	side_sw_cfg.repeat_delay = settings->repeat_delay;
+	side_sw_cfg.repeat_rate  = settings->repeat_rate;
+	
+	build_default_layers();
+}
+
+/**
+ * Fills every layer which has not been set over SysEx from the global side
+ * switch settings, matching the fixed mapping used before layers existed.
+ */
+
+static void build_default_layers(void)
+{
+	for (uint8_t bank=0;bank<NUM_BANKS;++bank) {
+		if (side_layer_custom & (0x01 << bank)) {
+			continue;
+		}
+		
+		uint8_t offset = side_sw_cfg.side_is_banked ? bank*SIDE_SW_COUNT : 0;
+		
+		for (uint8_t i=0;i<SIDE_SW_COUNT;++i) {
+			side_sw_layers[bank].action[i]  = side_sw_cfg.sw_action[i];
+			side_sw_layers[bank].channel[i] = midi_system_channel;
+			side_sw_layers[bank].number[i]  = SIDE_SWITCH_OFFSET + i + offset;
+			
+			// Global macro switches run the macro matching the switch
+			if (side_sw_cfg.sw_action[i] == MACRO_SS) {
+				side_sw_layers[bank].number[i] = i;
+			}
+		}
+	}
+}
+
+/**
+ * Loads the bank layers from EEPROM. A bank whose page is erased or invalid
+ * (such as on the first start after a firmware update) follows the global
+ * side switch settings.
+ */
+
+void side_switch_layers_init(void)
+{
+	uint8_t slot_buffer[SIDE_LAYER_EE_SIZE];
+	
+	side_layer_custom = 0;
+	side_layer_dirty  = 0;
+	
+	for (uint8_t bank=0;bank<NUM_BANKS;++bank) {
+		nvm_eeprom_read_buffer(SIDE_LAYER_EE_START_PAGE * EEPROM_PAGE_SIZE + bank * SIDE_LAYER_EE_SIZE, 
+							   slot_buffer, SIDE_LAYER_EE_SIZE);
+		
+		if (slot_buffer[SIDE_LAYER_EE_CUSTOM] != 0x01) {
+			continue;
+		}
+		
+		bool valid = true;
+		
+		for (uint8_t i=0;i<SIDE_SW_COUNT;++i) {
+			if ((slot_buffer[SIDE_LAYER_EE_ACTION + i] & 0x0F) >= SIDE_SW_ACTION_COUNT ||
+				slot_buffer[SIDE_LAYER_EE_NUMBER + i] > 0x7F) {
+				valid = false;
+				break;
+			}
+		}
+		
+		if (valid) {
+			for (uint8_t i=0;i<SIDE_SW_COUNT;++i) {
+				side_sw_layers[bank].action[i]  = slot_buffer[SIDE_LAYER_EE_ACTION + i] & 0x0F;
+				side_sw_layers[bank].channel[i] = slot_buffer[SIDE_LAYER_EE_ACTION + i] >> 4;
+				side_sw_layers[bank].number[i]  = slot_buffer[SIDE_LAYER_EE_NUMBER + i];
+			}
+			side_layer_custom |= 0x01 << bank;
+		}
+	}
+	
+	build_default_layers();
+	set_side_switch_layer(current_encoder_bank());
+}
+
+void side_switch_layers_factory_reset(void)
+{
+	side_layer_custom = 0;
+	
+	for (uint8_t bank=0;bank<NUM_BANKS;++bank) {
+		save_side_switch_layer(bank);
+	}
+	
+	build_default_layers();
+}
+
+/**
+ * Selects the side switch layer for a bank, called on every bank change.
+ */
+
+void set_side_switch_layer(uint8_t bank)
+{
+	active_layer = &side_sw_layers[bank % NUM_BANKS];
+}
+
+/**
+ * Sets one switch of a bank layer in RAM, the layer no longer follows the
+ * global side switch settings. commit_side_switch_layers() saves it.
+ *
+ * \param bank [in]		Bank layer to change
+ *
+ * \param switch_num [in]	Side switch, 0 - 5
+ *
+ * \param action [in]		side_sw_action_t to carry out
+ *
+ * \param channel [in]		MIDI channel, 0 - 15
+ *
+ * \param number [in]		MIDI CC or note number
+ *
+ * \return true if the entry was valid and has been set
+ */
+
+bool set_side_switch_layer_entry(uint8_t bank, uint8_t switch_num, uint8_t action, 
+								 uint8_t channel, uint8_t number)
+{
+	if (bank >= NUM_BANKS || switch_num >= SIDE_SW_COUNT || action >= SIDE_SW_ACTION_COUNT ||
+		channel > 0x0F || number > 0x7F) {
+		return false;
+	}
+	
+	side_sw_layers[bank].action[switch_num]  = action;
+	side_sw_layers[bank].channel[switch_num] = channel;
+	side_sw_layers[bank].number[switch_num]  = number;
+	
+	side_layer_custom |= 0x01 << bank;
+	side_layer_dirty  |= 0x01 << bank;
+	
+	return true;
+}
+
+const side_sw_layer_t* get_side_switch_layer(uint8_t bank)
+{
+	return &side_sw_layers[bank % NUM_BANKS];
+}
+
+static void save_side_switch_layer(uint8_t bank)
+{
+	uint8_t page_buffer[EEPROM_PAGE_SIZE];
+	uint8_t page = SIDE_LAYER_EE_START_PAGE + bank / 2;
+	
+	// The page is shared with the neighbouring bank so read it in first
+	nvm_eeprom_read_buffer(page * EEPROM_PAGE_SIZE, page_buffer, EEPROM_PAGE_SIZE);
+	
+	uint8_t* slot = &page_buffer[(bank % 2) * SIDE_LAYER_EE_SIZE];
+	
+	memset(slot, 0xFF, SIDE_LAYER_EE_SIZE);
+	
+	if (side_layer_custom & (0x01 << bank)) {
+		slot[SIDE_LAYER_EE_CUSTOM] = 0x01;
+		for (uint8_t i=0;i<SIDE_SW_COUNT;++i) {
+			slot[SIDE_LAYER_EE_ACTION + i] = side_sw_layers[bank].action[i] | (side_sw_layers[bank].channel[i] << 4);
+			slot[SIDE_LAYER_EE_NUMBER + i] = side_sw_layers[bank].number[i];
+		}
+	}
+	
+	cpu_irq_disable();
+	nvm_eeprom_load_page_to_buffer(page_buffer);
+	nvm_eeprom_atomic_write_page(page);
+	cpu_irq_enable();
+}
+
+/**
+ * Saves the layers changed over SysEx, run by the main loop EEPROM task. 
+ * One page is written per call so a single pass stays within its budget.
+ */
+
+void commit_side_switch_layers(void)
+{
+	for (uint8_t bank=0;bank<NUM_BANKS;++bank) {
+		if (side_layer_dirty & (0x01 << bank)) {
+			side_layer_dirty &= ~(0x01 << bank);
+			save_side_switch_layer(bank);
+			if (side_layer_dirty) {
+				scheduler_set_ready(TASK_EEPROM);
+			}
+			return;
+		}
+	}
+}
+
+static void send_side_switch_layer(uint8_t bank, uint8_t switch_num)
+{
+	uint8_t payload[] = {0xf0, 0x00, MANUFACTURER_ID >> 8, MANUFACTURER_ID & 0x7f,
+						 SYSEX_COMMAND_SIDE_LAYERS,
+						 SIDE_LAYER_OP_READ,
+						 bank,
+						 switch_num,
+						 side_sw_layers[bank].action[switch_num],
+						 side_sw_layers[bank].channel[switch_num],
+						 side_sw_layers[bank].number[switch_num],
+						 (side_layer_custom >> bank) & 0x01,
+						 0xf7};
+	
+	midi_stream_sysex(sizeof(payload), payload);
+	wdt_reset();
+}
+
+void sysExCmdSideLayers(uint8_t length, uint8_t* buffer)
+{
+	if (length < 2) return;
+	
+	switch (buffer[0]) {
+		case SIDE_LAYER_OP_READ:{
+			for (uint8_t bank=0;bank<NUM_BANKS;++bank) {
+				for (uint8_t i=0;i<SIDE_SW_COUNT;++i) {
+					send_side_switch_layer(bank, i);
+				}
+			}
+		}
+		break;
+		case SIDE_LAYER_OP_WRITE:{
+			if (length < 7) return;
+			
+			if (set_side_switch_layer_entry(buffer[1], buffer[2], buffer[3], buffer[4], buffer[5])) {
+				scheduler_set_ready(TASK_EEPROM);
+			}
+		}
+		break;
+		case SIDE_LAYER_OP_RESET:{
+			side_layer_dirty |= side_layer_custom;
+			side_layer_custom = 0;
+			build_default_layers();
+			scheduler_set_ready(TASK_EEPROM);
+		}
+		break;
+		default:
+		break;
+	}
 }
 
 side_sw_settings_t* get_side_switch_config(void)
@@ -89,58 +382,104 @@ side_sw_settings_t* get_side_switch_config(void)
 
 /**
  * Checks for state changes for the side switches then carries out the configured
- * action for that switch.
+ * action for that switch. The side switch state must already have been updated
+ * this loop, see update_side_switch_state(). Held switches are only dispatched 
+ * when their auto-repeat is due.
  */
 
 void process_side_switch_input(void)
 {
-	update_side_switch_state();
+	uint8_t down = get_side_switch_down();
+	uint8_t up   = get_side_switch_up();
 	
-	static uint8_t prev_side_switch_state = 0;
+	if (down | up) {
+		uint8_t bit = 0x01;
+		
+		for(uint8_t i = 0; i <SIDE_SW_COUNT;++i) {
+			if(down & bit){
+				do_side_switch_function(i, SW_DOWN);
+				
+				if (side_switch_action_repeats(pressed_layer[i]->action[i])) {
+					side_repeat_armed |= bit;
+					side_repeat_due[i] = (uint16_t)get_ms_timer() + side_sw_cfg.repeat_delay*10;
+				}
+			} else if (up & bit){
+				side_repeat_armed &= ~bit;
+				do_side_switch_function(i, SW_UP);
+			}
+			bit <<=1;
+		}
+	}
 	
-	uint8_t bit = 0x01;
-
-	uint8_t enc_bank = current_encoder_bank();
+	// Switches suppressed by a combo don't report their release
+	side_repeat_armed &= get_side_switch_state();
 	
-	// Check for Sequencer Activation Combination (Both Middle at same time)
-	if ((get_side_switch_state() & 0x12) == 0x12){
-		if ((prev_side_switch_state & 0x12) == 0x02 || (prev_side_switch_state & 0x12) == 0x10){
-			set_op_mode(sequencer);
-			init_seq_display();
-			prev_side_switch_state = 0;
+	if (side_repeat_armed) {
+		uint16_t now = get_ms_timer();
+		uint8_t bit = 0x01;
+		
+		for(uint8_t i = 0; i <SIDE_SW_COUNT;++i) {
+			if ((side_repeat_armed & bit) && (int16_t)(now - side_repeat_due[i]) >= 0) {
+				side_repeat_due[i] += side_sw_cfg.repeat_rate*10;
+				do_side_switch_function(i, SW_REPEAT);
+			}
+			bit <<=1;
 		}
-		return;
 	}
+}
+
+/**
+ * Returns true for actions which repeat while their switch is held
+ */
+
+static bool side_switch_action_repeats(uint8_t action)
+{
+	return action == GLOBAL_BANK_UP || action == GLOBAL_BANK_DOWN || action == CYCLE_BANK;
+}
+
+/**
+ * Returns true while any side switch set to fine adjust is held
+ */
+
+bool side_switch_fine_adjust_held(void)
+{
+	uint8_t bit = 0x01;
 	
 	for(uint8_t i = 0; i <6;++i) {
-		
-		if(get_side_switch_down() & bit){
-			do_side_switch_function(i, SW_DOWN);
-		} else if (get_side_switch_up() & bit){
-			do_side_switch_function(i, SW_UP);
-		} else if (get_side_switch_state() & bit){
-			do_side_switch_function(i, SW_HELD);
+		if (active_layer->action[i] == FINE_ADJUST_SS && (get_side_switch_state() & bit)) {
+			return true;
 		}
-	
 		bit <<=1;
 	}
-	
-	prev_side_switch_state = get_side_switch_state();
+	return false;
 }
 
 void do_side_switch_function(uint8_t switch_num, switch_event_t state)
 {
 	
-	uint8_t bank = side_sw_cfg.side_is_banked ? current_encoder_bank() : 0;
+	// Held and released switches stay on the layer they were pressed on
+	if (state == SW_DOWN) {
+		pressed_layer[switch_num] = active_layer;
+	}
+	
+	side_sw_layer_t* layer = pressed_layer[switch_num];
+	uint8_t bank    = layer - side_sw_layers;
+	uint8_t channel = layer->channel[switch_num];
+	uint8_t number  = layer->number[switch_num];
+	
+	// Unset layers which are not banked share one toggle state
+	if (!side_sw_cfg.side_is_banked && !(side_layer_custom & (0x01 << bank))) {
+		bank = 0;
+	}
 	
 	// Perform the switch action
-	switch (side_sw_cfg.sw_action[switch_num]) {
+	switch (layer->action[switch_num]) {
 		case CC_HOLD_SS:{
 			// The switch sends a CC so send that CC
 			if(state == SW_DOWN){
-				midi_stream_raw_cc(midi_system_channel, SIDE_SWITCH_OFFSET + switch_num + (bank*6) , 127);
+				midi_stream_raw_cc(channel, number, 127);
 			} else if(state == SW_UP) {
-				midi_stream_raw_cc(midi_system_channel, SIDE_SWITCH_OFFSET + switch_num + (bank*6) , 0);
+				midi_stream_raw_cc(channel, number, 0);
 			}
 		} break;
 		case CC_TOGGLE_SS:{
@@ -149,15 +488,15 @@ void do_side_switch_function(uint8_t switch_num, switch_event_t state)
 				uint8_t bit = 0x01 << switch_num;
 				side_switch_toggle_state[bank] ^= bit;
 				uint8_t value = side_switch_toggle_state[bank] & bit ? 127 : 0;
-				midi_stream_raw_cc(midi_system_channel, SIDE_SWITCH_OFFSET + switch_num + (bank*6) , value);
+				midi_stream_raw_cc(channel, number, value);
 			} 
 		} break;
 		case NOTE_HOLD_SS:{
 			// The switch sends a Note so send that Note
 			if(state == SW_DOWN){
-				midi_stream_raw_note(midi_system_channel, SIDE_SWITCH_OFFSET + switch_num + (bank*6), true, 127);
+				midi_stream_raw_note(channel, number, true, 127);
 			} else if(state == SW_UP) {
-				midi_stream_raw_note(midi_system_channel, SIDE_SWITCH_OFFSET + switch_num + (bank*6), false , 0);
+				midi_stream_raw_note(channel, number, false , 0);
 			}
 						
 		} break;
@@ -168,15 +507,16 @@ void do_side_switch_function(uint8_t switch_num, switch_event_t state)
 				side_switch_toggle_state[bank] ^= bit;
 				uint8_t velocity = side_switch_toggle_state[bank] & bit ? 127 : 0;
 				bool is_note_on = side_switch_toggle_state[bank] & bit ? true : false;
-				midi_stream_raw_note(midi_system_channel, SIDE_SWITCH_OFFSET + switch_num + (bank*6) , is_note_on, velocity);
+				midi_stream_raw_note(channel, number, is_note_on, velocity);
 			}
 		} break;
 		case SHIFT_PAGE_1:{
 			// The switch activates shift page 1 so enable shift page 1
 			if (state == SW_DOWN) {
 				set_op_mode(shift1);
+				enter_shift_page(0);
 			} else if (state == SW_UP) {
-				refresh_display();
+				exit_shift_page();
 				set_op_mode(normal);
 			}
 		} break;
@@ -184,14 +524,15 @@ void do_side_switch_function(uint8_t switch_num, switch_event_t state)
 			// The switch activates shift page 2 so enable shift page 2
 			if (state == SW_DOWN) {
 				set_op_mode(shift2);
+				enter_shift_page(1);
 			} else if (state == SW_UP) {
-				refresh_display();
+				exit_shift_page();
 				set_op_mode(normal);
 			}
 		} break;
 		case GLOBAL_BANK_UP:{
 			// The switch increments the global bank setting
-			if((state == SW_DOWN) && (current_encoder_bank() < (NUM_BANKS-1))){
+			if((state == SW_DOWN || state == SW_REPEAT) && (current_encoder_bank() < (NUM_BANKS-1))){
 				// Send bank change MIDI output
 				midi_stream_raw_cc(midi_system_channel, current_encoder_bank(), 0);
 				change_encoder_bank(current_encoder_bank()+1);
@@ -201,7 +542,7 @@ void do_side_switch_function(uint8_t switch_num, switch_event_t state)
 		} break;
 		case GLOBAL_BANK_DOWN:{
 			// The switch decrements the global bank setting
-			if((state == SW_DOWN) && (current_encoder_bank() > 0)){
+			if((state == SW_DOWN || state == SW_REPEAT) && (current_encoder_bank() > 0)){
 				// Send bank change MIDI output
 				midi_stream_raw_cc(midi_system_channel, current_encoder_bank(), 0);
 				change_encoder_bank(current_encoder_bank()-1);
@@ -244,9 +585,18 @@ void do_side_switch_function(uint8_t switch_num, switch_event_t state)
 				change_encoder_bank(3);
 			}
 		} break;
+		case FINE_ADJUST_SS:{
+			// Fine adjust is applied by the encoder input while the switch is held
+		} break;
+		case MACRO_SS:{
+			// The macro is stepped by the main loop once started
+			if (state == SW_DOWN) {
+				start_macro(number);
+			}
+		} break;
 		case CYCLE_BANK:{
 			// The switch sets the global bank setting to 4
-			if(state == SW_DOWN){
+			if(state == SW_DOWN || state == SW_REPEAT){
 				// Send bank change MIDI output
 				midi_stream_raw_cc(midi_system_channel, current_encoder_bank(), 0);
 				if(current_encoder_bank() == (NUM_BANKS-1)){
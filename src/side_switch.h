@@ -31,6 +31,16 @@
 		#include <encoders.h>
 		
 	/*	Macros: */
+	
+		#define SIDE_SW_COUNT			6
+		
+		// Two bank layers are kept in each EEPROM page, a flag byte followed
+		// by the action (low nibble) and channel (high nibble) of each 
+		// switch, then the numbers of the switches
+		#define SIDE_LAYER_EE_SIZE		16
+		#define SIDE_LAYER_EE_CUSTOM	0x00
+		#define SIDE_LAYER_EE_ACTION	0x01
+		#define SIDE_LAYER_EE_NUMBER	(SIDE_LAYER_EE_ACTION + SIDE_SW_COUNT)
 
 	/*	Types: */
 	
@@ -50,14 +60,28 @@
 			GLOBAL_BANK_3,
 			GLOBAL_BANK_4,
 			CYCLE_BANK,
+			FINE_ADJUST_SS,
+			MACRO_SS,
+			SIDE_SW_ACTION_COUNT,
 		} side_sw_action_t;
 	
 		// Structure which hold side switch settings
 		typedef struct {
 			side_sw_action_t sw_action[6];
 			bool			 side_is_banked;
+			uint8_t			 repeat_delay;	// x 10 mS before a held switch repeats
+			uint8_t			 repeat_rate;	// x 10 mS between repeats
 		} side_sw_settings_t;
 		
+		// The side switch actions for one bank, the layer for the current
+		// bank is selected when the bank changes. Macro switches run the
+		// macro given by their number
+		typedef struct {
+			uint8_t action[SIDE_SW_COUNT];
+			uint8_t channel[SIDE_SW_COUNT];
+			uint8_t number[SIDE_SW_COUNT];
+		} side_sw_layer_t;
+		
 		// The different operational modes
 		typedef enum {
 			startup,	// Device is starting up or not yet configured
@@ -77,6 +101,15 @@
 		void side_switch_config(side_sw_settings_t *settings);
 		side_sw_settings_t* get_side_switch_config(void);
 		void process_side_switch_input(void);
+		bool side_switch_fine_adjust_held(void);
+		
+		void side_switch_layers_init(void);
+		void side_switch_layers_factory_reset(void);
+		void set_side_switch_layer(uint8_t bank);
+		bool set_side_switch_layer_entry(uint8_t bank, uint8_t switch_num, uint8_t action, uint8_t channel, uint8_t number);
+		const side_sw_layer_t* get_side_switch_layer(uint8_t bank);
+		void commit_side_switch_layers(void);
+		void sysExCmdSideLayers(uint8_t length, uint8_t* buffer);
 		
 		void set_op_mode(op_mode_t new_mode);
 		op_mode_t get_op_mode(void);
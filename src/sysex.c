@@ -158,6 +158,12 @@ void sysex_handle_3sc (MIDI_EventPacket_t* packet)
 // Handle a 3-byte end message
 void sysex_handle_3e (MIDI_EventPacket_t* packet)
 {
+	// An end without a start has nothing to finish, and sysex_ptr may not
+	// be set up yet
+	if (!sysex_is_reading) {
+		return;
+	}
+	
 	// 3-byte End of Sysex
 	sysex_is_reading = false;
 	
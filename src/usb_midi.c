@@ -0,0 +1,353 @@
+/*
+ * usb_midi.c
+ *
+ * Created: 10/18/2026 7:41:05 PM
+ *
+ *  Services the USB MIDI data endpoints from the USB interrupts. Received
+ *  packets are copied from the OUT endpoint into a RAM ring as soon as they
+ *  arrive. Packets queued for the host collect in a transmit ring and are 
+ *  written to the IN endpoint once per 1 mS frame at the USB Start of Frame,
+ *  as many as fit in the bank, so each frame carries a predictable batch 
+ *  and the frame count gives a timebase shared with the host. Only parsing
+ *  of received MIDI is left to the main loop.
+ *
+ *  LUFA configures every endpoint with its interrupt disabled and does not
+ *  provide a transaction complete handler on XMEGA, both are set up here
+ *  once the MIDI endpoints are configured. Control requests are still 
+ *  handled by USB_USBTask() in the main loop.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <usb_midi.h>
+#include <watchdog.h>
+
+#include <string.h>
+
+#define RX_RING_MASK (USB_MIDI_RX_RING_SIZE - 1)
+#define TX_RING_MASK (USB_MIDI_TX_RING_SIZE - 1)
+
+static MIDI_EventPacket_t rx_ring[USB_MIDI_RX_RING_SIZE];
+static MIDI_EventPacket_t tx_ring[USB_MIDI_TX_RING_SIZE];
+
+// Free running indices, the ring position is the index masked
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+static volatile uint8_t tx_head;
+static volatile uint8_t tx_tail;
+
+// The IN bank holds a packet the host has not read yet
+static volatile bool in_busy;
+
+// A send has timed out and the host has not read the IN endpoint since
+static volatile bool tx_stalled;
+
+// The endpoints are configured and the interrupt is running
+static volatile bool usb_midi_ready;
+
+// Start of Frame count since the device was configured
+static volatile uint16_t usb_frame_count;
+
+static usb_midi_stats_t usb_midi_stats;
+
+/**
+ * Moves a received OUT packet into the receive ring. The packet is left in
+ * the endpoint, which NAKs the host, if the ring does not have room for all
+ * of it. Must be called with interrupts disabled.
+ */
+
+static void service_out(void)
+{
+	Endpoint_SelectEndpoint(MIDI_STREAM_OUT_EPADDR);
+	
+	if (!Endpoint_IsOUTReceived()) {
+		return;
+	}
+	
+	uint8_t packets = Endpoint_BytesInEndpoint() / sizeof(MIDI_EventPacket_t);
+	uint8_t used = rx_head - rx_tail;
+	
+	if (USB_MIDI_RX_RING_SIZE - used < packets) {
+		return;
+	}
+	
+	while (packets--) {
+		MIDI_EventPacket_t* event = &rx_ring[rx_head & RX_RING_MASK];
+		event->Event = Endpoint_Read_8();
+		event->Data1 = Endpoint_Read_8();
+		event->Data2 = Endpoint_Read_8();
+		event->Data3 = Endpoint_Read_8();
+		
+		// MIDI class drivers pad the end of the bank with empty packets
+		if (event->Event) {
+			rx_head++;
+			if (usb_midi_stats.rx_packets < 0xFFFF) {
+				usb_midi_stats.rx_packets++;
+			}
+		}
+	}
+	
+	used = rx_head - rx_tail;
+	if (used > usb_midi_stats.rx_max_used) {
+		usb_midi_stats.rx_max_used = used;
+	}
+	
+	Endpoint_ClearOUT();
+}
+
+/**
+ * Fills the IN endpoint from the transmit ring and hands it to the host if
+ * the endpoint is free. Must be called with interrupts disabled, once per
+ * frame.
+ */
+
+static void service_in(void)
+{
+	Endpoint_SelectEndpoint(MIDI_STREAM_IN_EPADDR);
+	
+	// The bank is free once the host has read it or NAKed an empty bank
+	if (USB_Endpoint_SelectedHandle->STATUS & (USB_EP_TRNCOMPL0_bm | USB_EP_BUSNACK0_bm)) {
+		in_busy = false;
+		tx_stalled = false;
+	}
+	
+	// The frame interrupt is running. A host which has stopped reading IN
+	// only stalls the transmit side, usb_midi_send() drops what it cannot
+	// queue, so it does not count against the heartbeat
+	heartbeat(HEARTBEAT_MIDI);
+	
+	if (in_busy || tx_head == tx_tail) {
+		return;
+	}
+	
+	while (tx_head != tx_tail && 
+	       Endpoint_BytesInEndpoint() + sizeof(MIDI_EventPacket_t) <= MIDI_STREAM_EPSIZE) {
+		MIDI_EventPacket_t* event = &tx_ring[tx_tail & TX_RING_MASK];
+		Endpoint_Write_8(event->Event);
+		Endpoint_Write_8(event->Data1);
+		Endpoint_Write_8(event->Data2);
+		Endpoint_Write_8(event->Data3);
+		tx_tail++;
+		if (usb_midi_stats.tx_packets < 0xFFFF) {
+			usb_midi_stats.tx_packets++;
+		}
+	}
+	
+	Endpoint_ClearIN();
+	in_busy = true;
+}
+
+static bool endpoints_ready(void)
+{
+	return usb_midi_ready && USB_DeviceState == DEVICE_STATE_Configured;
+}
+
+/**
+ * Returns true while the host has the MIDI endpoints configured.
+ */
+
+bool usb_midi_configured(void)
+{
+	return endpoints_ready();
+}
+
+/**
+ * Services the OUT endpoint, leaving the selected endpoint unchanged for
+ * any code it interrupted. Must be called with interrupts disabled.
+ */
+
+static void service_rx(void)
+{
+	if (!endpoints_ready()) {
+		return;
+	}
+	
+	uint8_t prev_endpoint = Endpoint_GetCurrentEndpoint();
+	service_out();
+	Endpoint_SelectEndpoint(prev_endpoint);
+}
+
+ISR(USB_TRNCOMPL_vect)
+{
+	USB.INTFLAGSBCLR = USB_TRNIF_bm;
+	service_rx();
+}
+
+/**
+ * Start of Frame handler, called from the USB bus event interrupt every
+ * 1 mS. Counts the frame and sends what has been queued since the last one.
+ */
+
+void usb_midi_start_of_frame(void)
+{
+	usb_frame_count++;
+	
+	if (!endpoints_ready()) {
+		return;
+	}
+	
+	uint8_t prev_endpoint = Endpoint_GetCurrentEndpoint();
+	service_in();
+	Endpoint_SelectEndpoint(prev_endpoint);
+}
+
+/**
+ * Empties both rings and enables the OUT endpoint transaction complete and
+ * the Start of Frame interrupts. Call each time the MIDI endpoints are
+ * configured.
+ */
+
+void usb_midi_init(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	
+	rx_head = rx_tail = 0;
+	tx_head = tx_tail = 0;
+	in_busy = false;
+	tx_stalled = false;
+	usb_frame_count = 0;
+	memset(&usb_midi_stats, 0x00, sizeof(usb_midi_stats));
+	
+	uint8_t prev_endpoint = Endpoint_GetCurrentEndpoint();
+	Endpoint_SelectEndpoint(MIDI_STREAM_OUT_EPADDR);
+	USB_Endpoint_SelectedHandle->CTRL &= ~USB_EP_INTDSBL_bm;
+	Endpoint_SelectEndpoint(prev_endpoint);
+	
+	// Both run at the bus event interrupt level set by LUFA
+	USB.INTFLAGSBCLR = USB_TRNIF_bm;
+	USB.INTCTRLB |= USB_TRNIE_bm;
+	USB_Device_EnableSOFEvents();
+	
+	usb_midi_ready = true;
+	
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Queues a packet for the host, safe to call from interrupts. It is sent 
+ * at the next Start of Frame. If the ring is full this waits up to 
+ * USB_MIDI_TX_TIMEOUT_MS for the host to make room, handling the Start of
+ * Frame itself in case interrupts are masked.
+ *
+ * \param event [in]	The packet to send
+ *
+ * \return	true if the packet was queued
+ */
+
+bool usb_midi_send(const MIDI_EventPacket_t* event)
+{
+	uint16_t wait_us = 0;
+	
+	while (true) {
+		irqflags_t flags = cpu_irq_save();
+		
+		if ((uint8_t)(tx_head - tx_tail) < USB_MIDI_TX_RING_SIZE) {
+			tx_ring[tx_head & TX_RING_MASK] = *event;
+			tx_head++;
+			
+			uint8_t used = tx_head - tx_tail;
+			if (used > usb_midi_stats.tx_max_used) {
+				usb_midi_stats.tx_max_used = used;
+			}
+			
+			cpu_irq_restore(flags);
+			return true;
+		}
+		
+		if (USB.INTFLAGSACLR & USB_SOFIF_bm) {
+			USB.INTFLAGSACLR = USB_SOFIF_bm;
+			usb_midi_start_of_frame();
+		}
+		
+		if (wait_us >= USB_MIDI_TX_TIMEOUT_MS * 1000) {
+			tx_stalled = true;
+		}
+		
+		if (tx_stalled || !usb_midi_ready || 
+		    USB_DeviceState != DEVICE_STATE_Configured) {
+			if (usb_midi_stats.tx_dropped < 0xFFFF) {
+				usb_midi_stats.tx_dropped++;
+			}
+			cpu_irq_restore(flags);
+			return false;
+		}
+		
+		cpu_irq_restore(flags);
+		
+		_delay_us(10);
+		wait_us += 10;
+	}
+}
+
+/**
+ * Takes the oldest received packet from the ring.
+ *
+ * \param event [out]	The received packet
+ *
+ * \return	true if a packet was returned, false if the ring is empty
+ */
+
+bool usb_midi_receive(MIDI_EventPacket_t* event)
+{
+	irqflags_t flags = cpu_irq_save();
+	
+	if (rx_head == rx_tail) {
+		// A packet may have been held in the endpoint while the ring was 
+		// full, there is room for it now
+		service_rx();
+		
+		if (rx_head == rx_tail) {
+			cpu_irq_restore(flags);
+			return false;
+		}
+	}
+	
+	*event = rx_ring[rx_tail & RX_RING_MASK];
+	rx_tail++;
+	
+	cpu_irq_restore(flags);
+	
+	return true;
+}
+
+/**
+ * Returns true if received packets are waiting in the ring.
+ */
+
+bool usb_midi_rx_pending(void)
+{
+	return rx_head != rx_tail;
+}
+
+/**
+ * Returns the number of USB frames since the device was configured, one
+ * per mS. Wraps at 0xFFFF.
+ */
+
+uint16_t get_usb_frame_count(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t frame = usb_frame_count;
+	cpu_irq_restore(flags);
+	return frame;
+}
+
+void get_usb_midi_stats(usb_midi_stats_t* stats)
+{
+	irqflags_t flags = cpu_irq_save();
+	memcpy(stats, &usb_midi_stats, sizeof(usb_midi_stats_t));
+	cpu_irq_restore(flags);
+}
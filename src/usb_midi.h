@@ -0,0 +1,63 @@
+/*
+ * usb_midi.h
+ *
+ * Created: 10/18/2026 7:41:05 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef USB_MIDI_H_
+#define USB_MIDI_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		#include <LUFA/Drivers/USB/USB.h>
+		#include <Descriptors.h>
+		
+	/*	Macros: */
+	
+		// Ring sizes in MIDI event packets, must be powers of 2
+		#define USB_MIDI_RX_RING_SIZE		32
+		#define USB_MIDI_TX_RING_SIZE		32
+		
+		// How long a send waits for space in a full transmit ring before
+		// the packet is dropped. Once a send has timed out further packets
+		// are dropped straight away until the host reads the endpoint again.
+		#define USB_MIDI_TX_TIMEOUT_MS		10
+
+	/*	Types: */
+	
+		typedef struct {
+			uint16_t rx_packets;		// Packets received from the host
+			uint16_t tx_packets;		// Packets sent to the host
+			uint16_t tx_dropped;		// Packets dropped on a full ring
+			uint8_t  rx_max_used;		// Highest receive ring fill level
+			uint8_t  tx_max_used;		// Highest transmit ring fill level
+		} usb_midi_stats_t;
+
+	/* Function Prototypes: */
+	
+		void usb_midi_init(void);
+		bool usb_midi_send(const MIDI_EventPacket_t* event);
+		bool usb_midi_receive(MIDI_EventPacket_t* event);
+		bool usb_midi_rx_pending(void);
+		bool usb_midi_configured(void);
+		void usb_midi_start_of_frame(void);
+		uint16_t get_usb_frame_count(void);
+		void get_usb_midi_stats(usb_midi_stats_t* stats);
+
+#endif /* USB_MIDI_H_ */
@@ -0,0 +1,149 @@
+/*
+ * watchdog.c
+ *
+ * Created: 10/18/2026 6:58:21 PM
+ *
+ *  Feeds the hardware watchdog only while every subsystem shows signs of
+ *  life. The input scan and display frame interrupts, the USB MIDI IN
+ *  endpoint and the main loop each set a heartbeat bit and the main loop 
+ *  resets the watchdog once all bits are set, so a stalled interrupt 
+ *  source or endpoint resets the unit even though the main loop still 
+ *  spins. The endpoint only counts while the device is configured, 
+ *  unplugged or on legacy MIDI it has nothing to show.
+ *
+ *  The heartbeats and uptime are kept in uninitialized RAM, after a reset
+ *  the record from before it is saved and can be read over SysEx to see 
+ *  which subsystem stopped.
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <watchdog.h>
+#include <input.h>
+#include <usb_midi.h>
+
+#include <string.h>
+
+// This attribute ensures the record is not initialized on reset
+static reset_record_t reset_record ATTR_NO_INIT;
+
+// The record and reset cause from before the last reset
+static reset_record_t last_record;
+static uint8_t last_reset_cause;
+
+/**
+ * Saves the record left by the previous run and starts a new one. Must be
+ * called at the start of main() before the watchdog is enabled.
+ */
+
+void watchdog_init(void)
+{
+	last_reset_cause = reset_cause_get_causes();
+	reset_cause_clear_causes(last_reset_cause);
+	
+	// RAM content is undefined after power on
+	if (reset_record.magic == RESET_RECORD_MAGIC && 
+	   !(last_reset_cause & CHIP_RESET_CAUSE_POR)) {
+		memcpy(&last_record, &reset_record, sizeof(reset_record_t));
+	} else {
+		memset(&last_record, 0x00, sizeof(reset_record_t));
+		reset_record.watchdog_resets = 0;
+	}
+	
+	if ((last_reset_cause & CHIP_RESET_CAUSE_WDT) && !last_record.requested &&
+		reset_record.watchdog_resets < 0xFFFF) {
+		reset_record.watchdog_resets++;
+	}
+	
+	reset_record.magic = RESET_RECORD_MAGIC;
+	reset_record.heartbeats = 0;
+	reset_record.requested = false;
+	reset_record.uptime_ms = 0;
+}
+
+/**
+ * Marks subsystems as alive, safe to call from interrupts.
+ *
+ * \param beats [in]	HEARTBEAT_ bits to set
+ */
+
+void heartbeat(uint8_t beats)
+{
+	irqflags_t flags = cpu_irq_save();
+	reset_record.heartbeats |= beats;
+	cpu_irq_restore(flags);
+}
+
+/**
+ * Resets the watchdog if every heartbeat has been seen since it was last
+ * reset. Called once per pass of the main loop.
+ */
+
+void watchdog_service(void)
+{
+	uint8_t needed = HEARTBEAT_ALL;
+	if (!usb_midi_configured()) {
+		needed &= ~HEARTBEAT_MIDI;
+	}
+	
+	if ((reset_record.heartbeats & needed) != needed) {
+		return;
+	}
+	
+	wdt_reset();
+	
+	irqflags_t flags = cpu_irq_save();
+	reset_record.heartbeats = 0;
+	cpu_irq_restore(flags);
+	
+	reset_record.uptime_ms = get_ms_timer();
+}
+
+/**
+ * Resets the unit through the watchdog, the reset is recorded as requested
+ * so it is not counted as a failure.
+ */
+
+void watchdog_force_reset(void)
+{
+	reset_record.requested = true;
+	
+	// Shortest watchdog period, waits here for the reset
+	wdt_reset_mcu();
+}
+
+/**
+ * Returns the XMEGA RST.STATUS flags read at start up.
+ */
+
+uint8_t get_last_reset_cause(void)
+{
+	return last_reset_cause;
+}
+
+/**
+ * Copies the record left by the previous run, all zero after power on.
+ */
+
+void get_last_reset_record(reset_record_t* rec)
+{
+	memcpy(rec, &last_record, sizeof(reset_record_t));
+}
+
+uint16_t get_watchdog_reset_count(void)
+{
+	return reset_record.watchdog_resets;
+}
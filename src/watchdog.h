@@ -0,0 +1,66 @@
+/*
+ * watchdog.h
+ *
+ * Created: 10/18/2026 6:58:21 PM
+ *
+ * DJTT - MIDI Fighter Twister - Embedded Software License
+ * Copyright (c) 2016: DJ Tech Tools
+ * Permission is hereby granted, free of charge, to any person owning or possessing 
+ * a DJ Tech-Tools MIDI Fighter Twister Hardware Device to view and modify this source 
+ * code for personal use. Person may not publish, distribute, sublicense, or sell 
+ * the source code (modified or un-modified). Person may not use this source code 
+ * or any diminutive works for commercial purposes. The permission to use this source 
+ * code is also subject to the following conditions:
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,  FITNESS FOR A 
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT 
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION 
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+	/*	Includes: */
+	
+		#include <asf.h>
+		#include <LUFA/Common/Common.h>
+		
+	/*	Macros: */
+	
+		// Subsystem heartbeats, the watchdog is only fed once all of them
+		// have been seen since it was last fed. The MIDI heartbeat is only
+		// needed while the host has the device configured
+		#define HEARTBEAT_INPUT			0x01	// Input scan interrupt ran
+		#define HEARTBEAT_DISPLAY		0x02	// Display frame interrupt ran
+		#define HEARTBEAT_MIDI			0x04	// Start of Frame serviced the USB MIDI endpoints
+		#define HEARTBEAT_SCHEDULER		0x08	// Main loop completed a pass
+		#define HEARTBEAT_ALL			0x0F
+		
+		#define RESET_RECORD_MAGIC		0xB17E
+
+	/*	Types: */
+	
+		// Kept in uninitialized RAM so the state before a watchdog reset
+		// can be read back after it
+		typedef struct {
+			uint16_t magic;
+			uint16_t watchdog_resets;	// Unrequested watchdog resets since power on
+			uint8_t  heartbeats;		// Seen since the watchdog was last fed
+			bool     requested;			// Reset forced by watchdog_force_reset()
+			uint32_t uptime_ms;			// When the watchdog was last fed
+		} reset_record_t;
+
+	/* Function Prototypes: */
+	
+		void watchdog_init(void);
+		void heartbeat(uint8_t beats);
+		void watchdog_service(void);
+		void watchdog_force_reset(void) ATTR_NO_RETURN;
+		
+		uint8_t get_last_reset_cause(void);
+		void get_last_reset_record(reset_record_t* rec);
+		uint16_t get_watchdog_reset_count(void);
+
+#endif /* WATCHDOG_H_ */